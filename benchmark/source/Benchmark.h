@@ -0,0 +1,74 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace Benchmark {
+
+struct Options {
+  bool quick = false;  // Fewer iterations and a smaller sweep, for CI.
+  bool full = false;   // Full cartesian engine sweep instead of one axis at a
+                       // time around the baseline.
+  std::string filter;  // Only run benchmarks whose name contains this.
+  bool perf = false;   // Count hardware events per engine stage (Linux).
+
+  bool matches(const std::string& name) const {
+    return filter.empty() || name.find(filter) != std::string::npos;
+  }
+};
+
+/** Keeps the optimiser from discarding a value computed by a benchmark. */
+template <typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static const void* volatile sink;
+  sink = &value;
+#endif
+}
+
+/** Runs fn repetitions times and returns the median wall time in ns. */
+template <typename Fn>
+double medianNanoseconds(int repetitions, Fn&& fn) {
+  std::vector<double> times;
+  times.reserve(static_cast<size_t>(repetitions));
+  for (int i = 0; i < repetitions; ++i) {
+    const auto start = std::chrono::steady_clock::now();
+    fn();
+    const auto end = std::chrono::steady_clock::now();
+    times.push_back(
+        std::chrono::duration<double, std::nano>(end - start).count());
+  }
+  std::nth_element(times.begin(), times.begin() + repetitions / 2,
+                   times.end());
+  return times[static_cast<size_t>(repetitions / 2)];
+}
+
+/** Nearest-rank percentile (0-100) of values, which is reordered. */
+template <typename T>
+T percentile(std::vector<T>& values, double percent) {
+  if (values.empty())
+    return T{};
+  const auto rank = static_cast<size_t>(
+      std::clamp(percent / 100.0, 0.0, 1.0) *
+      static_cast<double>(values.size() - 1));
+  std::nth_element(values.begin(), values.begin() + static_cast<long>(rank),
+                   values.end());
+  return values[rank];
+}
+
+/** Per-call cost of the engine's building blocks. */
+nlohmann::json runMicrobenchmarks(const Options& options);
+
+/** AudioEngine::processBlock over a sweep of load and configuration. */
+nlohmann::json runEngineBenchmarks(const Options& options);
+
+/** Checks the product requirement of 128 grains under 15% of one core. */
+nlohmann::json checkRequirement(const Options& options);
+
+}  // namespace Benchmark
@@ -0,0 +1,325 @@
+#include "Benchmark.h"
+
+#include "Pointilsynth/PointilismInterfaces.h"
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace Benchmark {
+namespace {
+// Grains last about this long, or longer where the pool is too large to fill
+// at one onset per sample.
+constexpr double kTargetGrainDurationMs = 50.0;
+constexpr int kRepetitions = 3;
+// How far the measured pool may stray from the requested grain count.
+constexpr double kGrainCountTolerance = 0.03;
+
+enum class SourceKind { Sine, Saw, Square, Noise, AudioSample };
+
+struct EngineConfig {
+  int grains = 128;
+  SourceKind source = SourceKind::Sine;
+  GrainEnvelope::Shape shape = GrainEnvelope::Shape::Trapezoid;
+  int blockSize = 512;
+  double sampleRate = 48000.0;
+};
+
+const char* getName(SourceKind source) {
+  switch (source) {
+    case SourceKind::Sine:
+      return "Sine";
+    case SourceKind::Saw:
+      return "Saw";
+    case SourceKind::Square:
+      return "Square";
+    case SourceKind::Noise:
+      return "Noise";
+    case SourceKind::AudioSample:
+      return "AudioSample";
+  }
+  return "Unknown";
+}
+
+const char* getName(GrainEnvelope::Shape shape) {
+  return shape == GrainEnvelope::Shape::Hann ? "Hann" : "Trapezoid";
+}
+
+std::string getName(const EngineConfig& config) {
+  return "AudioEngine::processBlock/" + std::to_string(config.grains) + "/" +
+         getName(config.source) + "/" + getName(config.shape) + "/" +
+         std::to_string(config.blockSize) + "/" +
+         std::to_string(static_cast<int>(config.sampleRate));
+}
+
+/**
+ * A grain starts every onsetInterval samples and lasts grains times as long,
+ * so the pool holds config.grains grains once it is full. The model
+ * truncates both the onset interval and the duration to whole samples, so
+ * each is set half a sample above the count it should truncate to.
+ */
+struct GrainTiming {
+  int onsetInterval = 1;
+  float density = 0.0f;
+  float durationMs = 0.0f;
+};
+
+GrainTiming getGrainTiming(const EngineConfig& config) {
+  GrainTiming timing;
+  timing.onsetInterval =
+      std::max(1, static_cast<int>(config.sampleRate * kTargetGrainDurationMs /
+                                   1000.0 / config.grains));
+  timing.density = static_cast<float>(config.sampleRate /
+                                      (timing.onsetInterval + 0.5));
+  timing.durationMs = static_cast<float>(
+      (static_cast<double>(config.grains) * timing.onsetInterval + 0.5) *
+      1000.0 / config.sampleRate);
+  return timing;
+}
+
+/**
+ * Finished grains stay in the pool until the end of the host block, so a
+ * full pool also holds up to one block's worth of them. Beyond kMaxGrains
+ * onsets are skipped and the pool never reaches config.grains.
+ */
+bool fitsInPool(const EngineConfig& config) {
+  const int onsetInterval = getGrainTiming(config).onsetInterval;
+  const int finishedPerBlock =
+      (config.blockSize + onsetInterval - 1) / onsetInterval;
+  return config.grains + finishedPerBlock <= AudioEngine::kMaxGrains;
+}
+
+void configure(AudioEngine& engine, const EngineConfig& config) {
+  auto* model = engine.getStochasticModel();
+  const auto timing = getGrainTiming(config);
+  model->setGlobalTemporalDistribution(
+      StochasticModel::TemporalDistribution::Uniform);
+  model->setDurationAndVariation(timing.durationMs, 0.0f);
+  model->setGlobalDensity(timing.density);
+  model->setPitchAndDispersion(60.0f, 12.0f);
+  model->setPanAndSpread(0.0f, 0.5f);
+
+  if (config.source == SourceKind::AudioSample) {
+    juce::AudioBuffer<float> sample(1, static_cast<int>(config.sampleRate));
+    juce::Random random(1234);
+    for (int i = 0; i < sample.getNumSamples(); ++i)
+      sample.setSample(0, i, random.nextFloat() * 2.0f - 1.0f);
+    engine.setSourceAudio(sample);
+    engine.setSourceType(AudioEngine::GrainSourceType::AudioSample);
+  } else {
+    engine.setGrainSource(static_cast<int>(config.source));
+  }
+  engine.setEnvelopeShape(config.shape);
+  engine.prepareToPlay(config.sampleRate, config.blockSize);
+}
+
+// Mean hardware counts per block for each engine stage, plus derived ratios.
+nlohmann::json summarisePerf(
+    const RenderTelemetry& telemetry,
+    const std::vector<RenderTelemetry::BlockStats>& blocks,
+    double grainSamplesPerBlock) {
+  const auto summary = RenderTelemetry::summarise(blocks);
+  if (telemetry.getPerfState() != RenderTelemetry::PerfState::Counting ||
+      summary.numPerfBlocks == 0)
+    return {{"counting", false}};
+
+  nlohmann::json stages;
+  for (int stage = 0; stage < RenderTelemetry::kNumStages; ++stage) {
+    nlohmann::json counts;
+    for (int counter = 0; counter < PerfCounters::kNumCounters; ++counter)
+      counts[PerfCounters::getName(counter)] =
+          summary.perfPerBlock[static_cast<size_t>(stage)]
+                              [static_cast<size_t>(counter)];
+    stages[RenderTelemetry::getStageName(stage)] = counts;
+  }
+  const double cycles = summary.getPerfTotal(PerfCounters::kCycles);
+  const double instructions = summary.getPerfTotal(PerfCounters::kInstructions);
+  return {{"counting", true},
+          {"blocks", summary.numPerfBlocks},
+          {"perBlock", stages},
+          {"instructionsPerCycle", cycles > 0.0 ? instructions / cycles : 0.0},
+          {"cyclesPerGrainSample",
+           grainSamplesPerBlock > 0.0 ? cycles / grainSamplesPerBlock : 0.0}};
+}
+
+nlohmann::json runEngine(const EngineConfig& config, const Options& options) {
+  AudioEngine engine;
+  configure(engine, config);
+
+  // The counters follow the thread that opens them, which is this one: the
+  // engine opens them in its first processBlock() after the request.
+  RenderTelemetry telemetry;
+  std::vector<RenderTelemetry::BlockStats> perfBlocks;
+  if (options.perf) {
+    telemetry.setPerfCountersRequested(true);
+    engine.setTelemetry(&telemetry);
+  }
+
+  juce::AudioBuffer<float> buffer(2, config.blockSize);
+  juce::MidiBuffer midi;
+  juce::AudioPlayHead::PositionInfo position;
+  const double blockSeconds = config.blockSize / config.sampleRate;
+  auto blocksFor = [blockSeconds](double seconds) {
+    return std::max(1, static_cast<int>(seconds / blockSeconds));
+  };
+
+  // Run for a few grain lifetimes so the pool reaches its steady state.
+  const double warmUpSeconds =
+      4.0 * static_cast<double>(getGrainTiming(config).durationMs) / 1000.0;
+  for (int block = blocksFor(warmUpSeconds); block > 0; --block)
+    engine.processBlock(buffer, midi, position);
+
+  const int numBlocks = blocksFor(options.quick ? 0.25 : 1.0);
+  const auto maxPerfBlocks = static_cast<size_t>(numBlocks * kRepetitions);
+  if (options.perf) {
+    telemetry.drain(perfBlocks, 0);  // Discard the warm-up.
+    perfBlocks.reserve(maxPerfBlocks);
+  }
+  double grainSamples = 0.0;
+  double worstBlockNs = 0.0;
+  const double nanoseconds = medianNanoseconds(kRepetitions, [&] {
+    grainSamples = 0.0;
+    for (int block = 0; block < numBlocks; ++block) {
+      const auto start = std::chrono::steady_clock::now();
+      engine.processBlock(buffer, midi, position);
+      const auto end = std::chrono::steady_clock::now();
+      worstBlockNs = std::max(
+          worstBlockNs,
+          std::chrono::duration<double, std::nano>(end - start).count());
+      grainSamples += static_cast<double>(engine.getNumActiveGrains()) *
+                      config.blockSize;
+      if (options.perf)
+        telemetry.drain(perfBlocks, maxPerfBlocks);
+    }
+  });
+  doNotOptimize(buffer.getSample(0, 0));
+
+  const double audioNanoseconds = numBlocks * blockSeconds * 1.0e9;
+  const double averageGrains =
+      grainSamples / (static_cast<double>(numBlocks) * config.blockSize);
+  const bool isGrainCountOnTarget =
+      std::abs(averageGrains - config.grains) <=
+      std::max(1.0, kGrainCountTolerance * config.grains);
+  nlohmann::json result = {
+      {"name", getName(config)},
+      {"grains", config.grains},
+      {"averageActiveGrains", averageGrains},
+      {"grainCountOnTarget", isGrainCountOnTarget},
+      {"source", getName(config.source)},
+      {"envelope", getName(config.shape)},
+      {"blockSize", config.blockSize},
+      {"sampleRate", config.sampleRate},
+      {"nsPerSample",
+       nanoseconds / (static_cast<double>(numBlocks) * config.blockSize)},
+      {"nsPerGrainSample",
+       grainSamples > 0.0 ? nanoseconds / grainSamples : 0.0},
+      {"realtimePercent", 100.0 * nanoseconds / audioNanoseconds},
+      {"worstBlockRealtimePercent",
+       100.0 * worstBlockNs / (blockSeconds * 1.0e9)}};
+  if (options.perf)
+    result["perf"] = summarisePerf(telemetry, perfBlocks,
+                                   grainSamples / numBlocks);
+  return result;
+}
+
+std::vector<EngineConfig> makeSweep(const Options& options) {
+  std::vector<int> grainCounts = {16, 64, 128, 256, 512, 1024, 2048, 3072};
+  std::vector<SourceKind> sources = {SourceKind::Sine, SourceKind::Saw,
+                                     SourceKind::Square, SourceKind::Noise,
+                                     SourceKind::AudioSample};
+  std::vector<GrainEnvelope::Shape> shapes = {GrainEnvelope::Shape::Trapezoid,
+                                              GrainEnvelope::Shape::Hann};
+  std::vector<int> blockSizes = {32, 64, 128, 256, 512, 1024, 2048};
+  std::vector<double> sampleRates = {44100.0, 48000.0, 96000.0};
+  if (options.quick) {
+    grainCounts = {16, 128, 1024};
+    blockSizes = {64, 512};
+    sampleRates = {48000.0};
+  }
+
+  const EngineConfig baseline;
+  std::vector<EngineConfig> sweep;
+  if (options.full) {
+    for (int grains : grainCounts)
+      for (auto source : sources)
+        for (auto shape : shapes)
+          for (int blockSize : blockSizes)
+            for (double sampleRate : sampleRates)
+              sweep.push_back({grains, source, shape, blockSize, sampleRate});
+    sweep.erase(std::remove_if(sweep.begin(), sweep.end(),
+                               [](const EngineConfig& config) {
+                                 return !fitsInPool(config);
+                               }),
+                sweep.end());
+    return sweep;
+  }
+
+  // One axis at a time around the baseline.
+  for (int grains : grainCounts) {
+    auto config = baseline;
+    config.grains = grains;
+    sweep.push_back(config);
+  }
+  for (auto source : sources) {
+    for (auto shape : shapes) {
+      auto config = baseline;
+      config.source = source;
+      config.shape = shape;
+      sweep.push_back(config);
+    }
+  }
+  for (int blockSize : blockSizes) {
+    auto config = baseline;
+    config.blockSize = blockSize;
+    sweep.push_back(config);
+  }
+  for (double sampleRate : sampleRates) {
+    auto config = baseline;
+    config.sampleRate = sampleRate;
+    sweep.push_back(config);
+  }
+
+  // The axes all pass through the baseline; keep one copy of each config.
+  std::vector<EngineConfig> unique;
+  for (const auto& config : sweep) {
+    const auto name = getName(config);
+    if (std::none_of(unique.begin(), unique.end(), [&](const auto& other) {
+          return getName(other) == name;
+        }))
+      unique.push_back(config);
+  }
+  return unique;
+}
+}  // namespace
+
+nlohmann::json runEngineBenchmarks(const Options& options) {
+  auto results = nlohmann::json::array();
+  for (const auto& config : makeSweep(options)) {
+    const auto name = getName(config);
+    if (!options.matches(name))
+      continue;
+    std::cerr << name << std::endl;
+    results.push_back(runEngine(config, options));
+    if (!results.back()["grainCountOnTarget"].get<bool>())
+      std::cerr << "  averaged "
+                << results.back()["averageActiveGrains"].get<double>()
+                << " live grains, not " << config.grains << std::endl;
+  }
+  return results;
+}
+
+nlohmann::json checkRequirement(const Options& options) {
+  constexpr double kBudgetPercent = 15.0;
+  const EngineConfig config;  // 128 grains, the "typical load".
+  const auto result = runEngine(config, options);
+  const double measured = result["realtimePercent"].get<double>();
+  return {{"description", "128 grains under 15% of one core"},
+          {"benchmark", result["name"]},
+          {"budgetPercent", kBudgetPercent},
+          {"measuredPercent", measured},
+          {"pass", measured < kBudgetPercent}};
+}
+
+}  // namespace Benchmark
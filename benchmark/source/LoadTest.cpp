@@ -0,0 +1,354 @@
+/**
+ * Headless multi-instance load test.
+ *
+ * Models a host running several instances of the plugin: N processors are
+ * split round-robin across M simulated audio threads. Each thread wakes once
+ * per buffer period, feeds its instances MIDI and parameter automation and
+ * renders them one after another, as a host's audio callback does. The
+ * message thread keeps running meanwhile, so APVTS timers and listeners
+ * compete with the audio threads as they would in a real host.
+ *
+ * The JSON report has per-instance render-time percentiles and deadline
+ * misses, per-thread callback overruns and the process's peak memory.
+ */
+#include "Benchmark.h"
+
+#include "Pointilsynth/ConfigManager.h"
+#include "Pointilsynth/PluginProcessor.h"
+
+#include <juce_gui_basics/juce_gui_basics.h>
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <thread>
+
+#if JUCE_LINUX || JUCE_MAC
+#include <sys/resource.h>
+#endif
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct LoadTestOptions {
+  int numInstances = 8;
+  int numThreads = 4;
+  double seconds = 10.0;
+  int blockSize = 256;
+  double sampleRate = 48000.0;
+  bool pace = true;  // Wait out each buffer period; false renders flat out.
+  std::string outputPath;
+};
+
+/** One plugin instance and the host-side state that drives it. */
+struct Instance {
+  explicit Instance(int index) : random(index + 1) {}
+
+  std::unique_ptr<audio_plugin::AudioPluginAudioProcessor> processor;
+  juce::AudioBuffer<float> buffer;
+  juce::MidiBuffer midi;
+  juce::Random random;
+  std::vector<juce::RangedAudioParameter*> automated;
+  int heldNote = -1;
+  double automationPhase = 0.0;
+
+  std::vector<double> renderMicroseconds;  // One entry per block.
+  int deadlineMisses = 0;
+};
+
+/** Roughly one note event per 100 ms and a slow sweep on each automated
+ * parameter, written the way host automation arrives: on the audio thread,
+ * just before the block. */
+void feedInput(Instance& instance, const LoadTestOptions& options) {
+  instance.midi.clear();
+  const double blocksPerSecond = options.sampleRate / options.blockSize;
+  if (instance.random.nextDouble() < 10.0 / blocksPerSecond) {
+    const int offset = instance.random.nextInt(options.blockSize);
+    if (instance.heldNote >= 0) {
+      instance.midi.addEvent(
+          juce::MidiMessage::noteOff(1, instance.heldNote), offset);
+      instance.heldNote = -1;
+    } else {
+      instance.heldNote = 36 + instance.random.nextInt(48);
+      instance.midi.addEvent(
+          juce::MidiMessage::noteOn(1, instance.heldNote,
+                                    instance.random.nextFloat()),
+          offset);
+    }
+  }
+
+  instance.automationPhase += 0.25 / blocksPerSecond;  // 0.25 Hz sweep
+  for (size_t i = 0; i < instance.automated.size(); ++i) {
+    const double phase =
+        instance.automationPhase + 0.3 * static_cast<double>(i);
+    const auto value = static_cast<float>(
+        0.5 + 0.4 * std::sin(juce::MathConstants<double>::twoPi * phase));
+    instance.automated[i]->setValueNotifyingHost(value);
+  }
+}
+
+/** A simulated host audio thread rendering a fixed set of instances. */
+class HostThread : public juce::Thread {
+public:
+  HostThread(int index,
+             std::vector<Instance*> instances,
+             const LoadTestOptions& options)
+      : juce::Thread("Host audio thread " + juce::String(index)),
+        instances_(std::move(instances)),
+        options_(options) {}
+
+  int getNumCallbacks() const { return numCallbacks_; }
+  int getNumOverruns() const { return numOverruns_; }
+  double getWorstCallbackMicroseconds() const { return worstCallback_; }
+
+private:
+  void run() override {
+    const auto period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(options_.blockSize /
+                                      options_.sampleRate));
+    const int numBlocks = static_cast<int>(options_.seconds *
+                                           options_.sampleRate /
+                                           options_.blockSize);
+    auto deadline = Clock::now() + period;
+
+    for (int block = 0; block < numBlocks && !threadShouldExit(); ++block) {
+      const auto callbackStart = Clock::now();
+      for (auto* instance : instances_) {
+        feedInput(*instance, options_);
+        const auto start = Clock::now();
+        instance->processor->processBlock(instance->buffer, instance->midi);
+        const auto end = Clock::now();
+        instance->renderMicroseconds.push_back(
+            std::chrono::duration<double, std::micro>(end - start).count());
+        if (end > deadline)
+          ++instance->deadlineMisses;
+      }
+      const auto callbackEnd = Clock::now();
+      worstCallback_ = std::max(
+          worstCallback_, std::chrono::duration<double, std::micro>(
+                              callbackEnd - callbackStart)
+                              .count());
+      ++numCallbacks_;
+      if (callbackEnd > deadline)
+        ++numOverruns_;
+
+      // A host that overruns starts the next callback immediately; it does
+      // not get the lost time back.
+      if (options_.pace)
+        std::this_thread::sleep_until(deadline);
+      const auto now = Clock::now();
+      deadline = now > deadline ? now + period : deadline + period;
+    }
+  }
+
+  std::vector<Instance*> instances_;
+  const LoadTestOptions& options_;
+  int numCallbacks_ = 0;
+  int numOverruns_ = 0;
+  double worstCallback_ = 0.0;
+};
+
+/** Peak resident set size of this process in bytes, or -1 if unknown. */
+juce::int64 getPeakMemoryBytes() {
+#if JUCE_LINUX || JUCE_MAC
+  rusage usage{};
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return -1;
+#if JUCE_MAC
+  return static_cast<juce::int64>(usage.ru_maxrss);  // bytes
+#else
+  return static_cast<juce::int64>(usage.ru_maxrss) * 1024;  // kilobytes
+#endif
+#else
+  return -1;
+#endif
+}
+
+nlohmann::json summarise(std::vector<double> times) {
+  return {{"p50", Benchmark::percentile(times, 50.0)},
+          {"p90", Benchmark::percentile(times, 90.0)},
+          {"p99", Benchmark::percentile(times, 99.0)},
+          {"p999", Benchmark::percentile(times, 99.9)},
+          {"max", Benchmark::percentile(times, 100.0)}};
+}
+
+void printUsage() {
+  std::cerr << "Usage: PointilSynthLoadTest [options]\n"
+               "  --instances <n>    Plugin instances (default 8)\n"
+               "  --threads <n>      Simulated audio threads (default 4)\n"
+               "  --seconds <s>      Length of the run (default 10)\n"
+               "  --block-size <n>   Host buffer size (default 256)\n"
+               "  --sample-rate <hz> Sample rate (default 48000)\n"
+               "  --no-pacing        Render as fast as possible\n"
+               "  --output <file>    Write the JSON report to file\n";
+}
+
+bool parseArguments(int argc, char* argv[], LoadTestOptions& options) {
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+    if (arg == "--instances" && hasValue)
+      options.numInstances = std::max(1, std::atoi(argv[++i]));
+    else if (arg == "--threads" && hasValue)
+      options.numThreads = std::max(1, std::atoi(argv[++i]));
+    else if (arg == "--seconds" && hasValue)
+      options.seconds = std::max(0.1, std::atof(argv[++i]));
+    else if (arg == "--block-size" && hasValue)
+      options.blockSize = std::max(1, std::atoi(argv[++i]));
+    else if (arg == "--sample-rate" && hasValue)
+      options.sampleRate = std::max(1000.0, std::atof(argv[++i]));
+    else if (arg == "--no-pacing")
+      options.pace = false;
+    else if (arg == "--output" && hasValue)
+      options.outputPath = argv[++i];
+    else
+      return false;
+  }
+  return true;
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  LoadTestOptions options;
+  if (!parseArguments(argc, argv, options)) {
+    printUsage();
+    return 1;
+  }
+
+  juce::ScopedJuceInitialiser_GUI libraryInitialiser;
+  const auto memoryBefore = getPeakMemoryBytes();
+
+  const int blocksPerThread =
+      static_cast<int>(options.seconds * options.sampleRate /
+                       options.blockSize) + 1;
+  std::vector<std::unique_ptr<Instance>> instances;
+  std::set<ConfigManager*> configManagers;
+  for (int i = 0; i < options.numInstances; ++i) {
+    auto instance = std::make_unique<Instance>(i);
+    instance->processor =
+        std::make_unique<audio_plugin::AudioPluginAudioProcessor>();
+    instance->processor->setRateAndBufferSizeDetails(options.sampleRate,
+                                                     options.blockSize);
+    instance->processor->prepareToPlay(options.sampleRate, options.blockSize);
+    instance->buffer.setSize(2, options.blockSize);
+    instance->midi.ensureSize(256);
+    instance->renderMicroseconds.reserve(static_cast<size_t>(blocksPerThread));
+
+    auto config = instance->processor->getConfigManager();
+    configManagers.insert(config.get());
+    auto& apvts = config->getAPVTS();
+    for (const char* id : {ConfigManager::ParamID::density,
+                           ConfigManager::ParamID::pitch,
+                           ConfigManager::ParamID::pan}) {
+      if (auto* param = apvts.getParameter(id))
+        instance->automated.push_back(param);
+    }
+    instances.push_back(std::move(instance));
+  }
+  const auto memoryAfterSetup = getPeakMemoryBytes();
+
+  std::vector<std::unique_ptr<HostThread>> threads;
+  for (int t = 0; t < options.numThreads; ++t) {
+    std::vector<Instance*> assigned;
+    for (int i = t; i < options.numInstances; i += options.numThreads)
+      assigned.push_back(instances[static_cast<size_t>(i)].get());
+    if (!assigned.empty())
+      threads.push_back(
+          std::make_unique<HostThread>(t, std::move(assigned), options));
+  }
+
+  std::cerr << "Running " << options.numInstances << " instances on "
+            << threads.size() << " threads for " << options.seconds << " s"
+            << std::endl;
+  const double periodMs = 1000.0 * options.blockSize / options.sampleRate;
+  for (auto& thread : threads) {
+    if (!thread->startRealtimeThread(
+            juce::Thread::RealtimeOptions{}.withPeriodMs(periodMs)))
+      thread->startThread(juce::Thread::Priority::highest);
+  }
+
+  // Keep the message thread busy with the APVTS timers while the host
+  // threads run.
+  const auto timeoutMs =
+      static_cast<int>(options.seconds * 1000.0 * 2.0) + 10000;
+  const auto startTime = juce::Time::getMillisecondCounter();
+  while (std::any_of(threads.begin(), threads.end(),
+                     [](const auto& thread) {
+                       return thread->isThreadRunning();
+                     })) {
+    juce::MessageManager::getInstance()->runDispatchLoopUntil(20);
+    if (juce::Time::getMillisecondCounter() - startTime >
+        static_cast<juce::uint32>(timeoutMs)) {
+      std::cerr << "Timed out waiting for host threads" << std::endl;
+      for (auto& thread : threads)
+        thread->stopThread(1000);
+    }
+  }
+
+  nlohmann::json report;
+  report["options"] = {{"instances", options.numInstances},
+                       {"threads", options.numThreads},
+                       {"seconds", options.seconds},
+                       {"blockSize", options.blockSize},
+                       {"sampleRate", options.sampleRate},
+                       {"paced", options.pace}};
+  report["budgetMicroseconds"] =
+      1.0e6 * options.blockSize / options.sampleRate;
+
+  std::vector<double> allTimes;
+  int totalMisses = 0;
+  auto perInstance = nlohmann::json::array();
+  for (size_t i = 0; i < instances.size(); ++i) {
+    const auto& instance = *instances[i];
+    allTimes.insert(allTimes.end(), instance.renderMicroseconds.begin(),
+                    instance.renderMicroseconds.end());
+    totalMisses += instance.deadlineMisses;
+    perInstance.push_back(
+        {{"instance", i},
+         {"blocks", instance.renderMicroseconds.size()},
+         {"deadlineMisses", instance.deadlineMisses},
+         {"renderMicroseconds", summarise(instance.renderMicroseconds)}});
+  }
+  report["instances"] = perInstance;
+
+  auto perThread = nlohmann::json::array();
+  int totalOverruns = 0;
+  for (const auto& thread : threads) {
+    totalOverruns += thread->getNumOverruns();
+    perThread.push_back(
+        {{"name", thread->getThreadName().toStdString()},
+         {"callbacks", thread->getNumCallbacks()},
+         {"overruns", thread->getNumOverruns()},
+         {"worstCallbackMicroseconds",
+          thread->getWorstCallbackMicroseconds()}});
+  }
+  report["threads"] = perThread;
+
+  report["aggregate"] = {
+      {"blocks", allTimes.size()},
+      {"deadlineMisses", totalMisses},
+      {"callbackOverruns", totalOverruns},
+      {"renderMicroseconds", summarise(allTimes)},
+      // Instances that share a ConfigManager share parameter state; one per
+      // instance is expected.
+      {"distinctConfigManagers", configManagers.size()},
+      {"peakMemoryBytes", getPeakMemoryBytes()},
+      {"peakMemoryBeforeInstancesBytes", memoryBefore},
+      {"peakMemoryAfterSetupBytes", memoryAfterSetup}};
+
+  threads.clear();
+  instances.clear();
+
+  if (options.outputPath.empty()) {
+    std::cout << report.dump(2) << std::endl;
+  } else {
+    std::ofstream file(options.outputPath);
+    file << report.dump(2) << std::endl;
+    if (!file) {
+      std::cerr << "Could not write " << options.outputPath << std::endl;
+      return 1;
+    }
+  }
+  return totalMisses == 0 ? 0 : 2;
+}
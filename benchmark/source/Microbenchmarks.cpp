@@ -0,0 +1,124 @@
+#include "Benchmark.h"
+
+#include "Pointilsynth/GrainEnvelope.h"
+#include "Pointilsynth/Oscillator.h"
+#include "Pointilsynth/PointilismInterfaces.h"
+#include "Pointilsynth/Resampler.h"
+#include "Pointilsynth/SpanTracer.h"
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+namespace Benchmark {
+namespace {
+constexpr double kSampleRate = 48000.0;
+constexpr int kRepetitions = 5;
+
+/**
+ * Times numCalls invocations of call(i) and appends the median cost per call
+ * to results.
+ */
+template <typename Call>
+void measure(nlohmann::json& results,
+             const Options& options,
+             const std::string& name,
+             int numCalls,
+             Call&& call) {
+  if (!options.matches(name))
+    return;
+  if (options.quick)
+    numCalls = std::max(1, numCalls / 10);
+
+  // One untimed pass to warm caches and lazily built tables.
+  for (int i = 0; i < numCalls; ++i)
+    call(i);
+  const double nanoseconds = medianNanoseconds(kRepetitions, [&] {
+    for (int i = 0; i < numCalls; ++i)
+      call(i);
+  });
+  results.push_back({{"name", name},
+                     {"calls", numCalls},
+                     {"nsPerCall", nanoseconds / numCalls}});
+}
+
+juce::AudioBuffer<float> makeNoise(int numSamples) {
+  juce::AudioBuffer<float> buffer(1, numSamples);
+  juce::Random random(1234);
+  for (int i = 0; i < numSamples; ++i)
+    buffer.setSample(0, i, random.nextFloat() * 2.0f - 1.0f);
+  return buffer;
+}
+}  // namespace
+
+nlohmann::json runMicrobenchmarks(const Options& options) {
+  auto results = nlohmann::json::array();
+
+  const auto source = makeNoise(static_cast<int>(kSampleRate));
+  const int sourceLength = source.getNumSamples();
+  // Step by a non-integer rate so every fractional phase is exercised.
+  auto readPosition = [sourceLength](int i) {
+    return std::fmod(static_cast<double>(i) * 1.37, sourceLength - 1.0);
+  };
+  measure(results, options, "Resampler::getSample", 100000, [&](int i) {
+    doNotOptimize(Resampler::getSample(source, 0, readPosition(i)));
+  });
+  measure(results, options, "Resampler::getSampleInterpolated", 1000000,
+          [&](int i) {
+            doNotOptimize(Resampler::getSampleInterpolated(
+                source.getReadPointer(0), sourceLength, readPosition(i)));
+          });
+
+  for (auto shape : {GrainEnvelope::Shape::Trapezoid,
+                     GrainEnvelope::Shape::Hann}) {
+    GrainEnvelope envelope;
+    envelope.setShape(shape);
+    constexpr int kDuration = 4800;  // 100 ms at 48 kHz
+    const std::string name =
+        std::string("GrainEnvelope::getAmplitude/") +
+        (shape == GrainEnvelope::Shape::Hann ? "Hann" : "Trapezoid");
+    measure(results, options, name, 1000000, [&](int i) {
+      doNotOptimize(envelope.getAmplitude(i % kDuration, kDuration));
+    });
+  }
+
+  using Waveform = Pointilsynth::Oscillator::Waveform;
+  const std::pair<Waveform, const char*> waveforms[] = {
+      {Waveform::Sine, "Sine"},
+      {Waveform::Saw, "Saw"},
+      {Waveform::Square, "Square"},
+      {Waveform::Noise, "Noise"}};
+  for (const auto& [waveform, waveformName] : waveforms) {
+    Pointilsynth::Oscillator oscillator;
+    oscillator.setSampleRate(kSampleRate);
+    oscillator.setWaveform(waveform);
+    oscillator.setFrequency(440.0f);
+    measure(results, options,
+            std::string("Oscillator::getNextSample/") + waveformName, 1000000,
+            [&](int) { doNotOptimize(oscillator.getNextSample()); });
+  }
+
+  StochasticModel model;
+  model.setSampleRate(kSampleRate);
+  model.setGlobalDensity(100.0f);
+  Grain grain;
+  measure(results, options, "StochasticModel::generateNewGrain", 1000000,
+          [&](int) {
+            model.generateNewGrain(grain);
+            doNotOptimize(grain);
+          });
+  measure(results, options, "StochasticModel::getSamplesUntilNextEvent",
+          1000000,
+          [&](int) { doNotOptimize(model.getSamplesUntilNextEvent()); });
+
+  // Cost of one traced scope in the current tracing state (see --trace).
+  measure(results, options,
+          std::string("SpanTracer::Scope/") +
+              (SpanTracer::isEnabled() ? "enabled" : "disabled"),
+          1000000, [&](int i) {
+            POINTILSYNTH_TRACE_SCOPE("Microbenchmark", i);
+            doNotOptimize(i);
+          });
+
+  return results;
+}
+
+}  // namespace Benchmark
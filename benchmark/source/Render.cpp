@@ -0,0 +1,371 @@
+/**
+ * Renders presets to WAV files offline, as fast as the CPU allows. Links only
+ * the GUI-free DSP core (the PointilSynthDSP target), so it runs on machines
+ * without a display. Several presets render in parallel, one per worker.
+ *
+ * Each render is deterministic for a given preset, source, MIDI file, seed
+ * and block size, which makes the output usable for regression renders.
+ */
+#include "Pointilsynth/PointilismInterfaces.h"
+#include "Pointilsynth/PresetManager.h"
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+struct Options {
+  std::vector<juce::File> presets;
+  juce::File source;  // Grain source audio; the oscillator if not set.
+  juce::File midi;
+  juce::File output;  // A .wav file for one preset, otherwise a directory.
+  int waveform = 0;
+  GrainEnvelope::Shape shape = GrainEnvelope::Shape::Trapezoid;
+  double seconds = 10.0;  // Render length without a MIDI file.
+  double tail = 1.0;      // Rendered after the last MIDI event.
+  double sampleRate = 48000.0;
+  int blockSize = 512;
+  int numChannels = 2;
+  int bitDepth = 24;
+  uint32_t seed = 1;
+  int jobs = 0;  // 0 uses every core.
+};
+
+struct Job {
+  juce::File preset;
+  juce::File output;
+  bool ok = false;
+  std::string error;
+  double renderSeconds = 0.0;
+};
+
+void printUsage() {
+  std::cerr
+      << "Usage: PointilSynthRender [options] <preset.json>...\n"
+         "  --source <file>       Use an audio file as the grain source\n"
+         "  --waveform <n>        Oscillator waveform without a source "
+         "(0 sine, 1 saw, 2 square, 3 noise)\n"
+         "  --envelope <shape>    trapezoid (default) or hann\n"
+         "  --midi <file>         Play a standard MIDI file\n"
+         "  --seconds <s>         Length without a MIDI file (default 10)\n"
+         "  --tail <s>            Length after the last MIDI event "
+         "(default 1)\n"
+         "  --sample-rate <hz>    Output sample rate (default 48000)\n"
+         "  --block-size <n>      Samples per processBlock (default 512)\n"
+         "  --channels <n>        Output channels (default 2)\n"
+         "  --bit-depth <n>       16, 24 (default) or 32\n"
+         "  --seed <n>            Random seed (default 1)\n"
+         "  --output <path>       Output .wav for a single preset, otherwise "
+         "a directory (default: current directory)\n"
+         "  --jobs <n>            Presets rendered in parallel (default: one "
+         "per core)\n";
+}
+
+juce::File resolve(const char* path) {
+  return juce::File::getCurrentWorkingDirectory().getChildFile(path);
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+    if (arg == "--source" && hasValue) {
+      options.source = resolve(argv[++i]);
+    } else if (arg == "--waveform" && hasValue) {
+      options.waveform = std::atoi(argv[++i]);
+    } else if (arg == "--envelope" && hasValue) {
+      const std::string shape = argv[++i];
+      if (shape == "hann")
+        options.shape = GrainEnvelope::Shape::Hann;
+      else if (shape != "trapezoid")
+        return false;
+    } else if (arg == "--midi" && hasValue) {
+      options.midi = resolve(argv[++i]);
+    } else if (arg == "--seconds" && hasValue) {
+      options.seconds = std::max(0.0, std::atof(argv[++i]));
+    } else if (arg == "--tail" && hasValue) {
+      options.tail = std::max(0.0, std::atof(argv[++i]));
+    } else if (arg == "--sample-rate" && hasValue) {
+      options.sampleRate = std::max(1000.0, std::atof(argv[++i]));
+    } else if (arg == "--block-size" && hasValue) {
+      options.blockSize = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--channels" && hasValue) {
+      options.numChannels = std::clamp(std::atoi(argv[++i]), 1, 8);
+    } else if (arg == "--bit-depth" && hasValue) {
+      options.bitDepth = std::atoi(argv[++i]);
+      if (options.bitDepth != 16 && options.bitDepth != 24 &&
+          options.bitDepth != 32)
+        return false;
+    } else if (arg == "--seed" && hasValue) {
+      options.seed =
+          static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 0));
+    } else if (arg == "--output" && hasValue) {
+      options.output = resolve(argv[++i]);
+    } else if (arg == "--jobs" && hasValue) {
+      options.jobs = std::max(1, std::atoi(argv[++i]));
+    } else if (!arg.empty() && arg[0] != '-') {
+      options.presets.push_back(resolve(argv[i]));
+    } else {
+      return false;
+    }
+  }
+  return !options.presets.empty();
+}
+
+bool loadSource(const juce::File& file, juce::AudioBuffer<float>& audio) {
+  juce::AudioFormatManager formatManager;
+  formatManager.registerBasicFormats();
+  std::unique_ptr<juce::AudioFormatReader> reader(
+      formatManager.createReaderFor(file));
+  if (reader == nullptr || reader->lengthInSamples <= 0)
+    return false;
+  audio.setSize(static_cast<int>(reader->numChannels),
+                static_cast<int>(reader->lengthInSamples));
+  return reader->read(&audio, 0, audio.getNumSamples(), 0, true, true);
+}
+
+/** Merges every track of a MIDI file into one sequence timed in seconds. */
+bool loadMidi(const juce::File& file, juce::MidiMessageSequence& sequence) {
+  juce::FileInputStream in(file);
+  juce::MidiFile midiFile;
+  if (!in.openedOk() || !midiFile.readFrom(in))
+    return false;
+  midiFile.convertTimestampTicksToSeconds();
+  for (int track = 0; track < midiFile.getNumTracks(); ++track)
+    sequence.addSequence(*midiFile.getTrack(track), 0.0);
+  sequence.sort();
+  return true;
+}
+
+double getLengthSeconds(const Options& options,
+                        const juce::MidiMessageSequence& sequence) {
+  return sequence.getNumEvents() > 0 ? sequence.getEndTime() + options.tail
+                                     : options.seconds;
+}
+
+juce::File getOutputFile(const Options& options, const juce::File& preset) {
+  if (options.presets.size() == 1 && options.output.hasFileExtension("wav"))
+    return options.output;
+  const auto directory = options.output == juce::File()
+                             ? juce::File::getCurrentWorkingDirectory()
+                             : options.output;
+  return directory.getChildFile(preset.getFileNameWithoutExtension() + ".wav");
+}
+
+/**
+ * Names each job's output. Presets that share a name but live in different
+ * directories get their directory's name as a prefix, so no two workers write
+ * the same file. Returns false, after saying why, if outputs still clash.
+ */
+bool assignOutputFiles(const Options& options, std::vector<Job>& jobs) {
+  for (auto& job : jobs)
+    job.output = getOutputFile(options, job.preset);
+  auto isShared = [&jobs](const Job& job) {
+    return std::count_if(jobs.begin(), jobs.end(), [&job](const Job& other) {
+             return other.output == job.output;
+           }) > 1;
+  };
+
+  std::vector<bool> needsPrefix(jobs.size());
+  for (size_t i = 0; i < jobs.size(); ++i)
+    needsPrefix[i] = isShared(jobs[i]);
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    if (needsPrefix[i])
+      jobs[i].output = jobs[i].output.getSiblingFile(
+          jobs[i].preset.getParentDirectory().getFileName() + "_" +
+          jobs[i].output.getFileName());
+  }
+
+  for (const auto& job : jobs) {
+    if (isShared(job)) {
+      std::cerr << "More than one preset would render to "
+                << job.output.getFullPathName().toStdString() << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Renders one preset. MIDI is handed to the engine per block, and the engine
+ * applies each event to its voices at the event's sample position.
+ */
+void render(const Options& options,
+            const juce::AudioBuffer<float>& source,
+            const juce::MidiMessageSequence& sequence,
+            Job& job) {
+  const auto startTime = std::chrono::steady_clock::now();
+  juce::FileInputStream presetStream(job.preset);
+  if (!presetStream.openedOk()) {
+    job.error = "Could not read the preset";
+    return;
+  }
+  const auto text = presetStream.readEntireStreamAsString().toStdString();
+  const auto preset = nlohmann::json::parse(text, nullptr, false);
+  if (preset.is_discarded() || !preset.is_object()) {
+    job.error = "Not a preset";
+    return;
+  }
+
+  AudioEngine engine;
+  try {
+    Pointilism::PresetManager(*engine.getStochasticModel())
+        .applyPreset(preset);
+  } catch (const nlohmann::json::exception& e) {
+    job.error = std::string("Not a preset: ") + e.what();
+    return;
+  }
+  engine.setRandomSeed(options.seed);
+  if (source.getNumSamples() > 0) {
+    engine.setSourceAudio(source);
+    engine.setSourceType(AudioEngine::GrainSourceType::AudioSample);
+  } else {
+    engine.setGrainSource(options.waveform);
+  }
+  engine.setEnvelopeShape(options.shape);
+  engine.prepareToPlay(options.sampleRate, options.blockSize);
+
+  const auto writeError =
+      "Could not write " + job.output.getFullPathName().toStdString();
+  job.output.deleteFile();
+  auto stream = std::make_unique<juce::FileOutputStream>(job.output);
+  if (!stream->openedOk()) {
+    job.error = writeError;
+    return;
+  }
+  juce::WavAudioFormat wav;
+  std::unique_ptr<juce::AudioFormatWriter> writer(
+      wav.createWriterFor(stream.get(), options.sampleRate,
+                          static_cast<unsigned int>(options.numChannels),
+                          options.bitDepth, {}, 0));
+  if (writer == nullptr) {
+    job.error = "Unsupported WAV format";
+    return;
+  }
+  stream.release();  // Now owned by the writer.
+
+  const auto numSamples = static_cast<int64_t>(
+      std::ceil(getLengthSeconds(options, sequence) * options.sampleRate));
+  juce::AudioBuffer<float> block(options.numChannels, options.blockSize);
+  const juce::AudioPlayHead::PositionInfo position;
+  int nextEvent = 0;
+  for (int64_t start = 0; start < numSamples; start += options.blockSize) {
+    const int length = static_cast<int>(
+        std::min<int64_t>(options.blockSize, numSamples - start));
+    if (length != block.getNumSamples())
+      block.setSize(options.numChannels, length, false, false, true);
+
+    juce::MidiBuffer midi;
+    const auto end = start + length;
+    for (; nextEvent < sequence.getNumEvents(); ++nextEvent) {
+      const auto& message = sequence.getEventPointer(nextEvent)->message;
+      const auto samplePosition = static_cast<int64_t>(
+          std::llround(message.getTimeStamp() * options.sampleRate));
+      if (samplePosition >= end)
+        break;
+      midi.addEvent(message,
+                    static_cast<int>(std::max<int64_t>(0,
+                                                       samplePosition - start)));
+    }
+    engine.processBlock(block, midi, position);
+    if (!writer->writeFromAudioSampleBuffer(block, 0, length)) {
+      job.error = writeError;
+      return;
+    }
+  }
+  writer.reset();
+
+  job.ok = true;
+  job.renderSeconds = std::chrono::duration<double>(
+                          std::chrono::steady_clock::now() - startTime)
+                          .count();
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Options options;
+  if (!parseOptions(argc, argv, options)) {
+    printUsage();
+    return 1;
+  }
+
+  juce::AudioBuffer<float> source;
+  if (options.source != juce::File() && !loadSource(options.source, source)) {
+    std::cerr << "Could not read "
+              << options.source.getFullPathName().toStdString() << std::endl;
+    return 1;
+  }
+  juce::MidiMessageSequence sequence;
+  if (options.midi != juce::File() && !loadMidi(options.midi, sequence)) {
+    std::cerr << "Not a MIDI file: "
+              << options.midi.getFullPathName().toStdString() << std::endl;
+    return 1;
+  }
+  if (options.output != juce::File() && !options.output.hasFileExtension("wav"))
+    options.output.createDirectory();
+
+  std::vector<Job> jobs(options.presets.size());
+  for (size_t i = 0; i < jobs.size(); ++i)
+    jobs[i].preset = options.presets[i];
+  if (!assignOutputFiles(options, jobs))
+    return 1;
+
+  // Renders share nothing but the read-only source and MIDI, so each worker
+  // takes the next preset until none are left.
+  const auto startTime = std::chrono::steady_clock::now();
+  const int numWorkers = std::min(
+      static_cast<int>(jobs.size()),
+      options.jobs > 0
+          ? options.jobs
+          : std::max(1, static_cast<int>(std::thread::hardware_concurrency())));
+  std::atomic<size_t> nextJob{0};
+  std::vector<std::thread> workers;
+  for (int w = 0; w < numWorkers; ++w) {
+    workers.emplace_back([&] {
+      for (size_t i = nextJob++; i < jobs.size(); i = nextJob++)
+        render(options, source, sequence, jobs[i]);
+    });
+  }
+  for (auto& worker : workers)
+    worker.join();
+  const double wallSeconds = std::chrono::duration<double>(
+                                 std::chrono::steady_clock::now() - startTime)
+                                 .count();
+
+  const double audioSeconds = getLengthSeconds(options, sequence);
+  auto renders = nlohmann::json::array();
+  int numFailed = 0;
+  for (const auto& job : jobs) {
+    nlohmann::json entry;
+    entry["preset"] = job.preset.getFullPathName().toStdString();
+    if (job.ok) {
+      entry["output"] = job.output.getFullPathName().toStdString();
+      entry["renderSeconds"] = job.renderSeconds;
+      entry["speedFactor"] =
+          job.renderSeconds > 0.0 ? audioSeconds / job.renderSeconds : 0.0;
+    } else {
+      entry["error"] = job.error;
+      ++numFailed;
+    }
+    renders.push_back(entry);
+  }
+
+  nlohmann::json report;
+  report["sampleRate"] = options.sampleRate;
+  report["audioSeconds"] = audioSeconds;
+  report["workers"] = numWorkers;
+  report["wallSeconds"] = wallSeconds;
+  report["renders"] = renders;
+  std::cout << report.dump(2) << std::endl;
+  return numFailed == 0 ? 0 : 1;
+}
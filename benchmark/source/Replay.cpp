@@ -0,0 +1,95 @@
+/**
+ * Replays a captured session trace (see SessionTrace.h) into a fresh
+ * processor as fast as possible and reports how long it took. Capture a
+ * trace with AudioPluginAudioProcessor::startSessionCapture().
+ */
+#include "Benchmark.h"
+
+#include "Pointilsynth/PluginProcessor.h"
+#include "Pointilsynth/SessionTrace.h"
+
+#include <juce_gui_basics/juce_gui_basics.h>
+
+#include <fstream>
+#include <iostream>
+
+namespace {
+void printUsage() {
+  std::cerr << "Usage: PointilSynthReplay <trace> [options]\n"
+               "  --repeat <n>     Replay the trace n times (default 1)\n"
+               "  --output <file>  Write the JSON report to file\n";
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    printUsage();
+    return 1;
+  }
+  const juce::File traceFile =
+      juce::File::getCurrentWorkingDirectory().getChildFile(argv[1]);
+  int repeats = 1;
+  std::string outputPath;
+  for (int i = 2; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "--repeat" && i + 1 < argc) {
+      repeats = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--output" && i + 1 < argc) {
+      outputPath = argv[++i];
+    } else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  juce::ScopedJuceInitialiser_GUI libraryInitialiser;
+  SessionTrace::Reader reader(traceFile);
+  if (!reader.isValid()) {
+    std::cerr << "Not a session trace: "
+              << traceFile.getFullPathName().toStdString() << std::endl;
+    return 1;
+  }
+
+  auto runs = nlohmann::json::array();
+  std::vector<double> allBlockMicroseconds;
+  double budgetMicroseconds = 0.0;
+  for (int run = 0; run < repeats; ++run) {
+    // A fresh processor per run, so every run starts from the same state.
+    audio_plugin::AudioPluginAudioProcessor processor;
+    const auto result = SessionTrace::replay(reader, processor);
+    const double audioSeconds =
+        static_cast<double>(result.numSamples) / reader.getSampleRate();
+    runs.push_back({{"blocks", result.numBlocks},
+                    {"audioSeconds", audioSeconds},
+                    {"renderSeconds", result.renderSeconds},
+                    {"speedFactor", result.renderSeconds > 0.0
+                                        ? audioSeconds / result.renderSeconds
+                                        : 0.0}});
+    for (double seconds : result.blockSeconds)
+      allBlockMicroseconds.push_back(seconds * 1.0e6);
+    if (result.numBlocks > 0)
+      budgetMicroseconds = 1.0e6 * audioSeconds / result.numBlocks;
+  }
+
+  nlohmann::json report;
+  report["trace"] = traceFile.getFullPathName().toStdString();
+  report["sampleRate"] = reader.getSampleRate();
+  report["runs"] = runs;
+  report["meanBlockBudgetMicroseconds"] = budgetMicroseconds;
+  report["blockMicroseconds"] = {
+      {"p50", Benchmark::percentile(allBlockMicroseconds, 50.0)},
+      {"p99", Benchmark::percentile(allBlockMicroseconds, 99.0)},
+      {"max", Benchmark::percentile(allBlockMicroseconds, 100.0)}};
+
+  if (outputPath.empty()) {
+    std::cout << report.dump(2) << std::endl;
+  } else {
+    std::ofstream file(outputPath);
+    file << report.dump(2) << std::endl;
+    if (!file) {
+      std::cerr << "Could not write " << outputPath << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -2,6 +2,7 @@
 
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_gui_basics/juce_gui_basics.h>
+#include "ParameterHandles.h"
 #include <memory>
 #include <functional>
 #include <unordered_map>
@@ -27,6 +28,10 @@ public:
   static void resetInstance();
   void addListener(const juce::String& paramID, Callback cb);
 
+  /** Raw parameter pointers resolved once at construction. The audio thread
+   * polls these once per block instead of registering listeners. */
+  const ParameterHandles& getParameterHandles() const { return handles_; }
+
   std::unique_ptr<juce::Slider> createAttachedSlider(
       const juce::String& paramID);
   std::unique_ptr<juce::ComboBox> createAttachedComboBox(
@@ -51,6 +56,7 @@ private:
 
   juce::AudioProcessorValueTreeState apvts_;
   juce::AudioProcessor* owner_{nullptr};
+  ParameterHandles handles_;
   std::unordered_map<juce::String,
                      std::vector<std::unique_ptr<FunctionListener>>>
       listeners_;
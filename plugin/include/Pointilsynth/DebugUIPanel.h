@@ -3,21 +3,58 @@
 #include <juce_gui_basics/juce_gui_basics.h>
 #include "PointilismInterfaces.h"  // Assuming this is the correct path
 #include "ConfigManager.h"
+#include "RenderTelemetry.h"
 
-class DebugUIPanel : public juce::Component {
+#include <vector>
+
+class DebugUIPanel : public juce::Component, private juce::Timer {
 public:
-  // Constructor that takes a ConfigManager
-  explicit DebugUIPanel(std::shared_ptr<ConfigManager> cfg);
+  // Constructor that takes a ConfigManager. When telemetry is given (and
+  // telemetry is compiled in), the panel also shows a live load meter,
+  // percentile load stats and the overrun counter, and, where the platform
+  // has them, a switch for per-stage hardware counters. The telemetry must
+  // outlive the panel.
+  explicit DebugUIPanel(std::shared_ptr<ConfigManager> cfg,
+                        RenderTelemetry* telemetry = nullptr);
   ~DebugUIPanel() override;
 
   // juce::Component overrides
   void paint(juce::Graphics& g) override;
   void resized() override;
 
+  /** Drains queued telemetry and refreshes the stats. Called on a timer. */
+  void updateTelemetry();
+
+  /** Statistics over the blocks currently shown. */
+  const RenderTelemetry::Summary& getTelemetrySummary() const {
+    return telemetrySummary;
+  }
+
+  /** Number of recent blocks the percentile stats cover. */
+  static constexpr size_t kTelemetryHistoryBlocks = 1024;
+
 private:
+  // juce::Timer override: drains the telemetry ring.
+  void timerCallback() override;
+  void paintTelemetry(juce::Graphics& g) const;
+  void paintPerfCounters(juce::Graphics& g, juce::Rectangle<int> area) const;
+
   // Config manager
   std::shared_ptr<ConfigManager> configManager;
 
+  // Render telemetry (may be null)
+  RenderTelemetry* telemetry;
+  std::vector<RenderTelemetry::BlockStats> telemetryHistory;
+  RenderTelemetry::Summary telemetrySummary;
+  juce::Rectangle<int> telemetryArea;
+  juce::TextButton resetOverrunsButton{"Reset"};
+  juce::ToggleButton perfCountersToggle{"HW counters"};
+
+  // Span tracing
+  void toggleTracing();
+  juce::TextButton traceButton;
+  juce::Label traceStatusLabel;
+
   // UI Components
   std::unique_ptr<juce::Slider> pitchSlider;
   juce::Label pitchLabel;
@@ -6,7 +6,8 @@
 
 class DebugWindow : public juce::DocumentWindow {
 public:
-  explicit DebugWindow(std::shared_ptr<ConfigManager> cfg);
+  explicit DebugWindow(std::shared_ptr<ConfigManager> cfg,
+                       RenderTelemetry* telemetry = nullptr);
   ~DebugWindow() override = default;
 
   void closeButtonPressed() override;
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cmath>
+
+namespace Pointilsynth {
+
+/**
+ * Branch-free sin(2 * pi * phase) for phase in [0, 1).
+ *
+ * The phase is folded onto [-pi/2, pi/2] and evaluated with a 9th order
+ * polynomial (max error ~4e-6). Unlike std::sin it has no data-dependent
+ * branches, so loops calling it vectorize.
+ */
+inline float fastSin2Pi(float phase) {
+  // sin(2*pi*p) == -sin(2*pi*(p - 0.5)); t lies in [-0.5, 0.5).
+  float t = phase - 0.5f;
+  // Fold |t| > 0.25 back using sin(pi - x) == sin(x).
+  const float folded = std::copysign(0.5f, t) - t;
+  t = std::fabs(t) > 0.25f ? folded : t;
+  const float x = t * 6.28318530717958647692f;
+  const float x2 = x * x;
+  const float poly =
+      x * (1.0f +
+           x2 * (-1.6666667e-1f +
+                 x2 * (8.3333333e-3f +
+                       x2 * (-1.9841270e-4f + x2 * 2.7557319e-6f))));
+  return -poly;
+}
+
+/** Branch-free cos(2 * pi * phase) for phase in [0, 1). */
+inline float fastCos2Pi(float phase) {
+  float shifted = phase + 0.25f;
+  shifted -= shifted >= 1.0f ? 1.0f : 0.0f;
+  return fastSin2Pi(shifted);
+}
+
+}  // namespace Pointilsynth
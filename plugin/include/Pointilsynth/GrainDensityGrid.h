@@ -0,0 +1,80 @@
+#pragma once
+
+#include "TripleBuffer.h"
+
+#include <array>
+#include <atomic>
+
+/**
+ * @class GrainDensityGrid
+ * @brief Pitch x pan energy of spawned grains, published through a triple
+ * buffer.
+ *
+ * When enabled, the AudioEngine adds each grain it spawns to a coarse grid
+ * instead of queueing a GrainVisQueue record, weighting it by amplitude and
+ * duration. At the end of each block it publishes the grid for the GUI,
+ * which draws it as a heatmap. The cost on both threads is then independent
+ * of density.
+ *
+ * Grids are handed over through a TripleBuffer. If the reader has not taken
+ * the last published grid, the writer keeps adding to its own until it has,
+ * so no energy is lost while the GUI keeps up. A reader that falls more than
+ * kMaxUnreadSeconds behind, e.g. with the editor closed, gets an empty grid
+ * rather than the backlog, and so does one that re-enables the grid.
+ */
+class GrainDensityGrid {
+public:
+  static constexpr int kPitchBins = 88;  // One per piano key
+  static constexpr int kPanBins = 32;
+  static constexpr int kNumCells = kPitchBins * kPanBins;
+  static constexpr float kLowestPitch = 21.0f;  // MIDI note of row 0
+  /** Audio a grid may gather while the reader is away before it is
+   * dropped. */
+  static constexpr double kMaxUnreadSeconds = 0.25;
+  using Grid = std::array<float, kNumCells>;
+
+  /** Cell of a grain, row-major by pitch from low to high, then by pan from
+   * left to right. Out-of-range values land in the edge cells. */
+  static int cellIndex(float pitch, float pan);
+
+  /** Chooses whether the engine fills the grid instead of the grain queue.
+   * Enabling it drops whatever was gathered before. Any thread. */
+  void setEnabled(bool shouldBeEnabled) {
+    if (shouldBeEnabled && !isEnabled())
+      clearRequested_.store(true);
+    enabled_.store(shouldBeEnabled);
+  }
+  bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  /** Adds weight to the writer's grid. Audio thread only. */
+  void add(float pitch, float pan, float weight) noexcept {
+    if (clearRequested_.load(std::memory_order_relaxed))
+      clear();
+    grids_.getWriteBuffer()[static_cast<size_t>(cellIndex(pitch, pan))] +=
+        weight;
+    backHasData_ = true;
+  }
+
+  /**
+   * Hands the writer's grid to the reader if it has taken the previous one
+   * and there is anything to hand over. blockSeconds is the audio added since
+   * the last call; once the reader has left its grid untaken for more than
+   * kMaxUnreadSeconds, both grids are cleared. Wait-free; audio thread only.
+   */
+  bool publish(double blockSeconds) noexcept;
+
+  /** The newest published grid, or nullptr if nothing new was published
+   * since the last call. Valid until the next call; GUI thread only. */
+  const Grid* acquire() noexcept { return grids_.acquire(); }
+
+private:
+  /** Empties the writer's grid and replaces an unread one with an empty
+   * grid, so the reader sees nothing stale. */
+  void clear() noexcept;
+
+  TripleBuffer<Grid> grids_;
+  bool backHasData_ = false;    // The writer's grid is not empty
+  double unreadSeconds_ = 0.0;  // Audio added while the reader was away
+  std::atomic<bool> enabled_{false};
+  std::atomic<bool> clearRequested_{false};
+};
@@ -2,6 +2,10 @@
 #define GRAIN_ENVELOPE_H_
 
 #include <cmath> // For M_PI, later for cosf
+#include <algorithm> // For std::clamp in fill()
+
+#include "FastMath.h"
+#include "SimdKernels.h"
 
 // Add M_PI definition if not present (though cmath should provide it)
 #ifndef M_PI
@@ -21,6 +25,70 @@ public:
         currentShape_ = newShape;
     }
 
+    Shape getShape() const {
+        return currentShape_;
+    }
+
+    // Attack/release length used by the Trapezoid shape. Mirrors the rules in
+    // getAmplitude(): 10% of the duration, at least one sample, at most half.
+    static int trapezoidRampSamples(int totalDuration) {
+        int rampSamples = static_cast<int>(std::round(0.1f * static_cast<float>(totalDuration)));
+        if (rampSamples == 0 && totalDuration > 1) {
+            rampSamples = 1;
+        }
+        if (2 * rampSamples > totalDuration) {
+            rampSamples = totalDuration / 2;
+        }
+        return rampSamples;
+    }
+
+    // Writes getAmplitude(startSample + i, totalDuration) for i in [0, numSamples)
+    // into dest. The shape is a template parameter and every segment is a
+    // straight-line fill, so render kernels get a branch-free fill per grain.
+    // Ramps and the Hann curve go through the given SIMD kernels.
+    template <Shape S>
+    static void fill(float* dest, int startSample, int numSamples, int totalDuration,
+                     const SimdKernels::KernelSet& kernels = SimdKernels::active()) {
+        if (totalDuration <= 0) {
+            std::fill(dest, dest + numSamples, 0.0f);
+            return;
+        }
+
+        const int end = startSample + numSamples;
+        // Segment boundaries in grain time, clipped to [startSample, end).
+        auto clip = [startSample, end](int n) { return std::clamp(n, startSample, end); };
+        const int attackStart = clip(0);
+        const int releaseEnd = clip(totalDuration);
+        std::fill(dest, dest + (attackStart - startSample), 0.0f);
+
+        if constexpr (S == Shape::Hann) {
+            const float invDuration = 1.0f / static_cast<float>(totalDuration);
+            kernels.hann(dest + (attackStart - startSample), static_cast<float>(attackStart) * invDuration,
+                         invDuration, releaseEnd - attackStart);
+        } else {
+            const int rampSamples = trapezoidRampSamples(totalDuration);
+            const int sustainStart = clip(rampSamples);
+            const int releaseStart = clip(totalDuration - rampSamples);
+
+            if (rampSamples <= 1) {
+                // Single-sample ramps jump straight to 1.0 and release to 0.0.
+                std::fill(dest + (attackStart - startSample), dest + (releaseStart - startSample), 1.0f);
+                std::fill(dest + (releaseStart - startSample), dest + (releaseEnd - startSample),
+                          rampSamples == 1 ? 0.0f : 1.0f);
+            } else {
+                const float rampScale = 1.0f / static_cast<float>(rampSamples - 1);
+                kernels.ramp(dest + (attackStart - startSample), static_cast<float>(attackStart) * rampScale,
+                             rampScale, sustainStart - attackStart);
+                std::fill(dest + (sustainStart - startSample), dest + (releaseStart - startSample), 1.0f);
+                const int releaseOrigin = totalDuration - rampSamples;
+                kernels.ramp(dest + (releaseStart - startSample),
+                             1.0f - static_cast<float>(releaseStart - releaseOrigin) * rampScale, -rampScale,
+                             releaseEnd - releaseStart);
+            }
+        }
+        std::fill(dest + (releaseEnd - startSample), dest + numSamples, 0.0f);
+    }
+
     float getAmplitude(int currentSample, int totalDuration) {
         if (totalDuration <= 0 || currentSample < 0 || currentSample >= totalDuration) {
             return 0.0f; // Invalid parameters or outside the duration
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include "PointilismInterfaces.h"
+#include "GrainEnvelope.h"
+#include "Oscillator.h"
+#include "Resampler.h"
+#include "SimdKernels.h"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+/**
+ * Compile-time specialised grain render kernels.
+ *
+ * Every combination of grain source (oscillator waveform or audio sample),
+ * envelope shape and output channel layout gets its own instantiation of
+ * renderGrain(). The AudioEngine groups live grains by kernel group and looks
+ * the kernel up once per group per sub-block, so the per-sample loops contain
+ * no data-dependent branches. The sine, envelope, resampler and mix loops run
+ * on the SimdKernels variant selected for the host CPU.
+ */
+namespace GrainRenderKernels {
+
+enum class Source { Sine, Saw, Square, Noise, AudioSample };
+
+constexpr int kNumSources = 5;
+constexpr int kNumShapes = 2;   // GrainEnvelope::Shape::{Trapezoid, Hann}
+constexpr int kNumLayouts = 2;  // Mono, stereo
+constexpr int kNumGroups = kNumSources * kNumShapes;
+constexpr int kNumKernels = kNumGroups * kNumLayouts;
+
+/** Kernel group a grain is assigned to when it is spawned. */
+constexpr int groupIndex(Source source, GrainEnvelope::Shape shape) {
+  return static_cast<int>(source) * kNumShapes + static_cast<int>(shape);
+}
+
+/** Source that every grain in group reads. */
+constexpr Source sourceOf(int group) {
+  return static_cast<Source>(group / kNumShapes);
+}
+
+/** Envelope shape of every grain in group. */
+constexpr GrainEnvelope::Shape shapeOf(int group) {
+  return static_cast<GrainEnvelope::Shape>(group % kNumShapes);
+}
+
+/** Maps an oscillator waveform onto the matching kernel source. */
+constexpr Source sourceFor(Pointilsynth::Oscillator::Waveform waveform) {
+  switch (waveform) {
+    case Pointilsynth::Oscillator::Waveform::Saw:
+      return Source::Saw;
+    case Pointilsynth::Oscillator::Waveform::Square:
+      return Source::Square;
+    case Pointilsynth::Oscillator::Waveform::Noise:
+      return Source::Noise;
+    case Pointilsynth::Oscillator::Waveform::Sine:
+    default:
+      return Source::Sine;
+  }
+}
+
+/** Shared, per-sub-block state handed to every kernel. */
+struct Context {
+  const juce::AudioBuffer<float>* sourceAudio = nullptr;
+  float* envelope = nullptr;  // Scratch, at least one sub-block long.
+  float* source = nullptr;    // Scratch, at least one sub-block long.
+  const SimdKernels::KernelSet* simd = &SimdKernels::active();
+};
+
+using Kernel = void (*)(const Context& context,
+                        Grain& grain,
+                        float* left,
+                        float* right,
+                        int numSamples);
+
+/** Fills dest with the next count source samples of a grain and advances its
+ * playback state. */
+template <Source S>
+inline void fillSource(const Context& context,
+                       Grain& grain,
+                       float* dest,
+                       int count) {
+  if constexpr (S == Source::Noise) {
+    for (int i = 0; i < count; ++i)
+      dest[i] = Pointilsynth::Oscillator::noise(grain.noiseState);
+  } else if constexpr (S == Source::AudioSample) {
+    const auto* audio = context.sourceAudio;
+    if (audio == nullptr || audio->getNumSamples() == 0 ||
+        audio->getNumChannels() == 0) {
+      std::fill(dest, dest + count, 0.0f);
+      return;
+    }
+    // Channel 0 only; Resampler zero-pads reads outside the buffer.
+    const float* data = audio->getReadPointer(0);
+    const int length = audio->getNumSamples();
+    double position = grain.sourceSamplePosition;
+    for (int i = 0; i < count; ++i) {
+      dest[i] = Resampler::getSampleInterpolated(data, length, position,
+                                                 *context.simd);
+      position += grain.playbackRate;
+    }
+    grain.sourceSamplePosition = position;
+  } else {
+    // Phases are derived from the start phase rather than accumulated so the
+    // loop has no carried dependency. Phase is always non-negative, so
+    // truncation is the same as floor.
+    const float startPhase = grain.phase;
+    const float increment = grain.phaseIncrement;
+    if constexpr (S == Source::Sine) {
+      context.simd->sine(dest, startPhase, increment, count);
+    } else {
+      for (int i = 0; i < count; ++i) {
+        float phase = startPhase + increment * static_cast<float>(i);
+        phase -= static_cast<float>(static_cast<int>(phase));
+        if constexpr (S == Source::Saw)
+          dest[i] = Pointilsynth::Oscillator::saw(phase);
+        else
+          dest[i] = Pointilsynth::Oscillator::square(phase);
+      }
+    }
+    float endPhase = startPhase + increment * static_cast<float>(count);
+    endPhase -= static_cast<float>(static_cast<int>(endPhase));
+    grain.phase = endPhase;
+  }
+}
+
+/**
+ * Renders one grain into the sub-block mix buffers. Playback starts at the
+ * grain's startOffset and stops at the end of its lifetime, at which point the
+ * grain is marked dead.
+ */
+template <Source S, GrainEnvelope::Shape Shape, int NumChannels>
+void renderGrain(const Context& context,
+                 Grain& grain,
+                 float* left,
+                 float* right,
+                 int numSamples) {
+  const int start = grain.startOffset;
+  const int count = std::min(numSamples - start,
+                             grain.durationInSamples - grain.ageInSamples);
+
+  if (count > 0) {
+    float* envelope = context.envelope;
+    float* source = context.source;
+    GrainEnvelope::fill<Shape>(envelope, grain.ageInSamples, count,
+                               grain.durationInSamples, *context.simd);
+    fillSource<S>(context, grain, source, count);
+
+    if constexpr (NumChannels == 1) {
+      context.simd->mixMono(left + start, source, envelope, grain.gainLeft,
+                            count);
+    } else {
+      context.simd->mixStereo(left + start, right + start, source, envelope,
+                              grain.gainLeft, grain.gainRight, count);
+    }
+    grain.ageInSamples += count;
+  }
+
+  if (grain.ageInSamples >= grain.durationInSamples)
+    grain.isAlive = false;
+}
+
+namespace detail {
+template <int Index>
+constexpr Kernel makeKernel() {
+  constexpr auto source =
+      static_cast<Source>(Index / (kNumShapes * kNumLayouts));
+  constexpr auto shape =
+      static_cast<GrainEnvelope::Shape>((Index / kNumLayouts) % kNumShapes);
+  constexpr int numChannels = Index % kNumLayouts + 1;
+  return &renderGrain<source, shape, numChannels>;
+}
+
+template <std::size_t... Indices>
+constexpr std::array<Kernel, sizeof...(Indices)> makeTable(
+    std::index_sequence<Indices...>) {
+  return {makeKernel<static_cast<int>(Indices)>()...};
+}
+}  // namespace detail
+
+/** Dispatch table indexed by (group * kNumLayouts + layout). */
+inline constexpr std::array<Kernel, kNumKernels> kKernelTable =
+    detail::makeTable(std::make_index_sequence<kNumKernels>{});
+
+/** Looks up the kernel for a grain group and output channel count. */
+inline Kernel getKernel(int group, int numOutputChannels) {
+  const int layout = numOutputChannels > 1 ? 1 : 0;
+  return kKernelTable[static_cast<size_t>(group * kNumLayouts + layout)];
+}
+
+}  // namespace GrainRenderKernels
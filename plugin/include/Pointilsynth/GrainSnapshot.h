@@ -0,0 +1,59 @@
+#pragma once
+
+#include "TripleBuffer.h"
+
+#include <array>
+#include <atomic>
+
+/**
+ * @struct GrainSnapshot
+ * @brief The live grain pool as it stood at the end of one block.
+ *
+ * Holds at most kMaxGrains grains, so publishing one costs the audio thread a
+ * bounded amount of work however many grains are alive.
+ */
+struct GrainSnapshot {
+  static constexpr int kMaxGrains = 1024;
+
+  struct LiveGrain {
+    int id = 0;
+    float pitch = 0.0f;     // MIDI note number
+    float pan = 0.0f;       // -1 (L) to 1 (R)
+    float progress = 0.0f;  // Fraction of the grain's duration played
+    float gain = 0.0f;      // Amplitude times the current envelope value
+  };
+
+  int numGrains = 0;  // Valid entries in grains
+  int numLive = 0;    // Grains alive; above kMaxGrains some are left out
+  std::array<LiveGrain, kMaxGrains> grains{};
+};
+
+/**
+ * @class GrainSnapshotBuffer
+ * @brief Hands GrainSnapshots from the AudioEngine to the GUI.
+ *
+ * While enabled, the engine publishes a snapshot at the end of every block
+ * instead of queueing spawned grains in its GrainVisQueue. The GUI acquires
+ * the newest complete snapshot without locking; older unread ones are
+ * replaced.
+ */
+class GrainSnapshotBuffer {
+public:
+  /** Chooses whether the engine publishes snapshots. Any thread. */
+  void setEnabled(bool shouldBeEnabled) { enabled_.store(shouldBeEnabled); }
+  bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  /** The snapshot to fill, then publish(). Audio thread only. */
+  GrainSnapshot& getWriteBuffer() noexcept {
+    return snapshots_.getWriteBuffer();
+  }
+  void publish() noexcept { snapshots_.publish(); }
+
+  /** The newest published snapshot, or nullptr if there is nothing new.
+   * Valid until the next call; GUI thread only. */
+  const GrainSnapshot* acquire() noexcept { return snapshots_.acquire(); }
+
+private:
+  TripleBuffer<GrainSnapshot> snapshots_;
+  std::atomic<bool> enabled_{false};
+};
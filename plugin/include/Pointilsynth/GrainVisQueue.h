@@ -0,0 +1,53 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @struct GrainInfoForVis
+ * @brief Lightweight data passed from the AudioEngine to the GUI thread.
+ */
+struct GrainInfoForVis {
+  float pan{};
+  float pitch{};
+  float durationSeconds{};
+};
+
+/**
+ * @class GrainVisQueue
+ * @brief Lock-free single-producer ring of spawned grains for the visualizer.
+ *
+ * The AudioEngine collects the grains it spawns in a block and pushes them in
+ * one batch; the GUI drains everything queued in one bulk copy per frame.
+ * Both sides pay one FIFO handshake per batch rather than one per grain.
+ * Records that do not fit are dropped and counted, so the GUI can tell when
+ * its picture is incomplete.
+ */
+class GrainVisQueue {
+public:
+  /** About a second of grains at the highest density, so a stalled GUI
+   * frame or two loses nothing. */
+  static constexpr int kCapacity = 8192;
+
+  /** Queues up to count records. Wait-free and allocation-free; audio thread
+   * only. Returns the number queued; the rest are counted as dropped. */
+  int push(const GrainInfoForVis* records, int count) noexcept;
+
+  /** Appends every queued record to out and returns how many were appended.
+   * Single consumer; normally the GUI thread. */
+  int drain(std::vector<GrainInfoForVis>& out);
+
+  int getNumReady() const { return fifo_.getNumReady(); }
+  /** Records dropped because the ring was full, since the last reset. */
+  uint32_t getNumDropped() const { return dropped_.load(); }
+  void resetDropped() { dropped_.store(0); }
+
+private:
+  juce::AbstractFifo fifo_{kCapacity};
+  std::array<GrainInfoForVis, kCapacity> records_{};
+  std::atomic<uint32_t> dropped_{0};
+};
@@ -1,6 +1,9 @@
 #pragma once
 
-#include <vector>
+#include "TripleBuffer.h"
+
+#include <array>
+#include <cstddef>
 
 struct InertialNote {
   int noteNumber{};
@@ -10,15 +13,75 @@ struct InertialNote {
   double ageInBars{};
 };
 
+/**
+ * Remembers recent notes as slowly decaying LFOs. Each note's influence
+ * halves every bar and the note is forgotten below an eighth of its start;
+ * getModulationValue() sums sin(2 * pi * age) * influence over the notes.
+ *
+ * The notes live in a fixed ring, oldest first, stored as parallel arrays.
+ * Between updates every note ages by the same number of bars, so update()
+ * decays all influences by one shared factor and advances every LFO by one
+ * shared rotation; only a note's first update, or a transport jump, evaluates
+ * the closed form. When the ring is full the weakest note makes way.
+ */
 class InertialHistoryManager {
 public:
+  /** Notes remembered at once. addNote() is called on the audio thread, so the
+   * history has a fixed capacity. */
+  static constexpr size_t kMaxNotes = 128;
+
+  /** The remembered notes as they stood when publishSnapshot() was called,
+   * oldest first. */
+  struct Snapshot {
+    size_t numNotes = 0;
+    std::array<InertialNote, kMaxNotes> notes{};
+  };
+
+  /** Adds a note; if the history is full, the note with the least influence
+   * (the oldest of equals) is forgotten first. */
   void addNote(int noteNumber, float velocity, double currentPpq);
   void update(double currentPpq, double ppqPerBar);
-  float getModulationValue();
+  float getModulationValue() const;
+
+  /** Audio thread only; other threads read snapshots instead. index counts
+   * from the oldest note. */
+  size_t getNumNotes() const { return numNotes_; }
+  InertialNote getNote(size_t index) const;
+
+  /** Copies the current notes for acquireSnapshot(). Called once per block
+   * on the audio thread; never blocks or allocates. */
+  void publishSnapshot() noexcept;
 
-  size_t getNumNotes() const { return notes_.size(); }
-  const InertialNote& getNote(size_t index) const { return notes_.at(index); }
+  /** The newest published snapshot, or nullptr if nothing was published
+   * since the last call. Valid until the next call; one reader thread only. */
+  const Snapshot* acquireSnapshot() noexcept { return snapshots_.acquire(); }
 
 private:
-  std::vector<InertialNote> notes_;
+  static constexpr size_t kIndexMask = kMaxNotes - 1;
+  static_assert((kMaxNotes & kIndexMask) == 0, "kMaxNotes must be 2^n");
+
+  size_t slot(size_t index) const { return (head_ + index) & kIndexMask; }
+  bool isExpired(size_t k) const {
+    return influences_[k] < initialInfluences_[k] * 0.125f;
+  }
+  void evaluateClosedForm(size_t k, double currentPpq, double ppqPerBar);
+  void moveSlot(size_t from, size_t to);
+  void removeAt(size_t index);
+
+  // One entry per slot; slot(0) to slot(numNotes_ - 1) are live.
+  std::array<int, kMaxNotes> noteNumbers_{};
+  std::array<float, kMaxNotes> initialInfluences_{};
+  std::array<float, kMaxNotes> influences_{};
+  std::array<double, kMaxNotes> startPpqs_{};
+  std::array<double, kMaxNotes> ages_{};       // In bars
+  std::array<float, kMaxNotes> lfoSines_{};    // sin(2 * pi * age)
+  std::array<float, kMaxNotes> lfoCosines_{};  // cos(2 * pi * age)
+
+  size_t head_ = 0;  // Slot of the oldest note
+  size_t numNotes_ = 0;
+  size_t numNew_ = 0;  // Newest notes not yet updated
+  double lastPpq_ = 0.0;
+  double lastPpqPerBar_ = 0.0;  // 0 until the first update()
+
+  TripleBuffer<Snapshot> snapshots_;
 };
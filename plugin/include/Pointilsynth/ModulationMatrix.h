@@ -0,0 +1,133 @@
+#pragma once
+
+#include "TripleBuffer.h"
+
+#include <array>
+#include <cstdint>
+
+/**
+ * @class ModulationMatrix
+ * @brief Block-rate modulation sources and a sparse routing table.
+ *
+ * The sources are two LFOs, an ADSR envelope triggered by MIDI notes and the
+ * InertialHistoryManager's modulation value. The AudioEngine evaluates them
+ * once per sub-block with process(). Each route adds source * depth to one
+ * destination, and the StochasticModel applies the sums to every grain
+ * spawned in that sub-block, so modulation costs nothing per sample or per
+ * grain.
+ *
+ * Routes and source settings are changed from one control thread (usually the
+ * message thread) and reach the audio thread through a TripleBuffer at the
+ * next process().
+ */
+class ModulationMatrix {
+public:
+  enum class Source : uint8_t { Lfo1, Lfo2, Envelope, Inertia };
+  static constexpr int kNumSources = 4;
+  static constexpr int kNumLfos = 2;
+
+  /** Pitch and dispersion offsets are in semitones, pan and pan spread in
+   * pan units. Density and duration offsets are in octaves: they scale the
+   * parameter by 2^offset. */
+  enum class Destination : uint8_t {
+    Pitch,
+    Dispersion,
+    Pan,
+    PanSpread,
+    Density,
+    Duration
+  };
+  static constexpr int kNumDestinations = 6;
+
+  static constexpr int kMaxRoutes = 16;
+
+  enum class LfoShape : uint8_t { Sine, Triangle, Saw, Square };
+
+  struct LfoSettings {
+    float rateHz = 1.0f;
+    LfoShape shape = LfoShape::Sine;
+  };
+
+  struct EnvelopeSettings {
+    float attackMs = 10.0f;
+    float decayMs = 200.0f;
+    float sustain = 0.7f;  // 0 to 1
+    float releaseMs = 500.0f;
+  };
+
+  /** Sum of the routed source values per destination, indexed by
+   * Destination. */
+  using Offsets = std::array<float, kNumDestinations>;
+
+  //==============================================================================
+  // Control thread
+  //==============================================================================
+  /** Adds a route; returns false if kMaxRoutes are already set. Routes to the
+   * same destination add up. */
+  bool addRoute(Source source, Destination destination, float depth);
+  void clearRoutes();
+  int getNumRoutes() const { return staging_.numRoutes; }
+
+  /** index is 0 or 1 for Source::Lfo1 or Source::Lfo2. */
+  void setLfo(int index, LfoSettings settings);
+  void setEnvelope(EnvelopeSettings settings);
+
+  //==============================================================================
+  // Audio thread
+  //==============================================================================
+  void prepare(double sampleRate);
+
+  /** Restarts the envelope's attack from its current level; velocity is 0-1.
+   * The matrix does not track notes: the AudioEngine calls noteOn() for every
+   * note on and noteOff() once no voice is held any more. */
+  void noteOn(float velocity);
+  /** Releases the envelope unless it is already idle or releasing. */
+  void noteOff();
+
+  /** Evaluates the sources at the start of the next numSamples samples,
+   * sums the routes and advances the sources past them. inertia is the
+   * InertialHistoryManager's modulation value, clamped to [-1, 1]. */
+  void process(int numSamples, float inertia);
+
+  /** Whether any current route reads source, so an unused source need not be
+   * computed before process(). */
+  bool isRouted(Source source) const;
+
+  /** Results of the last process(). */
+  const Offsets& getOffsets() const { return offsets_; }
+  float getSourceValue(Source source) const {
+    return sourceValues_[static_cast<size_t>(source)];
+  }
+
+private:
+  enum class EnvelopeStage { Idle, Attack, Decay, Sustain, Release };
+
+  // Everything the control thread sets, with routes as flat arrays.
+  struct Settings {
+    int numRoutes = 0;
+    std::array<Source, kMaxRoutes> sources{};
+    std::array<Destination, kMaxRoutes> destinations{};
+    std::array<float, kMaxRoutes> depths{};
+    std::array<LfoSettings, kNumLfos> lfos{};
+    EnvelopeSettings envelope;
+  };
+
+  void publishSettings();
+  float lfoValue(int index) const;
+  void advanceEnvelope(int numSamples);
+  float msToSamples(float ms) const;
+
+  Settings staging_;  // Control thread's copy
+  TripleBuffer<Settings> published_;
+  Settings settings_;  // Audio thread's copy
+
+  double sampleRate_ = 44100.0;
+  std::array<double, kNumLfos> lfoPhases_{};  // 0 to 1
+  EnvelopeStage envelopeStage_ = EnvelopeStage::Idle;
+  float envelopeLevel_ = 0.0f;
+  float envelopeVelocity_ = 0.0f;
+  float releaseStep_ = 0.0f;  // Level lost per sample while releasing
+
+  std::array<float, kNumSources> sourceValues_{};
+  Offsets offsets_{};
+};
@@ -4,6 +4,9 @@
 #include <juce_audio_basics/juce_audio_basics.h> // For juce::Random
 #include <cmath> // For std::sin, std::fmod
 #include <limits> // For std::numeric_limits
+#include <cstdint>
+
+#include "FastMath.h"
 
 namespace Pointilsynth
 {
@@ -36,6 +39,25 @@ public:
         osc.setFrequency(frequency, true);
     }
 
+    Waveform getWaveform() const { return currentWaveform; }
+
+    //==============================================================================
+    // Stateless waveform functions used by the grain render kernels. Each grain
+    // owns its phase (normalised to [0, 1)), so these take it as an argument
+    // and have no data-dependent branches.
+    static float sine(float phase) { return Pointilsynth::fastSin2Pi(phase); }
+    static float saw(float phase) { return 2.0f * phase - 1.0f; }
+    static float square(float phase) { return phase < 0.5f ? 1.0f : -1.0f; }
+
+    // xorshift32 white noise in [-1, 1]. state must be non-zero.
+    static float noise(uint32_t& state)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return static_cast<float>(state) * (2.0f / 4294967296.0f) - 1.0f;
+    }
+
     void setWaveform(Waveform newWaveform)
     {
         currentWaveform = newWaveform;
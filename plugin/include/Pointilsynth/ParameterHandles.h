@@ -0,0 +1,24 @@
+#pragma once
+
+#include <atomic>
+
+/**
+ * @struct ParameterHandles
+ * @brief Cached pointers to the raw parameter values owned by the APVTS.
+ *
+ * ConfigManager resolves these once with getRawParameterValue() so the audio
+ * thread can poll parameters without string lookups or listener callbacks.
+ * A default constructed table is unbound and every pointer is null.
+ */
+struct ParameterHandles {
+  std::atomic<float>* pitch{};
+  std::atomic<float>* dispersion{};
+  std::atomic<float>* avgDuration{};
+  std::atomic<float>* durationVariation{};
+  std::atomic<float>* pan{};
+  std::atomic<float>* panSpread{};
+  std::atomic<float>* density{};
+  std::atomic<float>* temporalDistribution{};
+
+  bool isBound() const { return pitch != nullptr; }
+};
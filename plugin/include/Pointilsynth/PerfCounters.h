@@ -0,0 +1,84 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <array>
+#include <cstdint>
+
+/**
+ * @class PerfCounters
+ * @brief Hardware performance counters for the calling thread (Linux only).
+ *
+ * Opens cycles, instructions, L1 data cache misses, last-level cache misses
+ * and branch misses as one perf_event_open group, so read() returns all of
+ * them from a single system call. Counting is restricted to user space, which
+ * works with the default perf_event_paranoid setting. Counters the CPU or
+ * hypervisor does not provide read as zero; isCounting() tells them apart.
+ *
+ * When other perf users need the same hardware the kernel multiplexes the
+ * group, and it counts only part of the time it is enabled. Each reading
+ * carries both times, so a difference of readings can tell whether it
+ * covers its whole interval (see Counts::isComplete()).
+ *
+ * The counters follow the thread that called open(). read() is a system call:
+ * cheap enough to call a few times per block, but not per sample. On other
+ * platforms isSupported() is false and open() always fails.
+ */
+class PerfCounters {
+public:
+  enum Counter {
+    kCycles,
+    kInstructions,
+    kL1DataMisses,
+    kLastLevelMisses,
+    kBranchMisses,
+    kNumCounters
+  };
+
+  struct Counts {
+    std::array<uint64_t, kNumCounters> values{};
+    // Nanoseconds the group was enabled, and actually counting.
+    uint64_t timeEnabled = 0;
+    uint64_t timeRunning = 0;
+
+    uint64_t operator[](int counter) const {
+      return values[static_cast<size_t>(counter)];
+    }
+    Counts& operator+=(const Counts& other);
+    /** Counter-wise difference; counters never run backwards. */
+    Counts operator-(const Counts& other) const;
+    /** True if the group counted for all of the time it was enabled, so the
+     * values are exact rather than missing whatever was multiplexed out. */
+    bool isComplete() const {
+      return timeEnabled > 0 && timeRunning >= timeEnabled;
+    }
+  };
+
+  PerfCounters() = default;
+  ~PerfCounters();
+
+  /** True if this build can open counters at all. */
+  static bool isSupported();
+  static const char* getName(int counter);
+
+  /** Opens the counters for the calling thread. Returns false if the cycle
+   * counter could not be opened, e.g. without permission. */
+  bool open();
+  void close();
+  bool isOpen() const { return groupFd_ >= 0; }
+  bool isCounting(int counter) const {
+    return groupSlot_[static_cast<size_t>(counter)] >= 0;
+  }
+
+  /** Current counter values, or zeros if not open. */
+  Counts read() const noexcept;
+
+private:
+  int groupFd_ = -1;
+  std::array<int, kNumCounters> fds_{-1, -1, -1, -1, -1};
+  // Position of each counter in the group read, or -1 if it is not counting.
+  std::array<int, kNumCounters> groupSlot_{-1, -1, -1, -1, -1};
+  int numInGroup_ = 0;
+
+  JUCE_DECLARE_NON_COPYABLE(PerfCounters)
+};
@@ -17,8 +17,8 @@ class PointillisticSynthAudioProcessorEditor
 public:
   PointillisticSynthAudioProcessorEditor(
       audio_plugin::AudioPluginAudioProcessor&,
-      juce::AbstractFifo& fifo,
-      GrainInfoForVis* buffer);
+      GrainVisQueue& visQueue,
+      GrainDensityGrid& densityGrid);
   ~PointillisticSynthAudioProcessorEditor() override;
 
   void paint(juce::Graphics&) override;
@@ -4,6 +4,8 @@
 #include <juce_dsp/juce_dsp.h>
 #include "PointilismInterfaces.h"  // Added for AudioEngine and StochasticModel
 #include "ConfigManager.h"
+#include "RtLogger.h"
+#include "SessionTrace.h"
 #include <array>
 
 namespace audio_plugin {
@@ -15,6 +17,10 @@ public:
     return audioEngine.getStochasticModel();
   }
   std::shared_ptr<ConfigManager> getConfigManager() { return configManager; }
+  /** Per-block render statistics, drained by the debug panel. */
+  RenderTelemetry& getRenderTelemetry() { return renderTelemetry_; }
+  /** Live grain snapshots, read by the visualization. */
+  GrainSnapshotBuffer& getGrainSnapshots() { return grainSnapshots_; }
   ~AudioPluginAudioProcessor() override;
 
   void prepareToPlay(double sampleRate, int samplesPerBlock) override;
@@ -44,13 +50,22 @@ public:
   void getStateInformation(juce::MemoryBlock& destData) override;
   void setStateInformation(const void* data, int sizeInBytes) override;
 
+  /** Records every processBlock() call's input to file until
+   * stopSessionCapture(); see SessionTrace. Returns false if the file could
+   * not be opened. */
+  bool startSessionCapture(const juce::File& file);
+  void stopSessionCapture();
+  bool isCapturingSession() const { return sessionTrace_.isCapturing(); }
+
 private:
   std::shared_ptr<ConfigManager> configManager;
-  static constexpr int kVisualizationFifoSize = 512;
-  juce::AbstractFifo visualizationFifo{kVisualizationFifoSize};
-  std::array<GrainInfoForVis, kVisualizationFifoSize> visualizationBuffer{};
+  GrainVisQueue visQueue_;  // Declared before audioEngine, which fills it
+  GrainDensityGrid densityGrid_;  // Likewise
+  GrainSnapshotBuffer grainSnapshots_;  // Likewise
+  RtLogger rtLogger_;  // Declared before audioEngine, which logs into it
+  SessionTrace::Writer sessionTrace_;
+  RenderTelemetry renderTelemetry_;  // Declared before audioEngine too
   AudioEngine audioEngine;  // Added AudioEngine member
-  std::atomic<int> activeMidiNote_{-1};
   juce::dsp::Compressor<float> outputCompressor;
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioPluginAudioProcessor)
@@ -3,13 +3,22 @@
 // Modern, modular JUCE includes instead of the deprecated JuceHeader.h
 #include <juce_core/juce_core.h>
 #include <juce_audio_basics/juce_audio_basics.h>
-#include <juce_audio_processors/juce_audio_processors.h>
 
 #include "Oscillator.h"
 #include "GrainEnvelope.h"
+#include "GrainDensityGrid.h"
+#include "GrainSnapshot.h"
+#include "GrainVisQueue.h"
 #include "InertialHistoryManager.h"
-#include "ConfigManager.h"
-
+#include "ModulationMatrix.h"
+#include "ParameterHandles.h"
+#include "SimdKernels.h"
+#include "RtLogger.h"
+#include "RenderTelemetry.h"
+#include "VoiceAllocator.h"
+
+#include <array>
+#include <cstdint>
 #include <vector>
 #include <random>
 #include <atomic>
@@ -25,6 +34,7 @@
 struct Grain {
   bool isAlive = true;  // Flag to mark for cleanup when the grain is finished.
   int id = 0;           // Unique identifier for visualization purposes.
+  int voice = 0;        // VoiceAllocator voice that spawned the grain.
 
   // Core sonic properties
   float pitch = 60.0f;        // MIDI note number.
@@ -36,16 +46,17 @@ struct Grain {
   int ageInSamples = 0;  // How many samples this grain has been playing.
   double sourceSamplePosition =
       0.0;  // The starting position within the source audio file.
-};
-
-/**
- * @struct GrainInfoForVis
- * @brief Lightweight data passed from the AudioEngine to the GUI thread.
- */
-struct GrainInfoForVis {
-  float pan{};
-  float pitch{};
-  float durationSeconds{};
+  int startOffset = 0;  // Sample offset in the current block where playback
+                        // begins. Reset to 0 once the block is rendered.
+
+  // Render state captured at spawn so the render kernels run branch-free.
+  int kernelGroup = 0;          // Source/envelope render kernel group
+  float gainLeft = 0.0f;        // amplitude * constant-power pan gain (L)
+  float gainRight = 0.0f;       // amplitude * constant-power pan gain (R)
+  float phase = 0.0f;           // Oscillator phase, normalised to [0, 1)
+  float phaseIncrement = 0.0f;  // Oscillator phase advance per sample
+  double playbackRate = 1.0;    // Source read advance per sample
+  uint32_t noiseState = 1;      // Per-grain noise generator state (non-zero)
 };
 
 /**
@@ -58,8 +69,6 @@ struct GrainInfoForVis {
  * will call the 'generate' methods. Parameters are atomic to ensure thread
  * safety.
  */
-class ConfigManager;  // Forward declaration
-
 class StochasticModel {
 public:
   // This enum will be used by the UI to select the temporal distribution model.
@@ -71,7 +80,9 @@ public:
   //==============================================================================
   // Parameter Setters (called by the UI thread)
   //==============================================================================
-  explicit StochasticModel(std::shared_ptr<ConfigManager> cfg = {});
+  /** Polls the parameters behind handles, if bound. They must outlive the
+   * model; ConfigManager::getParameterHandles() provides them in the plugin. */
+  explicit StochasticModel(ParameterHandles handles = {});
 
   void setPitchAndDispersion(float centralPitchValue, float dispersionValue) {
     pitch.store(centralPitchValue);
@@ -164,12 +175,90 @@ public:
    */
   int getSamplesUntilNextEvent();
 
+  /** Pull of one voice's MIDI note on its grains' pitch. */
+  struct MidiInfluence {
+    float targetPitch = 60.0f;  // MIDI note number
+    float amount = 0.0f;        // 0 (model pitch) to 1 (the note)
+  };
+
   /** Fills a Grain struct with new, randomized properties based on the current
-   * model. */
-  void generateNewGrain(Grain& newGrain);
+   * model, with its pitch pulled towards the spawning voice's note. */
+  void generateNewGrain(Grain& newGrain, MidiInfluence influence);
+  void generateNewGrain(Grain& newGrain) {
+    generateNewGrain(newGrain, MidiInfluence{});
+  }
+
+  /** Reads the cached APVTS parameter handles and applies any value that has
+   * changed since the previous poll. Called once per block by the AudioEngine.
+   */
+  void pollParameters();
+
+  /** Advances the density, pitch and pan ramps by the given number of samples.
+   * The AudioEngine calls this as it walks through a block so that grains
+   * sample the smoothed values at their onset offset. */
+  void advanceSmoothing(int numSamples);
+
+  /** Density at the current position of the smoothing ramp, with the
+   * current modulation applied. */
+  float getSmoothedDensity() const {
+    return currentValue(densitySmoother_, globalDensity_) *
+           modulation_.densityScale;
+  }
+
+  /** Applies the ModulationMatrix offsets to grains generated until the next
+   * call. Called by the AudioEngine once per sub-block. */
+  void setModulation(const ModulationMatrix::Offsets& offsets);
+
+  /** Length of the ramp applied when density, pitch or pan change. */
+  static constexpr double kParameterRampSeconds = 0.05;
+
+  /** Routes audio-thread diagnostics to logger; nullptr disables them. The
+   * logger must outlive the model. */
+  void setLogger(RtLogger* logger) { logger_ = logger; }
+
+  /** Reseeds the generator and discards cached distribution state, so two
+   * models with the same seed and parameters generate identical grains. Not
+   * thread-safe; call before rendering starts. */
+  void setRandomSeed(uint32_t seed);
 
 private:
-  std::shared_ptr<ConfigManager> config_;
+  void pollParameterHandles();
+
+  // Returns the smoothed value while a ramp is in progress, otherwise the
+  // parameter itself so direct setters take effect without a running engine.
+  static float currentValue(const juce::SmoothedValue<float>& smoother,
+                            const std::atomic<float>& parameter) {
+    return smoother.isSmoothing()
+               ? smoother.getCurrentValue()
+               : parameter.load(std::memory_order_relaxed);
+  }
+
+  ParameterHandles handles_;
+  RtLogger* logger_ = nullptr;
+
+  // ModulationMatrix offsets in the form generateNewGrain() uses them. Only
+  // touched on the audio thread.
+  struct Modulation {
+    float pitch = 0.0f;
+    float dispersion = 0.0f;
+    float pan = 0.0f;
+    float panSpread = 0.0f;
+    float densityScale = 1.0f;
+    float durationScale = 1.0f;
+  } modulation_;
+
+  // Raw values seen on the previous poll. Only changed parameters are applied
+  // so values set directly (e.g. by PresetManager) persist until automated.
+  struct PolledValues {
+    float pitch{};
+    float dispersion{};
+    float avgDuration{};
+    float durationVariation{};
+    float pan{};
+    float panSpread{};
+    float density{};
+    float temporalDistribution{};
+  } lastPolled_;
   // Private members would include std::mt19937 for random number generation,
   // and various std::distribution objects (e.g., normal_distribution,
   // uniform_real_distribution, poisson_distribution) to model the parameters.
@@ -201,9 +290,11 @@ private:
   std::atomic<float> centralPan{0.0f};  // -1 (L) to 1 (R)
   std::atomic<float> panSpread{0.5f};   // 0 (no spread) to 1 (full spread)
 
-  // MIDI influence parameters
-  std::atomic<float> midiTargetPitch_{60.0f};
-  std::atomic<float> midiInfluence_{0.0f};
+  // Per-block ramps towards the latest density, pitch and pan values. Only
+  // touched on the audio thread.
+  juce::SmoothedValue<float> densitySmoother_{10.0f};
+  juce::SmoothedValue<float> pitchSmoother_{60.0f};
+  juce::SmoothedValue<float> panSmoother_{0.0f};
 
   // Distributions - these should be updated when parameters change.
   // For simplicity, the setters currently just store values. A more complete
@@ -220,9 +311,6 @@ private:
 
 public:  // Public setter for sample rate, to be called by AudioEngine
   void setSampleRate(double sr);
-
-  // Method to set MIDI influence
-  void setMidiInfluence(int noteNumber, float influenceAmount);
 };
 
 /**
@@ -238,9 +326,9 @@ class AudioEngine {
 public:
   enum class GrainSourceType { Oscillator, AudioSample };
 
-  explicit AudioEngine(std::shared_ptr<ConfigManager> cfg = {},
-                       juce::AbstractFifo* visFifo = nullptr,
-                       GrainInfoForVis* visBuffer = nullptr);
+  explicit AudioEngine(ParameterHandles handles = {},
+                       GrainVisQueue* visQueue = nullptr,
+                       GrainDensityGrid* densityGrid = nullptr);
 
   /** Called by the host to prepare the engine for playback. */
   void prepareToPlay(double sampleRate, int samplesPerBlock);
@@ -248,22 +336,96 @@ public:
   /**
    * Processes a block of audio. This is where all DSP happens.
    * This method will be called repeatedly on the real-time audio thread.
+   * MIDI notes take effect at their sample position within the block.
    */
   void processBlock(juce::AudioBuffer<float>& buffer,
                     juce::MidiBuffer& midiMessages,
                     const juce::AudioPlayHead::PositionInfo& pos);
 
+  /** Largest internal sub-block the engine renders in one pass. */
+  static constexpr int kMaxSubBlockSize = 256;
+  /** Default internal sub-block size; also the engine's control rate. */
+  static constexpr int kDefaultSubBlockSize = 64;
+  /** Grain pool size reserved in prepareToPlay. Onsets that arrive while the
+   * pool is full are skipped so the audio thread never reallocates it. */
+  static constexpr int kMaxGrains = 4096;
+
+  /**
+   * Sets the fixed internal sub-block size. Host blocks are split into
+   * sub-blocks of this many samples; spawning, parameter snapshots and the
+   * inertial history update run once per sub-block. Clamped to
+   * [1, kMaxSubBlockSize].
+   */
+  void setSubBlockSize(int numSamples);
+  int getSubBlockSize() const { return subBlockSize_.load(); }
+
   /** Loads a user-provided audio file to be used as a grain source. */
   void loadAudioSample(const juce::File& audioFile);
 
+  /** Uses a copy of audio as the grain source. Like loadAudioSample(), this
+   * must not be called while the engine is processing. */
+  void setSourceAudio(const juce::AudioBuffer<float>& audio);
+
   /** Selects an internal waveform to be used as a grain source. */
   void setGrainSource(int internalWaveformId);
 
+  /** Chooses whether new grains read the oscillator or the loaded sample. */
+  void setSourceType(GrainSourceType type) { currentSourceType_.store(type); }
+
+  /** Selects the envelope shape applied to newly spawned grains. */
+  void setEnvelopeShape(GrainEnvelope::Shape shape);
+
+  /** Largest grain burst setNoteOnBurst() accepts. */
+  static constexpr int kMaxNoteOnBurst = 32;
+
+  /** Spawns numGrains grains from a note's voice at the note-on sample, on
+   * top of its regular stream, so a note sounds at once. 0, the default,
+   * disables the burst. Clamped to [0, kMaxNoteOnBurst]. */
+  void setNoteOnBurst(int numGrains);
+  int getNoteOnBurst() const { return noteOnBurst_.load(); }
+
   /** Provides a non-owning pointer to the model for the UI to control. */
   StochasticModel* getStochasticModel() { return &stochasticModel; }
 
-  /** Applies MIDI note and velocity influence to the stochastic model. */
-  void applyMidiInfluence(int noteNumber, float normalizedVelocity);
+  /** Routes and source settings may be changed from one control thread
+   * while the engine runs; see ModulationMatrix. */
+  ModulationMatrix& getModulationMatrix() { return modulation_; }
+
+  /**
+   * Makes rendering deterministic: reseeds the stochastic model and restarts
+   * grain ids, which also seed each noise grain. With the same seed,
+   * parameters, MIDI and host block sizes the output is bit-identical from
+   * run to run. Call before prepareToPlay(), not while processing.
+   */
+  void setRandomSeed(uint32_t seed);
+
+  /** Routes audio-thread diagnostics to logger; nullptr disables them. */
+  void setLogger(RtLogger* logger) {
+    logger_ = logger;
+    stochasticModel.setLogger(logger);
+  }
+
+  /** Pushes one record per processBlock() into telemetry; nullptr disables
+   * it. The telemetry must outlive the engine. While the telemetry requests
+   * hardware counters, they are opened on the thread calling processBlock().
+   */
+  void setTelemetry(RenderTelemetry* telemetry) { telemetry_ = telemetry; }
+
+  /** Publishes the live grains to snapshots at the end of every block while
+   * they are enabled; nullptr disables it. Must outlive the engine. */
+  void setGrainSnapshots(GrainSnapshotBuffer* snapshots) {
+    grainSnapshots_ = snapshots;
+  }
+
+  /** Number of grains alive after the last processBlock(). Only meaningful on
+   * the thread that calls processBlock(). */
+  int getNumActiveGrains() const { return static_cast<int>(grains.size()); }
+
+  /** Number of voices spawning or still sounding after the last
+   * processBlock(). Each held MIDI note plays its own voice, up to
+   * StochasticModel::getGlobalNumVoices(); see VoiceAllocator. Only
+   * meaningful on the thread that calls processBlock(). */
+  int getNumActiveVoices() const { return voices_.getNumActiveVoices(); }
 
 private:
   double currentSampleRate = 44100.0;
@@ -272,26 +434,103 @@ private:
   // The model that dictates the properties of new grains.
   StochasticModel stochasticModel;
 
-  std::shared_ptr<ConfigManager> config_;
-
   // A pre-allocated vector to hold all active grains. We reserve to avoid
   // real-time memory allocation.
   std::vector<Grain> grains;
 
-  // A counter to determine when to ask the StochasticModel for a new grain.
-  int samplesUntilNextGrain = 0;
+  // One grain stream per held note, each with its own spawn countdown. When
+  // density moves, a voice's remaining countdown is rescaled instead of
+  // running out at the rate it was scheduled with.
+  VoiceAllocator voices_;
+  RtLogger* logger_ = nullptr;
 
   // Placeholder for the loaded audio file data.
   juce::AudioBuffer<float> sourceAudio;
 
-  Pointilsynth::Oscillator oscillator_;
-  GrainEnvelope grainEnvelope_;
+  // Source and envelope settings captured by each grain when it spawns.
   std::atomic<GrainSourceType> currentSourceType_{GrainSourceType::Oscillator};
-
-  juce::AbstractFifo* visualizationFifo_{};
-  GrainInfoForVis* visualizationBuffer_{};
+  std::atomic<Pointilsynth::Oscillator::Waveform> currentWaveform_{
+      Pointilsynth::Oscillator::Waveform::Sine};
+  std::atomic<GrainEnvelope::Shape> envelopeShape_{
+      GrainEnvelope::Shape::Trapezoid};
+  std::atomic<int> noteOnBurst_{0};
+
+  // Grains spawned this block, pushed to visQueue_ in one batch at the end
+  // of the block, or sooner if the batch fills.
+  static constexpr int kMaxVisBatch = 256;
+  void flushVisBatch();
+  GrainVisQueue* visQueue_{};
+  std::array<GrainInfoForVis, kMaxVisBatch> visBatch_{};
+  int numVisBatch_ = 0;
+  // When enabled, grains go to the density grid instead of visQueue_. Read
+  // once per block.
+  GrainDensityGrid* densityGrid_{};
+  bool densityGridThisBlock_ = false;
+  // Likewise for the live grain snapshot, which also replaces visQueue_.
+  void publishGrainSnapshot();
+  GrainSnapshotBuffer* grainSnapshots_{};
+  bool snapshotThisBlock_ = false;
 
   InertialHistoryManager inertialHistoryManager_;
-
-  void triggerNewGrain();
+  ModulationMatrix modulation_;
+
+  std::atomic<int> subBlockSize_{kDefaultSubBlockSize};
+  // Scratch mix buffers for one sub-block. Small enough to stay in L1.
+  std::array<float, kMaxSubBlockSize> scratchLeft_{};
+  std::array<float, kMaxSubBlockSize> scratchRight_{};
+  std::array<float, kMaxSubBlockSize> envelopeScratch_{};
+  std::array<float, kMaxSubBlockSize> sourceScratch_{};
+
+  // SIMD kernel variant for this CPU, refreshed in prepareToPlay.
+  const SimdKernels::KernelSet* simdKernels_ = &SimdKernels::active();
+
+  // Indices of live grains grouped by render kernel, rebuilt every sub-block.
+  // One bucket per GrainRenderKernels group; reserved in prepareToPlay.
+  static constexpr int kNumKernelGroups = 10;
+  std::array<std::vector<int>, kNumKernelGroups> kernelBuckets_;
+
+  // Render telemetry. grainsSpawnedThisBlock_ is only touched on the audio
+  // thread, and only when RenderTelemetry::kEnabled.
+  RenderTelemetry* telemetry_ = nullptr;
+  int grainsSpawnedThisBlock_ = 0;
+
+  // Hardware counters, opened on the audio thread on request. perfLast_ is
+  // the reading at the previous stage boundary; perfStages_ accumulates each
+  // stage's share of the current block. perfOpenFailed_ stops the engine
+  // retrying a failed open every block until the request is withdrawn.
+  PerfCounters perfCounters_;
+  bool perfActive_ = false;
+  bool perfOpenFailed_ = false;
+  PerfCounters::Counts perfLast_;
+  std::array<PerfCounters::Counts, RenderTelemetry::kNumStages> perfStages_{};
+
+  void triggerNewGrain(int startOffset, int voice);
+  bool beginPerfBlock();
+  /** Charges events since the previous boundary to stage. */
+  void endPerfStage(RenderTelemetry::Stage stage) noexcept {
+    if constexpr (RenderTelemetry::kEnabled) {
+      if (!perfActive_)
+        return;
+      const auto now = perfCounters_.read();
+      perfStages_[static_cast<size_t>(stage)] += now - perfLast_;
+      perfLast_ = now;
+    }
+  }
+  void pushTelemetry(int numSamples, juce::int64 startTicks, int grainsKilled);
+  /** The host block's MIDI not yet applied, in sample order. */
+  struct MidiQueue {
+    juce::MidiBufferIterator next;
+    juce::MidiBufferIterator end;
+    int blockLength = 0;  // Later events are applied at the last sample.
+  };
+  void handleMidiEvent(const juce::MidiMessage& msg,
+                       int offset,
+                       double ppqPosition);
+  void renderSubBlock(juce::AudioBuffer<float>& buffer,
+                      int startSample,
+                      int numSamples,
+                      double ppqPosition,
+                      double ppqPerSample,
+                      double ppqPerBar,
+                      MidiQueue& midi);
 };
@@ -32,6 +32,12 @@ public:
    */
   bool loadPreset(const juce::File& fileToLoad);
 
+  /**
+   * Applies the parameters in a parsed preset to the StochasticModel. Keys
+   * that are missing leave the model unchanged.
+   */
+  void applyPreset(const nlohmann::json& preset);
+
 private:
   StochasticModel& model_;
 
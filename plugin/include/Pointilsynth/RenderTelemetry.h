@@ -0,0 +1,132 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include "PerfCounters.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Set by the POINTILSYNTH_ENABLE_TELEMETRY CMake option.
+#ifndef POINTILSYNTH_TELEMETRY
+#define POINTILSYNTH_TELEMETRY 1
+#endif
+
+/**
+ * @class RenderTelemetry
+ * @brief Per-block render statistics for the debug panel.
+ *
+ * The AudioEngine pushes one BlockStats record per processBlock() into a
+ * lock-free single-producer ring. The GUI drains the ring on a timer and
+ * summarises the most recent blocks. Pushing never allocates or blocks; when
+ * the ring is full the record is dropped, but overruns are counted on push so
+ * the overrun counter stays exact.
+ *
+ * With POINTILSYNTH_TELEMETRY set to 0, kEnabled is false and the engine's
+ * instrumentation, which is guarded by `if constexpr`, compiles to nothing.
+ *
+ * On Linux the engine can also count hardware events per block and per
+ * engine stage (see PerfCounters). The GUI requests this through
+ * setPerfCountersRequested(); the engine opens the counters on the audio
+ * thread and reports whether that worked through getPerfState().
+ */
+class RenderTelemetry {
+public:
+  static constexpr bool kEnabled = POINTILSYNTH_TELEMETRY != 0;
+  static constexpr int kCapacity = 512;
+
+  /** Stages of AudioEngine::processBlock() that hardware events are
+   * attributed to. */
+  enum Stage {
+    kControlStage,  // MIDI, parameter polling, history, grain spawning
+    kRenderStage,   // Render kernels
+    kOutputStage,   // Copying the scratch mix to the output buffer
+    kCleanupStage,  // Removing dead grains
+    kNumStages
+  };
+  static const char* getStageName(int stage);
+
+  enum class PerfState { Off, Counting, Unavailable };
+
+  struct BlockStats {
+    float renderMicroseconds = 0.0f;  // Time spent in processBlock()
+    float budgetMicroseconds = 0.0f;  // Audio duration of the block
+    int liveGrains = 0;               // Alive at the end of the block
+    int grainsSpawned = 0;
+    int grainsKilled = 0;
+    int sampleGrains = 0;      // Live grains reading the loaded sample
+    int oscillatorGrains = 0;  // Live grains reading an oscillator
+    // Counted, with the counters running for the whole block. A block the
+    // kernel multiplexed the counters out of for a while is left uncounted.
+    bool hasPerfCounts = false;
+    std::array<PerfCounters::Counts, kNumStages> stageCounts{};
+
+    /** Render time as a fraction of the budget; above 1 is an overrun. */
+    float getLoad() const {
+      return budgetMicroseconds > 0.0f ? renderMicroseconds / budgetMicroseconds
+                                       : 0.0f;
+    }
+    bool isOverrun() const { return renderMicroseconds > budgetMicroseconds; }
+  };
+
+  /** Load statistics over a run of blocks. Loads are fractions of budget. */
+  struct Summary {
+    int numBlocks = 0;
+    float meanLoad = 0.0f;
+    float p50Load = 0.0f;
+    float p95Load = 0.0f;
+    float p99Load = 0.0f;
+    float maxLoad = 0.0f;
+    int numOverruns = 0;
+    float spawnedPerSecond = 0.0f;
+    float killedPerSecond = 0.0f;
+    BlockStats latest;
+    /** Blocks with hardware counts, and their mean counts per block. */
+    int numPerfBlocks = 0;
+    std::array<std::array<double, PerfCounters::kNumCounters>, kNumStages>
+        perfPerBlock{};
+
+    /** Mean count of counter per block, summed over every stage. */
+    double getPerfTotal(int counter) const;
+  };
+
+  /** Queues a record. Wait-free and allocation-free; audio thread only.
+   * Returns false if the ring was full and the record was dropped. */
+  bool push(const BlockStats& stats) noexcept;
+
+  /**
+   * Appends every queued record to history, then trims history to its newest
+   * maxHistory entries. Single consumer; normally the GUI thread. Returns the
+   * number of records drained.
+   */
+  int drain(std::vector<BlockStats>& history, size_t maxHistory);
+
+  static Summary summarise(const std::vector<BlockStats>& blocks);
+
+  /** Blocks whose render time exceeded their budget since the last reset. */
+  uint32_t getNumOverruns() const { return overruns_.load(); }
+  void resetOverruns() { overruns_.store(0); }
+  /** Records dropped because the ring was full. */
+  uint32_t getNumDropped() const { return dropped_.load(); }
+
+  /** Asks the engine to count hardware events. Any thread. */
+  void setPerfCountersRequested(bool shouldCount) {
+    perfRequested_.store(shouldCount);
+  }
+  bool isPerfCountersRequested() const {
+    return perfRequested_.load(std::memory_order_relaxed);
+  }
+  /** Set by the engine once it has acted on a request. */
+  void setPerfState(PerfState state) { perfState_.store(state); }
+  PerfState getPerfState() const { return perfState_.load(); }
+
+private:
+  juce::AbstractFifo fifo_{kCapacity};
+  std::array<BlockStats, kCapacity> records_{};
+  std::atomic<uint32_t> overruns_{0};
+  std::atomic<uint32_t> dropped_{0};
+  std::atomic<bool> perfRequested_{false};
+  std::atomic<PerfState> perfState_{PerfState::Off};
+};
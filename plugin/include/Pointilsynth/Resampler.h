@@ -7,6 +7,10 @@
 
 #include <cmath> // For std::sin, std::cos, std::abs, std::round
 #include <limits> // For std::numeric_limits
+#include <vector>
+#include <algorithm>
+
+#include "SimdKernels.h"
 
 // Define M_PI if not already defined (e.g., on Windows with MSVC, or if <cmath> doesn't provide it by default)
 // C++17 and later prefer std::numbers::pi from <numbers>
@@ -102,6 +106,72 @@ namespace Resampler {
         return static_cast<float>(outputSample);
     }
 
+    const int NUM_TAPS = 2 * WINDOW_SIDE_POINTS + 1;
+
+    // Windowed-sinc coefficients precomputed for NUM_PHASES + 1 evenly spaced
+    // fractional read offsets in [-0.5, 0.5]. Row r holds the weights of the
+    // NUM_TAPS source samples around the nearest integer position, so a read
+    // becomes two dot products and a linear blend between adjacent rows.
+    class PolyphaseTable {
+    public:
+        static constexpr int NUM_PHASES = 256;
+
+        PolyphaseTable() : coefficients_(static_cast<size_t>((NUM_PHASES + 1) * NUM_TAPS)) {
+            for (int row = 0; row <= NUM_PHASES; ++row) {
+                const double fraction = static_cast<double>(row) / NUM_PHASES - 0.5;
+                for (int tap = 0; tap < NUM_TAPS; ++tap) {
+                    // Same kernel argument as getSample(): readPosition - k.
+                    const double kernelArg = fraction + WINDOW_SIDE_POINTS - tap;
+                    coefficients_[static_cast<size_t>(row * NUM_TAPS + tap)] =
+                        static_cast<float>(sinc(kernelArg) * blackmanWindow(kernelArg));
+                }
+            }
+        }
+
+        const float* getRow(int row) const {
+            return coefficients_.data() + row * NUM_TAPS;
+        }
+
+    private:
+        std::vector<float> coefficients_;
+    };
+
+    // Built on first use. Call once off the audio thread (AudioEngine does so in
+    // prepareToPlay) so the first grain doesn't pay for the construction.
+    inline const PolyphaseTable& getPolyphaseTable() {
+        static const PolyphaseTable table;
+        return table;
+    }
+
+    // Table-driven equivalent of getSample() for a single channel. The window
+    // is clipped to the buffer exactly like getSample()'s zero padding, and the
+    // remaining taps are summed with the active SIMD dot product.
+    inline float getSampleInterpolated(const float* sourceData, int numSamples, double readPosition,
+                                       const SimdKernels::KernelSet& kernels = SimdKernels::active()) {
+        if (sourceData == nullptr || numSamples == 0) {
+            return 0.0f;
+        }
+
+        const int k_center = static_cast<int>(std::round(readPosition));
+        const int firstSample = k_center - WINDOW_SIDE_POINTS;
+        const int firstTap = std::max(0, -firstSample);
+        const int endTap = std::min(NUM_TAPS, numSamples - firstSample);
+        if (endTap <= firstTap) {
+            return 0.0f;
+        }
+
+        const double phase = (readPosition - k_center + 0.5) * PolyphaseTable::NUM_PHASES;
+        const int row = std::clamp(static_cast<int>(phase), 0, PolyphaseTable::NUM_PHASES - 1);
+        const float blend = static_cast<float>(phase - row);
+
+        const auto& table = getPolyphaseTable();
+        const float* samples = sourceData + firstSample + firstTap;
+        const int count = endTap - firstTap;
+        const float lower = kernels.dot(samples, table.getRow(row) + firstTap, count);
+        const float upper = kernels.dot(samples, table.getRow(row + 1) + firstTap, count);
+        return lower + (upper - lower) * blend;
+    }
+
 } // namespace Resampler
 
 #endif // RESAMPLER_H
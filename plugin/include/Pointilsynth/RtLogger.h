@@ -0,0 +1,109 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+/** Messages the audio thread can log. Text lives in RtLogger::getFormat(). */
+enum class RtLogEvent : uint8_t {
+  MidiNoteOn,          // note, velocity
+  MidiNoteOff,         // note
+  MidiInfluenceReset,  // note; its voice was released
+  GrainMidiInfluence,  // base pitch, target pitch, influence, effective pitch
+};
+
+/**
+ * @class RtLogger
+ * @brief Real-time safe replacement for DBG on the audio thread.
+ *
+ * The audio thread writes fixed-size binary records (an event id, a timestamp
+ * and up to kMaxArgs numeric arguments) into a lock-free single-producer ring.
+ * Logging never allocates, formats or blocks; when the ring is full the record
+ * is dropped and counted. A background thread drains the ring, formats each
+ * record and hands the text to a sink (the debugger console or a file).
+ */
+class RtLogger : private juce::Thread {
+public:
+  static constexpr int kCapacity = 1024;
+  static constexpr int kMaxArgs = 4;
+
+  struct Record {
+    juce::int64 ticks = 0;  // juce::Time::getHighResolutionTicks()
+    RtLogEvent event = RtLogEvent::MidiNoteOn;
+    uint8_t numArgs = 0;
+    std::array<float, kMaxArgs> args{};
+  };
+
+  using Sink = std::function<void(const juce::String&)>;
+
+  RtLogger();
+  ~RtLogger() override;
+
+  /**
+   * Queues a record. Wait-free and allocation-free; safe to call from the
+   * audio thread. Returns false if logging is disabled, or if the ring was
+   * full and the record was dropped.
+   */
+  template <typename... Args>
+  bool log(RtLogEvent event, Args... args) noexcept {
+    static_assert(sizeof...(Args) <= kMaxArgs, "Too many log arguments");
+    if (!enabled_.load(std::memory_order_relaxed))
+      return false;
+    Record record;
+    record.ticks = juce::Time::getHighResolutionTicks();
+    record.event = event;
+    record.numArgs = static_cast<uint8_t>(sizeof...(Args));
+    record.args = {static_cast<float>(args)...};
+    return push(record);
+  }
+
+  bool push(const Record& record) noexcept;
+
+  /**
+   * Formats every queued record and passes it to sink, followed by a notice if
+   * records were dropped since the last drain. Must only be called from one
+   * thread at a time; the drain thread does this while it is running.
+   * Returns the number of records drained.
+   */
+  int drain(const Sink& sink);
+
+  /** Logging is enabled while draining; tests may enable it directly and call
+   * drain() themselves. Disabled loggers ignore log() calls. */
+  void setEnabled(bool shouldBeEnabled) { enabled_.store(shouldBeEnabled); }
+  bool isEnabled() const { return enabled_.load(); }
+
+  /** Number of records dropped because the ring was full. */
+  uint32_t getNumDropped() const { return dropped_.load(); }
+
+  static const char* getFormat(RtLogEvent event);
+  static juce::String format(const Record& record);
+
+  /** Starts the background thread, draining into sink every intervalMs. */
+  void startDraining(Sink sink, int intervalMs = 50);
+  /** Drains into juce::Logger::outputDebugString, like DBG. */
+  void startDrainingToConsole();
+  /** Drains into a text file, appending to it if it already exists. */
+  void startDrainingToFile(const juce::File& file);
+  /** Stops the background thread after a final drain. */
+  void stopDraining();
+
+private:
+  void launch(Sink sink, int intervalMs);
+  void run() override;
+
+  juce::AbstractFifo fifo_{kCapacity};
+  std::array<Record, kCapacity> records_{};
+  std::atomic<bool> enabled_{false};
+  std::atomic<uint32_t> dropped_{0};
+  uint32_t droppedReported_ = 0;  // Drain thread only.
+
+  Sink sink_;
+  int intervalMs_ = 50;
+  std::unique_ptr<juce::FileOutputStream> file_;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RtLogger)
+};
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * Capture and replay of host sessions.
+ *
+ * A session trace records, for every processBlock() call, the block size, the
+ * host's PositionInfo, the incoming MIDI and any parameter changes since the
+ * previous block. Replaying it into a fresh processor reproduces the host's
+ * input exactly, faster than real time, which makes production-shaped
+ * automation and MIDI patterns usable as benchmark and regression inputs.
+ *
+ * File layout (native byte order, little-endian on all supported platforms):
+ *   header:  "PSTR", uint32 version, double sampleRate, int32 numParameters,
+ *            then per parameter: uint16 idLength, id bytes, float value
+ *   blocks:  int32 numSamples, uint8 positionFlags, the optional position
+ *            fields that the flags mark present, uint16 numParameterChanges
+ *            of (uint16 index, float value), uint16 numMidiEvents of
+ *            (int32 sampleOffset, uint16 numBytes, bytes)
+ * Parameter values are normalised to [0, 1].
+ */
+namespace SessionTrace {
+
+constexpr uint32_t kVersion = 1;
+
+struct ParameterChange {
+  uint16_t index = 0;
+  float value = 0.0f;
+};
+
+struct Block {
+  int numSamples = 0;
+  juce::AudioPlayHead::PositionInfo position;
+  std::vector<ParameterChange> parameterChanges;
+  juce::MidiBuffer midi;
+};
+
+/**
+ * Records processBlock() input to a trace file.
+ *
+ * captureBlock() runs on the audio thread: it serialises the block into a
+ * preallocated scratch buffer and copies it into a lock-free single-producer
+ * ring, never allocating or blocking. A background thread drains the ring to
+ * disk. If the ring is full the whole block is dropped and counted, so a
+ * trace is either complete or reports how many blocks it lost. The block
+ * after a drop carries every parameter value, so a replay only misses the
+ * dropped blocks' audio and MIDI, not their parameter changes.
+ */
+class Writer : private juce::Thread {
+public:
+  static constexpr int kRingBytes = 1 << 20;
+  static constexpr int kMaxBlockBytes = 1 << 16;
+
+  Writer();
+  ~Writer() override;
+
+  /**
+   * Writes the header and starts capturing. Message thread only; safe while
+   * the audio thread is running. Returns false if the file could not be
+   * opened.
+   */
+  bool start(const juce::File& file, juce::AudioProcessor& processor);
+  /** Stops capturing and flushes everything captured to disk. */
+  void stop();
+  bool isCapturing() const { return capturing_.load(); }
+
+  /** Audio thread. Does nothing unless capturing. */
+  void captureBlock(int numSamples,
+                    const juce::AudioPlayHead::PositionInfo& position,
+                    const juce::MidiBuffer& midi) noexcept;
+
+  /** Blocks lost because the ring was full or a block was too large. */
+  uint32_t getNumDroppedBlocks() const { return dropped_.load(); }
+
+private:
+  void serialiseBlock(int numSamples,
+                      const juce::AudioPlayHead::PositionInfo& position,
+                      const juce::MidiBuffer& midi) noexcept;
+  void run() override;
+  void drain();
+
+  std::unique_ptr<juce::FileOutputStream> file_;
+  juce::AbstractFifo fifo_{kRingBytes};
+  std::vector<uint8_t> ring_;
+  std::vector<uint8_t> scratch_;  // Audio thread only.
+  juce::Array<juce::AudioProcessorParameter*> parameters_;
+  std::vector<float> lastValues_;  // Audio thread only.
+  bool resyncParameters_ = false;  // Audio thread only; set by a drop.
+  std::atomic<bool> capturing_{false};
+  std::atomic<bool> audioThreadBusy_{false};
+  std::atomic<uint32_t> dropped_{0};
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Writer)
+};
+
+/** Reads a trace written by Writer. */
+class Reader {
+public:
+  /** Loads the whole file. isValid() is false if it is not a trace. */
+  explicit Reader(const juce::File& file);
+
+  bool isValid() const { return valid_; }
+  double getSampleRate() const { return sampleRate_; }
+  const juce::StringArray& getParameterIds() const { return parameterIds_; }
+  const std::vector<float>& getInitialValues() const { return initialValues_; }
+
+  /** Reads the next block into block. Returns false at the end of the trace
+   * or if the remaining data is truncated. */
+  bool readNextBlock(Block& block);
+  /** Rewinds to the first block. */
+  void rewind() { offset_ = firstBlockOffset_; }
+
+private:
+  template <typename T>
+  bool read(T& value);
+
+  juce::MemoryBlock data_;
+  size_t offset_ = 0;
+  size_t firstBlockOffset_ = 0;
+  bool valid_ = false;
+  double sampleRate_ = 0.0;
+  juce::StringArray parameterIds_;
+  std::vector<float> initialValues_;
+};
+
+struct ReplayResult {
+  int numBlocks = 0;
+  int64_t numSamples = 0;
+  double renderSeconds = 0.0;        // Time spent inside processBlock().
+  std::vector<double> blockSeconds;  // One entry per block.
+};
+
+/**
+ * Feeds every block of a trace into processor as fast as possible. Parameters
+ * are matched by ID, the recorded position is served through the processor's
+ * play head and the processor is prepared with the trace's sample rate and
+ * largest block size. The processor's previous play head is restored
+ * afterwards.
+ */
+ReplayResult replay(Reader& reader, juce::AudioProcessor& processor);
+
+}  // namespace SessionTrace
@@ -0,0 +1,76 @@
+#pragma once
+
+/**
+ * Vectorised inner loops shared by the grain renderer, built for several
+ * instruction set levels in one binary.
+ *
+ * Every kernel exists as a portable scalar reference and, on x86, as SSE2,
+ * AVX2 (+FMA) and AVX-512 variants compiled with per-function target
+ * attributes. The best variant the CPU supports is picked from CPUID the first
+ * time active() is called; the plugin does this while preparing to play so the
+ * audio thread only ever loads a pointer.
+ *
+ * All variants compute the same formulas in the same order per element, so
+ * results agree with the scalar reference to within FMA rounding. dot() sums
+ * in a different order and agrees to within normal float accumulation error.
+ */
+namespace SimdKernels {
+
+enum class Isa { Scalar, SSE2, AVX2, AVX512 };
+
+constexpr int kNumIsas = 4;
+
+struct KernelSet {
+  Isa isa;
+  const char* name;
+
+  /** Returns sum(a[i] * b[i]). Used by the polyphase resampler. */
+  float (*dot)(const float* a, const float* b, int numSamples);
+
+  /** dest[i] = sin(2 * pi * frac(phase + increment * i)); phase >= 0. */
+  void (*sine)(float* dest, float phase, float increment, int numSamples);
+
+  /** dest[i] = 0.5 * (1 - cos(2 * pi * (phase + increment * i))) for phases
+   * in [0, 1]. This is the Hann grain envelope. */
+  void (*hann)(float* dest, float phase, float increment, int numSamples);
+
+  /** dest[i] = start + increment * i. Trapezoid envelope ramps. */
+  void (*ramp)(float* dest, float start, float increment, int numSamples);
+
+  /** out[i] += source[i] * envelope[i] * gain. */
+  void (*mixMono)(float* out,
+                  const float* source,
+                  const float* envelope,
+                  float gain,
+                  int numSamples);
+
+  /** left[i] += source[i] * envelope[i] * gainLeft, and likewise right. */
+  void (*mixStereo)(float* left,
+                    float* right,
+                    const float* source,
+                    const float* envelope,
+                    float gainLeft,
+                    float gainRight,
+                    int numSamples);
+};
+
+/** Highest instruction set level both this build and the CPU support. */
+Isa detectIsa();
+
+/** Returns the kernels for isa, or nullptr if the build or CPU lacks it. */
+const KernelSet* getKernelSet(Isa isa);
+
+/** The portable reference implementation. Always available. */
+const KernelSet& scalar();
+
+/** Kernels used for rendering. Resolved from detectIsa() on first use. */
+const KernelSet& active();
+
+/**
+ * Overrides the kernels returned by active(), e.g. to benchmark or verify a
+ * lower ISA level. Returns false and leaves the selection unchanged if isa is
+ * not available. Not intended to be called while audio is rendering.
+ */
+bool setActiveIsa(Isa isa);
+
+}  // namespace SimdKernels
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+ * @class SpanTracer
+ * @brief Low-overhead span tracing, exported as Chrome trace-event JSON.
+ *
+ * A Scope records its name, start and end time into a buffer owned by the
+ * calling thread. Each thread claims one of kMaxThreads fixed-size rings the
+ * first time it records, so recording never locks or waits, and never
+ * allocates after that first span. When a ring wraps the oldest spans are
+ * overwritten: the tracer always holds each thread's most recent activity, and
+ * toChromeTraceJson() can snapshot it at any time. The output opens in
+ * chrome://tracing and ui.perfetto.dev.
+ *
+ * A thread's ring is freed when the thread exits. It keeps that thread's spans
+ * until another thread claims it, and rings that never held spans are claimed
+ * first. At most kMaxThreads threads can record at once; spans from any
+ * further thread are dropped until a ring is freed.
+ *
+ * Tracing is process-wide and off by default; a scope costs one relaxed
+ * atomic load while it is off. Span names must be string literals (or
+ * otherwise live for the rest of the process), since only the pointer is
+ * stored.
+ */
+class SpanTracer {
+public:
+  static constexpr int kMaxThreads = 16;
+  static constexpr int kEventsPerThread = 1 << 13;
+
+  /** Argument value meaning "no argument". */
+  static constexpr int kNoArg = -1;
+
+  /** Records a span from construction to destruction while tracing is on. */
+  class Scope {
+  public:
+    explicit Scope(const char* name, int arg = kNoArg) noexcept
+        : name_(name), arg_(arg), active_(isEnabled()) {
+      if (active_)
+        startTicks_ = juce::Time::getHighResolutionTicks();
+    }
+    ~Scope() {
+      if (active_)
+        record(name_, startTicks_, juce::Time::getHighResolutionTicks(), arg_);
+    }
+
+  private:
+    const char* name_;
+    int arg_;
+    bool active_;
+    juce::int64 startTicks_ = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(Scope)
+  };
+
+  /**
+   * Turns tracing on or off. The first call that turns it on allocates the
+   * thread rings, so call it from the message thread rather than the audio
+   * thread.
+   */
+  static void setEnabled(bool shouldBeEnabled);
+  static bool isEnabled() noexcept {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  /** Appends a finished span to the calling thread's ring. Wait-free. */
+  static void record(const char* name,
+                     juce::int64 startTicks,
+                     juce::int64 endTicks,
+                     int arg = kNoArg) noexcept;
+
+  /**
+   * Labels the calling thread in the trace. name must be a string literal.
+   * Threads started with juce::Thread, and the message thread, are labelled
+   * automatically. Does nothing while tracing is off.
+   */
+  static void nameCurrentThread(const char* name) noexcept;
+
+  /** Spans that could not be recorded because every ring was in use. */
+  static uint32_t getNumDropped() noexcept;
+
+  /** Snapshots every thread's ring as Chrome trace-event JSON. */
+  static std::string toChromeTraceJson();
+  /** Writes toChromeTraceJson() to file. Returns false if it failed. */
+  static bool writeChromeTrace(const juce::File& file);
+
+private:
+  static inline std::atomic<bool> enabled_{false};
+};
+
+#define POINTILSYNTH_TRACE_CONCAT_(a, b) a##b
+#define POINTILSYNTH_TRACE_CONCAT(a, b) POINTILSYNTH_TRACE_CONCAT_(a, b)
+/** Traces the enclosing scope: POINTILSYNTH_TRACE_SCOPE("name"[, arg]). */
+#define POINTILSYNTH_TRACE_SCOPE(...) \
+  const SpanTracer::Scope POINTILSYNTH_TRACE_CONCAT(traceScope_, __LINE__)( \
+      __VA_ARGS__)
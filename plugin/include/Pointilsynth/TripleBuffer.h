@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+/**
+ * Lock-free hand-over of whole values from one writer thread to one reader
+ * thread. The writer fills its own buffer and publishes it; the reader
+ * acquires the newest published buffer. Neither side ever waits, and the
+ * reader always sees a complete value.
+ *
+ * The writer owns one buffer, the reader another, and the third is the one
+ * in transit. publish() swaps the writer's buffer with it; acquire() swaps
+ * the reader's. A buffer the writer gets back holds stale contents.
+ */
+template <typename T>
+class TripleBuffer {
+public:
+  /** The buffer to fill. Writer only. */
+  T& getWriteBuffer() noexcept { return buffers_[static_cast<size_t>(back_)]; }
+
+  /** True while the last published buffer has not been acquired. */
+  bool hasUnreadPublish() const noexcept {
+    return (middle_.load(std::memory_order_acquire) & kFresh) != 0;
+  }
+
+  /** Publishes the write buffer, replacing any unread one, and returns the
+   * next write buffer. Wait-free; writer only. */
+  T& publish() noexcept {
+    const int previous =
+        middle_.exchange(back_ | kFresh, std::memory_order_acq_rel);
+    back_ = previous & kIndexMask;
+    return getWriteBuffer();
+  }
+
+  /** The newest published buffer, or nullptr if nothing was published since
+   * the last call. Valid until the next call. Wait-free; reader only. */
+  const T* acquire() noexcept {
+    if (!hasUnreadPublish())
+      return nullptr;
+    const int previous = middle_.exchange(front_, std::memory_order_acq_rel);
+    front_ = previous & kIndexMask;
+    return &buffers_[static_cast<size_t>(front_)];
+  }
+
+private:
+  static constexpr int kIndexMask = 3;
+  static constexpr int kFresh = 4;  // The middle buffer has not been read
+
+  std::array<T, 3> buffers_{};
+  int back_ = 0;                // Writer's buffer
+  int front_ = 1;               // Reader's buffer
+  std::atomic<int> middle_{2};  // Buffer in transit | kFresh
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class VoiceAllocator
+ * @brief Assigns MIDI notes to grain streams.
+ *
+ * A voice is one grain stream: a spawn countdown and a MIDI influence of its
+ * own, feeding the AudioEngine's shared grain pool and render pass. Voices
+ * cost nothing beyond the grains they spawn.
+ *
+ * With no note held a single free stream plays the cloud at the model's own
+ * pitch, and the first note takes it over. Each further note gets a voice of
+ * its own up to the voice limit, beyond which a voice is stolen: the oldest
+ * released one if any, otherwise the oldest held one. A stolen held voice
+ * keeps its schedule, so with a limit of one every note retargets the same
+ * stream. A released voice stops spawning and is culled once its last grain
+ * has finished, except the last voice released, which carries on as the free
+ * stream.
+ *
+ * Audio thread only.
+ */
+class VoiceAllocator {
+public:
+  static constexpr int kMaxVoices = 16;
+
+  struct Voice {
+    bool isActive = false;    // Spawning, or released with grains sounding
+    bool isSpawning = false;  // Held, or the free stream
+    bool isHeld = false;
+    int noteNumber = -1;      // -1 for the free stream
+    float influence = 0.0f;   // Pull towards noteNumber, 0 to 1
+    uint32_t startOrder = 0;  // Larger is newer
+    int numLiveGrains = 0;
+
+    // Spawn schedule, run by the AudioEngine. INT_MAX pauses the stream until
+    // the next sub-block schedules it from the current density.
+    int samplesUntilNextGrain = INT_MAX;
+    float scheduledDensity = 0.0f;  // Density the countdown was scheduled at
+  };
+
+  /** Drops every voice and starts the free stream, its first grain due in
+   * samplesUntilNextGrain samples at density. */
+  void reset(int samplesUntilNextGrain, float density);
+
+  /**
+   * Starts noteNumber with influence velocity (0-1) and returns its voice.
+   * maxVoices is clamped to [1, kMaxVoices]; a lowered limit takes effect as
+   * voices are released or stolen. A new voice starts paused.
+   */
+  int noteOn(int noteNumber, float velocity, int maxVoices);
+
+  /** Releases the newest held voice playing noteNumber and returns it, or -1
+   * if none does. */
+  int noteOff(int noteNumber);
+
+  void grainStarted(int voice) {
+    ++voices_[static_cast<size_t>(voice)].numLiveGrains;
+  }
+  void grainFinished(int voice) {
+    --voices_[static_cast<size_t>(voice)].numLiveGrains;
+  }
+
+  /** Deactivates released voices whose grains have all finished. */
+  void cullSilentVoices();
+
+  /** The spawning voice whose next onset is earliest and before numSamples,
+   * or -1. Ties go to the lower index, so spawning order is deterministic. */
+  int nextOnset(int numSamples) const;
+
+  Voice& getVoice(int voice) { return voices_[static_cast<size_t>(voice)]; }
+  const Voice& getVoice(int voice) const {
+    return voices_[static_cast<size_t>(voice)];
+  }
+  int getNumActiveVoices() const;
+  int getNumHeldVoices() const;
+
+private:
+  std::array<Voice, kMaxVoices> voices_{};
+  uint32_t nextOrder_ = 0;
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <juce_graphics/juce_graphics.h>
+#include <juce_core/juce_core.h>
+#include "Pointilsynth/TripleBuffer.h"
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+namespace audio_plugin {
+
+/**
+ * Draws grain dots into an image on a background thread.
+ *
+ * The GUI submits each frame as a list of dots. The worker thread clears an
+ * image and stamps each dot from a pre-rendered anti-aliased sprite, then
+ * hands the image back. Frames travel both ways through TripleBuffers, so
+ * neither thread waits and the GUI only has to blit the newest image. A
+ * frame submitted while the worker is busy replaces any unrendered one.
+ *
+ * Dots are white on black and blend additively towards white, which is all
+ * the grain view needs and much cheaper than Graphics::fillEllipse().
+ */
+class GrainRasterizer : private juce::Thread {
+public:
+  struct Dot {
+    float x = 0.0f;  // Centre, in pixels
+    float y = 0.0f;
+    float radius = 1.0f;  // Clamped to [kMinRadius, kMaxRadius]
+    float alpha = 1.0f;   // 0 to 1
+  };
+
+  static constexpr float kMinRadius = 0.5f;
+  static constexpr float kMaxRadius = 8.0f;
+
+  /** Starts the worker thread unless useBackgroundThread is false, in which
+   * case submit() renders on the calling thread. */
+  explicit GrainRasterizer(bool useBackgroundThread = true);
+  ~GrainRasterizer() override;
+
+  /** Queues dots for rendering into a width x height image. Takes the
+   * contents of dots and leaves it empty, with its capacity kept for reuse
+   * where possible. GUI thread only. */
+  void submit(std::vector<Dot>& dots, int width, int height);
+
+  /** True if a frame finished since the last acquireFrame(). */
+  bool hasNewFrame() const { return images_.hasUnreadPublish(); }
+
+  /** The newest finished frame, or nullptr if none finished since the last
+   * call. Valid until the next call. GUI thread only. */
+  const juce::Image* acquireFrame() { return images_.acquire(); }
+
+  /** Clears image, which must be RGB, to black and draws dots into it. */
+  void rasterize(const std::vector<Dot>& dots, juce::Image& image) const;
+
+private:
+  struct Frame {
+    std::vector<Dot> dots;
+    int width = 0;
+    int height = 0;
+  };
+
+  /** Coverage mask of a disc, one float per pixel, centred in a square of
+   * side size. */
+  struct Sprite {
+    int size = 0;
+    std::vector<float> coverage;
+  };
+
+  void run() override;
+  void render(const Frame& frame);
+  const Sprite& spriteFor(float radius) const;
+
+  static constexpr float kRadiusStep = 0.25f;
+  static constexpr int kNumSprites =
+      static_cast<int>((kMaxRadius - kMinRadius) / kRadiusStep) + 1;
+  std::array<Sprite, kNumSprites> sprites_;
+
+  const bool useBackgroundThread_;
+  TripleBuffer<Frame> frames_;        // GUI -> worker
+  TripleBuffer<juce::Image> images_;  // Worker -> GUI
+  juce::WaitableEvent frameSubmitted_;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GrainRasterizer)
+};
+
+}  // namespace audio_plugin
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <deque>
+#include <array>
 #include <vector>
 
 #include <juce_gui_basics/juce_gui_basics.h>
@@ -9,20 +9,59 @@
 
 namespace audio_plugin {
 
-class InertialHistoryVisualizer : public juce::Component, private juce::Timer {
+/**
+ * Plots each remembered note's inertial LFO, stacked, over the last few
+ * seconds. Reads the notes only through the manager's published snapshots,
+ * so the audio thread can change them at any MIDI rate.
+ *
+ * The plot is kept in an image that scrolls one column per tick; each tick
+ * draws only the newest column. The stacked values of the last kMaxPoints
+ * columns are kept in a ring so the image can be redrawn after a resize.
+ */
+class InertialHistoryVisualizer : public juce::Component, public juce::Timer {
 public:
+  static constexpr int kMaxPoints = 128;
+  static constexpr int kPixelsPerPoint = 4;
+
   explicit InertialHistoryVisualizer(InertialHistoryManager& manager);
   ~InertialHistoryVisualizer() override = default;
 
   void paint(juce::Graphics& g) override;
+  void resized() override;
+  void timerCallback() override;
+
+  /** The scrolling plot, kMaxPoints columns kPixelsPerPoint apart and as tall
+   * as the component. Invalid while the component has no height. */
+  const juce::Image& getPlot() const { return plot_; }
+  /** False once the last kMaxPoints ticks were all without notes. */
+  bool isScrolling() const { return numQuietTicks_ <= kMaxPoints; }
 
 private:
-  void timerCallback() override;
+
+  /** One tick of the plot: the running sum of the note values, bottom
+   * layer first, and each layer's note number for its colour. */
+  struct Column {
+    int numLayers = 0;
+    std::array<float, InertialHistoryManager::kMaxNotes> tops{};
+    std::array<int, InertialHistoryManager::kMaxNotes> noteNumbers{};
+  };
+
+  void drawSegment(juce::Graphics& g,
+                   const Column& previous,
+                   const Column& next,
+                   float x) const;
+  void redrawPlot();
 
   InertialHistoryManager& manager_;
-  std::vector<std::deque<float>> histories_;
+  // The newest snapshot, valid until the next acquire.
+  const InertialHistoryManager::Snapshot* latest_ = nullptr;
+
+  std::vector<Column> columns_;  // Ring of kMaxPoints columns
+  int newestColumn_ = 0;
+  int numColumns_ = 0;
+  int numQuietTicks_ = 0;  // Consecutive ticks without notes
 
-  static constexpr int maxPoints_ = 128;
+  juce::Image plot_;
 };
 
 }  // namespace audio_plugin
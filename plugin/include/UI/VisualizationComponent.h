@@ -3,17 +3,45 @@
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_opengl/juce_opengl.h>
 #include "Pointilsynth/PointilismInterfaces.h"
+#include "UI/GrainRasterizer.h"
 
 namespace audio_plugin {
 
+/**
+ * Draws the grain cloud, pan across and pitch up. By default each live grain
+ * is drawn as a dot that grows and fades with its envelope, from the engine's
+ * GrainSnapshots. Without snapshots, each spawned grain from the GrainVisQueue
+ * is drawn at full size for its duration instead. In heatmap mode the engine
+ * sends a pitch x pan energy grid per block instead (see GrainDensityGrid),
+ * which is drawn as a decaying heatmap at a cost that does not depend on
+ * density.
+ *
+ * Grains are drawn off the message thread by a GrainRasterizer, which leaves
+ * the message thread only the blit. The timer drops to kIdleHz while there
+ * is nothing to show and returns to kActiveHz when grains appear.
+ */
 class VisualizationComponent : public juce::Component, public juce::Timer {
 public:
-  VisualizationComponent(juce::AbstractFifo& fifo, GrainInfoForVis* buffer);
+  static constexpr int kActiveHz = 60;
+  static constexpr int kIdleHz = 10;
+
+  VisualizationComponent(GrainVisQueue& queue,
+                         GrainDensityGrid& densityGrid,
+                         GrainSnapshotBuffer* snapshots = nullptr);
   ~VisualizationComponent() override;
 
   void paint(juce::Graphics& g) override;
+  void resized() override;
   void timerCallback() override;
 
+  /** Switches between individual grains and the density heatmap. The choice
+   * is kept in the grid, so it survives reopening the editor. */
+  void setHeatmapMode(bool shouldShowHeatmap);
+  bool isHeatmapMode() const { return densityGrid_.isEnabled(); }
+
+  /** kActiveHz while anything is on screen, otherwise kIdleHz. */
+  int getFrameRateHz() const { return frameRateHz_; }
+
 private:
   struct VisualGrain {
     float pan{};    // -1.0 to 1.0
@@ -24,10 +52,37 @@ private:
     double maxAge{};     // seconds
   };
 
+  /** Each returns true if the picture changed and sets sceneIsIdle_. */
+  bool updateGrains(double now);
+  bool updateHeatmap(double elapsedSeconds);
+  void collectSnapshotDots(const GrainSnapshot& snapshot);
+  void setFrameRateHz(int hz);
+
+  juce::Point<float> toScreen(float pan, float pitch) const;
+
   juce::OpenGLContext openGLContext;
   std::vector<VisualGrain> grains;
-  juce::AbstractFifo& fifo_;
-  GrainInfoForVis* buffer_;
+  GrainVisQueue& queue_;
+  std::vector<GrainInfoForVis> incoming_;  // Reused drain buffer
+  uint32_t numNotShown_ = 0;  // Dropped or left out grains; shown if non-zero
+
+  GrainSnapshotBuffer* snapshots_;
+
+  GrainRasterizer rasterizer_;
+  std::vector<GrainRasterizer::Dot> dots_;  // Reused for each frame
+  size_t numDotsSubmitted_ = 0;             // In the last submitted frame
+  bool sizeChanged_ = false;
+  const juce::Image* grainFrame_ = nullptr;  // Until the next acquire
+
+  GrainDensityGrid& densityGrid_;
+  GrainDensityGrid::Grid heat_{};  // Published grids with decay applied
+  float heatPeak_ = 0.0f;          // Slowly falling maximum of heat_
+  juce::Image heatmapImage_;       // One pixel per grid cell
+  double lastTickSeconds_ = 0.0;
+  bool sceneIsIdle_ = false;
+  int frameRateHz_ = 0;
+
+  juce::ToggleButton heatmapToggle_{"Heatmap"};
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VisualizationComponent)
 };
@@ -1,37 +1,59 @@
 #include <juce_audio_formats/juce_audio_formats.h>
 #include <juce_core/juce_core.h>  // For DBG, juce::File
 #include "Pointilsynth/PointilismInterfaces.h"
-#include "Pointilsynth/ConfigManager.h"
 #include "Pointilsynth/InertialHistoryManager.h"
 #include <vector>
 #include <algorithm>                 // Required for std::remove_if
 #include <cmath>                     // For std::pow, std::cos, std::sin
+#include <climits>                   // For INT_MAX
 #include "Pointilsynth/Resampler.h"  // For Resampler::getSample
-
-AudioEngine::AudioEngine(std::shared_ptr<ConfigManager> cfg,
-                         juce::AbstractFifo* visFifo,
-                         GrainInfoForVis* visBuffer)
-    : stochasticModel(std::move(cfg)),
-      config_(std::move(cfg)),
-      visualizationFifo_(visFifo),
-      visualizationBuffer_(visBuffer) {}
+#include "Pointilsynth/GrainRenderKernels.h"
+#include "Pointilsynth/SpanTracer.h"
+
+AudioEngine::AudioEngine(ParameterHandles handles,
+                         GrainVisQueue* visQueue,
+                         GrainDensityGrid* densityGrid)
+    : stochasticModel(handles),
+      visQueue_(visQueue),
+      densityGrid_(densityGrid) {
+  voices_.reset(0, 0.0f);
+}
 
 void AudioEngine::prepareToPlay(double sampleRate, int /*samplesPerBlock*/) {
   currentSampleRate = sampleRate;
-  oscillator_.setSampleRate(sampleRate);
   stochasticModel.setSampleRate(sampleRate);  // Inform StochasticModel
-  samplesUntilNextGrain = stochasticModel.getSamplesUntilNextEvent();
-  grains.reserve(1024);  // Keep existing functionality
+  modulation_.prepare(sampleRate);
+  voices_.reset(stochasticModel.getSamplesUntilNextEvent(),
+                stochasticModel.getSmoothedDensity());
+  grains.reserve(static_cast<size_t>(kMaxGrains));
+  static_assert(kNumKernelGroups == GrainRenderKernels::kNumGroups,
+                "One kernel bucket per render kernel group");
+  for (auto& bucket : kernelBuckets_)
+    bucket.reserve(grains.capacity());
+
+  // Resolve the CPU-specific kernels and build the resampler table here rather
+  // than on the first grain rendered on the audio thread.
+  simdKernels_ = &SimdKernels::active();
+  Resampler::getPolyphaseTable();
 }
 
 // Add the following method:
-void AudioEngine::triggerNewGrain() {
+void AudioEngine::triggerNewGrain(int startOffset, int voice) {
+  if (grains.size() >= static_cast<size_t>(kMaxGrains))
+    return;
+  POINTILSYNTH_TRACE_SCOPE("AudioEngine::triggerNewGrain");
+
   Grain newGrain;
-  stochasticModel.generateNewGrain(newGrain);  // Populate grain properties
+  const auto& spawningVoice = voices_.getVoice(voice);
+  stochasticModel.generateNewGrain(
+      newGrain, {static_cast<float>(spawningVoice.noteNumber),
+                 spawningVoice.influence});  // Populate grain properties
 
   newGrain.id = grainIdCounter++;  // Assign unique ID and increment counter
+  newGrain.voice = voice;
   newGrain.isAlive = true;         // New grains are always initially alive
   newGrain.ageInSamples = 0;       // New grains start with zero age
+  newGrain.startOffset = startOffset;
 
   // It's assumed that stochasticModel.generateNewGrain(newGrain) handles:
   // - newGrain.pitch
@@ -40,163 +62,403 @@ void AudioEngine::triggerNewGrain() {
   // - newGrain.durationInSamples
   // - newGrain.sourceSamplePosition (if applicable for the current source type)
 
-  grains.push_back(newGrain);
+  // Capture the render state so the kernels never branch per sample. The
+  // source and envelope are fixed for the grain's lifetime.
+  const auto shape = envelopeShape_.load();
+  const auto source =
+      currentSourceType_.load() == GrainSourceType::AudioSample
+          ? GrainRenderKernels::Source::AudioSample
+          : GrainRenderKernels::sourceFor(currentWaveform_.load());
+  newGrain.kernelGroup = GrainRenderKernels::groupIndex(source, shape);
+
+  // Constant power panning: -1.0 (L) -> 0, 0.0 (C) -> PI/4, 1.0 (R) -> PI/2.
+  const float panAngle =
+      (newGrain.pan * 0.5f + 0.5f) * (juce::MathConstants<float>::pi * 0.5f);
+  newGrain.gainLeft = newGrain.amplitude * std::cos(panAngle);
+  newGrain.gainRight = newGrain.amplitude * std::sin(panAngle);
+
+  // Oscillator grains play the nearest MIDI note; sample grains are
+  // transposed relative to MIDI note 60 (normal speed).
+  const double frequency = juce::MidiMessage::getMidiNoteInHertz(
+      static_cast<int>(std::round(newGrain.pitch)));
+  newGrain.phase = 0.0f;
+  newGrain.phaseIncrement = static_cast<float>(frequency / currentSampleRate);
+  newGrain.playbackRate = static_cast<double>(
+      std::pow(2.0f, (newGrain.pitch - 60.0f) / 12.0f));
+  newGrain.noiseState = (static_cast<uint32_t>(newGrain.id) * 2654435761u) | 1u;
 
-  if (visualizationFifo_ && visualizationBuffer_) {
-    int start1, size1, start2, size2;
-    visualizationFifo_->prepareToWrite(1, start1, size1, start2, size2);
-    if (size1 > 0)
-      visualizationBuffer_[start1] = {
-          newGrain.pan, newGrain.pitch,
-          static_cast<float>(newGrain.durationInSamples / currentSampleRate)};
-    visualizationFifo_->finishedWrite(size1);
+  grains.push_back(newGrain);
+  voices_.grainStarted(voice);
+  if constexpr (RenderTelemetry::kEnabled)
+    ++grainsSpawnedThisBlock_;
+
+  if (densityGridThisBlock_) {
+    densityGrid_->add(newGrain.pitch, newGrain.pan,
+                      newGrain.amplitude *
+                          static_cast<float>(newGrain.durationInSamples /
+                                             currentSampleRate));
+  } else if (visQueue_ != nullptr && !snapshotThisBlock_) {
+    if (numVisBatch_ == kMaxVisBatch)
+      flushVisBatch();
+    visBatch_[static_cast<size_t>(numVisBatch_++)] = {
+        newGrain.pan, newGrain.pitch,
+        static_cast<float>(newGrain.durationInSamples / currentSampleRate)};
   }
 }
 
-// Add the following method:
+void AudioEngine::flushVisBatch() {
+  POINTILSYNTH_TRACE_SCOPE("Visualization queue push");
+  visQueue_->push(visBatch_.data(), numVisBatch_);
+  numVisBatch_ = 0;
+}
+
+void AudioEngine::setSubBlockSize(int numSamples) {
+  subBlockSize_.store(juce::jlimit(1, kMaxSubBlockSize, numSamples));
+}
+
 void AudioEngine::processBlock(juce::AudioBuffer<float>& buffer,
                                juce::MidiBuffer& midiMessages,
                                const juce::AudioPlayHead::PositionInfo& pos) {
+  juce::int64 startTicks = 0;
+  if constexpr (RenderTelemetry::kEnabled) {
+    startTicks = juce::Time::getHighResolutionTicks();
+    grainsSpawnedThisBlock_ = 0;
+    perfActive_ = beginPerfBlock();
+  }
+
   const int numSamples = buffer.getNumSamples();
+  densityGridThisBlock_ = densityGrid_ != nullptr && densityGrid_->isEnabled();
+  snapshotThisBlock_ =
+      grainSnapshots_ != nullptr && grainSnapshots_->isEnabled();
+  const int subBlockSize = subBlockSize_.load();
 
   double currentPpq = pos.getPpqPosition().orFallback(0.0);
   double ppqPerBar = 4.0;
   if (auto sig = pos.getTimeSignature())
     ppqPerBar = sig->numerator * (4.0 / sig->denominator);
-  inertialHistoryManager_.update(currentPpq, ppqPerBar);
-
-  for (const auto metadata : midiMessages) {
-    const auto msg = metadata.getMessage();
-    if (msg.isNoteOn()) {
-      float velocity = static_cast<float>(msg.getVelocity()) / 127.0f;
-      inertialHistoryManager_.addNote(msg.getNoteNumber(), velocity,
-                                      currentPpq);
+  // Without tempo the position is held for the whole block, as before.
+  const double ppqPerSample =
+      pos.getPpqPosition() && pos.getBpm()
+          ? *pos.getBpm() / (60.0 * currentSampleRate)
+          : 0.0;
+
+  endPerfStage(RenderTelemetry::kControlStage);
+
+  // Split the host block into fixed-size sub-blocks so control-rate work and
+  // the grain loop run at the same granularity whatever the host block size.
+  // The sub-blocks consume the block's MIDI at each event's sample position.
+  MidiQueue midi{midiMessages.cbegin(), midiMessages.cend(), numSamples};
+  for (int start = 0; start < numSamples; start += subBlockSize) {
+    const int length = std::min(subBlockSize, numSamples - start);
+    renderSubBlock(buffer, start, length,
+                   currentPpq + ppqPerSample * static_cast<double>(start),
+                   ppqPerSample, ppqPerBar, midi);
+  }
+  if (numVisBatch_ > 0)
+    flushVisBatch();
+  if (densityGridThisBlock_)
+    densityGrid_->publish(numSamples / currentSampleRate);
+
+  // Cleanup dead grains (this part remains from existing code), then the
+  // released voices they leave silent.
+  const auto numGrainsBeforeCleanup = grains.size();
+  for (const auto& grain : grains) {
+    if (!grain.isAlive)
+      voices_.grainFinished(grain.voice);
+  }
+  voices_.cullSilentVoices();
+  grains.erase(
+      std::remove_if(grains.begin(), grains.end(),
+                     [](const Grain& grain) { return !grain.isAlive; }),
+      grains.end());
+  if (snapshotThisBlock_)
+    publishGrainSnapshot();
+  inertialHistoryManager_.publishSnapshot();
+  endPerfStage(RenderTelemetry::kCleanupStage);
+
+  if constexpr (RenderTelemetry::kEnabled) {
+    if (telemetry_ != nullptr)
+      pushTelemetry(
+          numSamples, startTicks,
+          static_cast<int>(numGrainsBeforeCleanup - grains.size()));
+  }
+}  // End of processBlock
+
+void AudioEngine::publishGrainSnapshot() {
+  POINTILSYNTH_TRACE_SCOPE("Grain snapshot publish");
+  auto& snapshot = grainSnapshots_->getWriteBuffer();
+  const int numGrains = std::min(static_cast<int>(grains.size()),
+                                 GrainSnapshot::kMaxGrains);
+  GrainEnvelope envelope;
+  for (int i = 0; i < numGrains; ++i) {
+    const auto& grain = grains[static_cast<size_t>(i)];
+    envelope.setShape(GrainRenderKernels::shapeOf(grain.kernelGroup));
+    snapshot.grains[static_cast<size_t>(i)] = {
+        grain.id, grain.pitch, grain.pan,
+        static_cast<float>(grain.ageInSamples) /
+            static_cast<float>(std::max(1, grain.durationInSamples)),
+        grain.amplitude * envelope.getAmplitude(grain.ageInSamples,
+                                                grain.durationInSamples)};
+  }
+  snapshot.numGrains = numGrains;
+  snapshot.numLive = static_cast<int>(grains.size());
+  grainSnapshots_->publish();
+}
+
+bool AudioEngine::beginPerfBlock() {
+  if (telemetry_ == nullptr || !telemetry_->isPerfCountersRequested()) {
+    if (perfCounters_.isOpen() || perfOpenFailed_) {
+      perfCounters_.close();
+      perfOpenFailed_ = false;
+      if (telemetry_ != nullptr)
+        telemetry_->setPerfState(RenderTelemetry::PerfState::Off);
     }
+    return false;
   }
 
-  // Update the countdown for the next grain event
-  samplesUntilNextGrain -= numSamples;
-
-  // Trigger new grains if the countdown has elapsed
-  while (samplesUntilNextGrain <= 0) {
-    triggerNewGrain();
-    // Add the full duration for the next event, plus any "overshoot" from the
-    // current block. This maintains more accurate timing for grain generation.
-    samplesUntilNextGrain += stochasticModel.getSamplesUntilNextEvent();
-    // Note: StochasticModel::getSamplesUntilNextEvent() must return a positive
-    // value to prevent potential infinite loops if it could return 0 or
-    // negative.
+  if (!perfCounters_.isOpen()) {
+    if (perfOpenFailed_)
+      return false;
+    // Opening is a handful of system calls, paid once when counting starts.
+    perfOpenFailed_ = !perfCounters_.open();
+    telemetry_->setPerfState(perfOpenFailed_
+                                 ? RenderTelemetry::PerfState::Unavailable
+                                 : RenderTelemetry::PerfState::Counting);
+    if (perfOpenFailed_)
+      return false;
   }
+  perfStages_ = {};
+  perfLast_ = perfCounters_.read();
+  return true;
+}
 
-  // Clear the buffer at the start of the block, after triggering new grains
-  buffer.clear();
-
-  // const int numSamples = buffer.getNumSamples(); // This line is already
-  // above the triggering logic
-
-  for (int s = 0; s < numSamples;
-       ++s)  // Outer loop: iterate through each sample in the block
-  {
-    float outputLeft = 0.0f;
-    float outputRight = 0.0f;
-
-    for (auto& grain : grains)  // Inner loop: iterate through each grain
-    {
-      if (!grain.isAlive)
-        continue;
-
-      // Check if grain's lifetime has just ended in this sample
-      if (grain.ageInSamples >= grain.durationInSamples) {
-        grain.isAlive = false;  // Mark for cleanup after the main sample loop
-        continue;
-      }
-
-      float sourceSample = 0.0f;
-
-      // A. Fetch source sample based on grain's source type
-      if (currentSourceType_.load() == GrainSourceType::Oscillator) {
-        double frequency = juce::MidiMessage::getMidiNoteInHertz(
-            static_cast<int>(std::round(grain.pitch)));
-        oscillator_.setFrequency(
-            static_cast<float>(frequency));  // Tune the shared oscillator
-        sourceSample =
-            oscillator_.getNextSample();  // Process and advance oscillator
-      } else if (currentSourceType_.load() == GrainSourceType::AudioSample) {
-        // Ensure sourceAudio is valid and has channels/samples
-        if (sourceAudio.getNumSamples() > 0 &&
-            sourceAudio.getNumChannels() > 0) {
-          int sourceChannelToRead =
-              0;  // Default to reading from channel 0
-                  // (Resampler expects a specific channel from source)
-          sourceSample = Resampler::getSample(sourceAudio, sourceChannelToRead,
-                                              grain.sourceSamplePosition);
-
-          // Advance grain's internal playback position for the audio sample,
-          // adjusted by pitch
-          float baseMidiNote = 60.0f;  // MIDI note 60 is normal speed
-          float pitchRatio =
-              std::pow(2.0f, (grain.pitch - baseMidiNote) / 12.0f);
-          grain.sourceSamplePosition += static_cast<double>(pitchRatio);
-
-          // Note: Resampler::getSample should handle grain.sourceSamplePosition
-          // going out of bounds.
-        }
-      }
-
-      // B. Calculate envelope value using GrainEnvelope
-      // grainEnvelope_ is a member of AudioEngine.
-      float envelopeValue = grainEnvelope_.getAmplitude(
-          grain.ageInSamples, grain.durationInSamples);
-
-      // C. Multiply source sample by envelope value and grain's overall
-      // amplitude
-      float processedSample = sourceSample * envelopeValue * grain.amplitude;
-
-      // D. Apply panning (Constant Power Panning)
-      float panPosition = grain.pan;  // Expected range: -1.0 (L) to 1.0 (R)
-      // Map pan position to an angle: -1.0 (L) -> 0, 0.0 (C) -> PI/4, 1.0 (R)
-      // -> PI/2
-      float panAngle =
-          (panPosition * 0.5f + 0.5f) * (juce::MathConstants<float>::pi * 0.5f);
-      float panGainLeft = std::cos(panAngle);
-      float panGainRight = std::sin(panAngle);
-
-      outputLeft += processedSample * panGainLeft;
-      outputRight += processedSample * panGainRight;
-
-      // E. Increment grain's ageInSamples (as it has been processed for one
-      // sample)
-      grain.ageInSamples++;
-    }  // End of inner grain loop
-
-    // Write accumulated stereo signal to the output buffer for the current
-    // sample 's'
-    if (buffer.getNumChannels() >
-        0) {  // Check if buffer has at least one channel
-      buffer.setSample(
-          0, s, outputLeft);  // Left channel (or mono if numChannels == 1)
+void AudioEngine::pushTelemetry(int numSamples,
+                                juce::int64 startTicks,
+                                int grainsKilled) {
+  POINTILSYNTH_TRACE_SCOPE("RenderTelemetry push");
+  RenderTelemetry::BlockStats stats;
+  stats.renderMicroseconds =
+      static_cast<float>(1.0e6 * juce::Time::highResolutionTicksToSeconds(
+                                     juce::Time::getHighResolutionTicks() -
+                                     startTicks));
+  stats.budgetMicroseconds =
+      static_cast<float>(1.0e6 * numSamples / currentSampleRate);
+  stats.liveGrains = static_cast<int>(grains.size());
+  stats.grainsSpawned = grainsSpawnedThisBlock_;
+  stats.grainsKilled = grainsKilled;
+  for (const auto& grain : grains) {
+    if (GrainRenderKernels::sourceOf(grain.kernelGroup) ==
+        GrainRenderKernels::Source::AudioSample)
+      ++stats.sampleGrains;
+  }
+  stats.oscillatorGrains = stats.liveGrains - stats.sampleGrains;
+  if (perfActive_) {
+    PerfCounters::Counts total;
+    for (const auto& stage : perfStages_)
+      total += stage;
+    stats.hasPerfCounts = total.isComplete();
+  }
+  if (stats.hasPerfCounts)
+    stats.stageCounts = perfStages_;
+  telemetry_->push(stats);
+}
+
+void AudioEngine::handleMidiEvent(const juce::MidiMessage& msg,
+                                  int offset,
+                                  double ppqPosition) {
+  if (msg.isNoteOn()) {
+    const int noteNumber = msg.getNoteNumber();
+    const float velocity = static_cast<float>(msg.getVelocity()) / 127.0f;
+    if (logger_ != nullptr)
+      logger_->log(RtLogEvent::MidiNoteOn, noteNumber, velocity);
+    const int v = voices_.noteOn(noteNumber, velocity,
+                                 stochasticModel.getGlobalNumVoices());
+    auto& voice = voices_.getVoice(v);
+    if (voice.samplesUntilNextGrain == INT_MAX) {
+      // A new voice is scheduled from the note rather than from the next
+      // sub-block.
+      const int interval = stochasticModel.getSamplesUntilNextEvent();
+      voice.samplesUntilNextGrain =
+          interval > INT_MAX - offset ? INT_MAX : offset + interval;
+      voice.scheduledDensity = stochasticModel.getSmoothedDensity();
     }
-    if (buffer.getNumChannels() >
-        1) {  // Check if buffer has at least two channels
-      buffer.setSample(1, s, outputRight);  // Right channel
+    const int burst = noteOnBurst_.load(std::memory_order_relaxed);
+    for (int i = 0; i < burst; ++i)
+      triggerNewGrain(offset, v);
+    inertialHistoryManager_.addNote(noteNumber, velocity, ppqPosition);
+    modulation_.noteOn(velocity);
+  } else if (msg.isNoteOff()) {
+    const int noteNumber = msg.getNoteNumber();
+    if (logger_ != nullptr)
+      logger_->log(RtLogEvent::MidiNoteOff, noteNumber);
+    // Stray note offs, and those of notes whose voice was stolen, release
+    // nothing. The envelope follows the voices: it releases with the last
+    // held one.
+    if (voices_.noteOff(noteNumber) < 0)
+      return;
+    if (logger_ != nullptr)
+      logger_->log(RtLogEvent::MidiInfluenceReset, noteNumber);
+    if (voices_.getNumHeldVoices() == 0)
+      modulation_.noteOff();
+  }
+}
+
+void AudioEngine::setNoteOnBurst(int numGrains) {
+  noteOnBurst_.store(juce::jlimit(0, kMaxNoteOnBurst, numGrains));
+}
+
+void AudioEngine::renderSubBlock(juce::AudioBuffer<float>& buffer,
+                                 int startSample,
+                                 int numSamples,
+                                 double ppqPosition,
+                                 double ppqPerSample,
+                                 double ppqPerBar,
+                                 MidiQueue& midi) {
+  // Control-rate work: parameter snapshot, inertial history update and
+  // modulation, which holds for every grain spawned in this sub-block.
+  stochasticModel.pollParameters();
+  inertialHistoryManager_.update(ppqPosition, ppqPerBar);
+  modulation_.process(
+      numSamples,
+      modulation_.isRouted(ModulationMatrix::Source::Inertia)
+          ? inertialHistoryManager_.getModulationValue()
+          : 0.0f);
+  stochasticModel.setModulation(modulation_.getOffsets());
+
+  // If the smoothed density moved since a voice's pending event was
+  // scheduled, rescale the remaining countdown so the spawn rate follows the
+  // ramp instead of waiting out an interval computed at the old rate.
+  const float blockDensity = stochasticModel.getSmoothedDensity();
+  for (int v = 0; v < VoiceAllocator::kMaxVoices; ++v) {
+    auto& voice = voices_.getVoice(v);
+    if (!voice.isSpawning)
+      continue;
+    int& countdown = voice.samplesUntilNextGrain;
+    if (voice.scheduledDensity > 0.0f && blockDensity > 0.0f &&
+        !juce::exactlyEqual(blockDensity, voice.scheduledDensity) &&
+        countdown > 0 && countdown != INT_MAX) {
+      const double rescaled = static_cast<double>(countdown) *
+                              static_cast<double>(voice.scheduledDensity) /
+                              static_cast<double>(blockDensity);
+      countdown =
+          static_cast<int>(std::min(rescaled, static_cast<double>(INT_MAX)));
+    } else if (countdown == INT_MAX && blockDensity > 0.0f) {
+      // Generation was paused at zero density; schedule from the new rate.
+      countdown = stochasticModel.getSamplesUntilNextEvent();
     }
+    voice.scheduledDensity = blockDensity;
+  }
 
-    // Optional: Fill any additional channels (e.g., for surround sound setups)
-    for (int channel = 2; channel < buffer.getNumChannels(); ++channel) {
-      // Example: Mix down stereo to additional channels or set to zero
-      buffer.setSample(channel, s, (outputLeft + outputRight) * 0.5f);
+  // Offset of the next MIDI event within this sub-block, or INT_MAX. Events
+  // outside the host block are clamped into it.
+  auto nextEventOffset = [&] {
+    if (midi.next == midi.end)
+      return INT_MAX;
+    const int position =
+        std::clamp((*midi.next).samplePosition, 0, midi.blockLength - 1);
+    return position < startSample + numSamples ? position - startSample
+                                               : INT_MAX;
+  };
+
+  // Trigger new grains at their onset offset within this sub-block, voices
+  // interleaved in onset order, and apply MIDI events at theirs. An event
+  // comes before a grain at the same offset. The smoothed parameters are
+  // advanced to each onset so grains sample the ramp there.
+  int rampPosition = 0;
+  for (;;) {
+    const int v = voices_.nextOnset(numSamples);
+    const int onset =
+        v >= 0 ? std::max(0, voices_.getVoice(v).samplesUntilNextGrain)
+               : INT_MAX;
+    const int eventOffset = nextEventOffset();
+    if (eventOffset != INT_MAX && eventOffset <= onset) {
+      stochasticModel.advanceSmoothing(eventOffset - rampPosition);
+      rampPosition = eventOffset;
+      handleMidiEvent((*midi.next).getMessage(), eventOffset,
+                      ppqPosition +
+                          ppqPerSample * static_cast<double>(eventOffset));
+      ++midi.next;
+      continue;
     }
-  }  // End of outer sample loop
+    if (v < 0)
+      break;
 
-  // Cleanup dead grains (this part remains from existing code)
-  grains.erase(
-      std::remove_if(grains.begin(), grains.end(),
-                     [](const Grain& grain) { return !grain.isAlive; }),
-      grains.end());
-}  // End of processBlock
+    auto& voice = voices_.getVoice(v);
+    stochasticModel.advanceSmoothing(onset - rampPosition);
+    rampPosition = onset;
+    triggerNewGrain(onset, v);
+    // Add the full duration for the next event on top of the current onset.
+    // This maintains accurate timing for grain generation. A zero interval is
+    // bumped to one sample so the loop always terminates.
+    const int interval =
+        std::max(1, stochasticModel.getSamplesUntilNextEvent());
+    voice.samplesUntilNextGrain =
+        interval > INT_MAX - voice.samplesUntilNextGrain
+            ? INT_MAX
+            : voice.samplesUntilNextGrain + interval;
+    voice.scheduledDensity = stochasticModel.getSmoothedDensity();
+  }
+  stochasticModel.advanceSmoothing(numSamples - rampPosition);
+  for (int v = 0; v < VoiceAllocator::kMaxVoices; ++v) {
+    auto& voice = voices_.getVoice(v);
+    if (voice.isSpawning && voice.samplesUntilNextGrain != INT_MAX)
+      voice.samplesUntilNextGrain -= numSamples;
+  }
+  endPerfStage(RenderTelemetry::kControlStage);
+
+  // Render into the L1-resident scratch buffers, then copy to the output.
+  float* scratchLeft = scratchLeft_.data();
+  float* scratchRight = scratchRight_.data();
+  juce::FloatVectorOperations::clear(scratchLeft, numSamples);
+  juce::FloatVectorOperations::clear(scratchRight, numSamples);
+
+  // Group live grains by render kernel, then run each group's kernel over
+  // its grains. The kernel is looked up once per group per sub-block, so the
+  // per-sample loops inside the kernels are branch-free.
+  for (auto& bucket : kernelBuckets_)
+    bucket.clear();
+  for (size_t i = 0; i < grains.size(); ++i) {
+    if (grains[i].isAlive)
+      kernelBuckets_[static_cast<size_t>(grains[i].kernelGroup)].push_back(
+          static_cast<int>(i));
+  }
+
+  const GrainRenderKernels::Context context{
+      &sourceAudio, envelopeScratch_.data(), sourceScratch_.data(),
+      simdKernels_};
+  const int numChannels = buffer.getNumChannels();
+  for (int group = 0; group < kNumKernelGroups; ++group) {
+    const auto& bucket = kernelBuckets_[static_cast<size_t>(group)];
+    if (bucket.empty())
+      continue;
+    POINTILSYNTH_TRACE_SCOPE("GrainRenderKernels group", group);
+    const auto kernel = GrainRenderKernels::getKernel(group, numChannels);
+    for (int index : bucket)
+      kernel(context, grains[static_cast<size_t>(index)], scratchLeft,
+             scratchRight, numSamples);
+  }
+  endPerfStage(RenderTelemetry::kRenderStage);
+
+  // Grains spawned mid-sub-block play from the start of the next one.
+  for (auto& grain : grains)
+    grain.startOffset = 0;
+
+  // Write the stereo scratch signal to the output buffer. Mono outputs take
+  // the left channel; additional channels get the stereo mix-down.
+  if (numChannels > 0)
+    buffer.copyFrom(0, startSample, scratchLeft, numSamples);
+  if (numChannels > 1)
+    buffer.copyFrom(1, startSample, scratchRight, numSamples);
+  for (int channel = 2; channel < numChannels; ++channel) {
+    buffer.copyFrom(channel, startSample, scratchLeft, numSamples, 0.5f);
+    buffer.addFrom(channel, startSample, scratchRight, numSamples, 0.5f);
+  }
+  endPerfStage(RenderTelemetry::kOutputStage);
+}
 
 // Implementation of loadAudioSample - MOVED OUTSIDE processBlock
 void AudioEngine::loadAudioSample(const juce::File& audioFile) {
+  POINTILSYNTH_TRACE_SCOPE("AudioEngine::loadAudioSample");
   juce::AudioFormatManager formatManager;
   formatManager.registerBasicFormats();  // Register WAV and AIFF
 
@@ -250,6 +512,10 @@ void AudioEngine::loadAudioSample(const juce::File& audioFile) {
       ", Samples: " + juce::String(sourceAudio.getNumSamples()));
 }
 
+void AudioEngine::setSourceAudio(const juce::AudioBuffer<float>& audio) {
+  sourceAudio.makeCopyOf(audio);
+}
+
 void AudioEngine::setGrainSource(int internalWaveformId) {
   currentSourceType_.store(
       AudioEngine::GrainSourceType::Oscillator);  // Set source type to
@@ -276,9 +542,14 @@ void AudioEngine::setGrainSource(int internalWaveformId) {
       // Consider adding DBG("Unknown internalWaveformId..."); for debugging
       break;
   }
-  oscillator_.setWaveform(selectedWaveform);
+  currentWaveform_.store(selectedWaveform);
+}
+
+void AudioEngine::setEnvelopeShape(GrainEnvelope::Shape shape) {
+  envelopeShape_.store(shape);
 }
 
-void AudioEngine::applyMidiInfluence(int noteNumber, float normalizedVelocity) {
-  stochasticModel.setMidiInfluence(noteNumber, normalizedVelocity);
+void AudioEngine::setRandomSeed(uint32_t seed) {
+  stochasticModel.setRandomSeed(seed);
+  grainIdCounter = 0;
 }
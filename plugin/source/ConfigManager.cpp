@@ -66,7 +66,18 @@ void ConfigManager::addListener(const juce::String& paramID, Callback cb) {
 
 ConfigManager::ConfigManager(juce::AudioProcessor* processor)
     : apvts_(*processor, nullptr, "PARAMETERS", createLayout()),
-      owner_(processor) {}
+      owner_(processor) {
+  handles_.pitch = apvts_.getRawParameterValue(ParamID::pitch);
+  handles_.dispersion = apvts_.getRawParameterValue(ParamID::dispersion);
+  handles_.avgDuration = apvts_.getRawParameterValue(ParamID::avgDuration);
+  handles_.durationVariation =
+      apvts_.getRawParameterValue(ParamID::durationVariation);
+  handles_.pan = apvts_.getRawParameterValue(ParamID::pan);
+  handles_.panSpread = apvts_.getRawParameterValue(ParamID::panSpread);
+  handles_.density = apvts_.getRawParameterValue(ParamID::density);
+  handles_.temporalDistribution =
+      apvts_.getRawParameterValue(ParamID::temporalDistribution);
+}
 
 juce::AudioProcessorValueTreeState::ParameterLayout
 ConfigManager::createLayout() {
@@ -1,10 +1,25 @@
 #include "Pointilsynth/DebugUIPanel.h"
 #include "Pointilsynth/PointilismInterfaces.h"  // For StochasticModel::TemporalDistribution
 #include "Pointilsynth/ConfigManager.h"
+#include "Pointilsynth/SpanTracer.h"
+
+namespace {
+juce::String formatPercent(float load) {
+  return juce::String(100.0f * load, 1) + "%";
+}
+
+// Rows of the telemetry area: load meter, percentiles, grains, overruns, and
+// two rows of hardware counters where they are supported.
+int getNumTelemetryRows() {
+  return PerfCounters::isSupported() ? 6 : 4;
+}
+}  // namespace
 
 // Constructor
-DebugUIPanel::DebugUIPanel(std::shared_ptr<ConfigManager> cfg)
-    : configManager(std::move(cfg)) {
+DebugUIPanel::DebugUIPanel(std::shared_ptr<ConfigManager> cfg,
+                           RenderTelemetry* telemetryToShow)
+    : configManager(std::move(cfg)),
+      telemetry(RenderTelemetry::kEnabled ? telemetryToShow : nullptr) {
   // Initialize and configure sliders and labels
   // Pitch
   pitchSlider =
@@ -99,11 +114,43 @@ DebugUIPanel::DebugUIPanel(std::shared_ptr<ConfigManager> cfg)
       juce::Justification::centredLeft);
   addAndMakeVisible(temporalDistributionLabel);
 
+  // Render telemetry
+  if (telemetry != nullptr) {
+    telemetryHistory.reserve(kTelemetryHistoryBlocks +
+                             static_cast<size_t>(RenderTelemetry::kCapacity));
+    resetOverrunsButton.onClick = [this] {
+      telemetry->resetOverruns();
+      repaint(telemetryArea);
+    };
+    addAndMakeVisible(resetOverrunsButton);
+    if (PerfCounters::isSupported()) {
+      perfCountersToggle.setToggleState(telemetry->isPerfCountersRequested(),
+                                        juce::dontSendNotification);
+      perfCountersToggle.onClick = [this] {
+        telemetry->setPerfCountersRequested(
+            perfCountersToggle.getToggleState());
+        repaint(telemetryArea);
+      };
+      addAndMakeVisible(perfCountersToggle);
+    }
+    startTimerHz(15);
+  }
+
+  // Span tracing: the first click starts recording, the second writes a
+  // Chrome trace to the user's documents folder.
+  traceButton.setButtonText(SpanTracer::isEnabled() ? "Save trace"
+                                                    : "Start trace");
+  traceButton.onClick = [this] { toggleTracing(); };
+  addAndMakeVisible(traceButton);
+  traceStatusLabel.setJustificationType(juce::Justification::centredLeft);
+  addAndMakeVisible(traceStatusLabel);
+
   // The editor is responsible for setting our size.
   // setSize(600, 400); // This was set by PluginEditor
 }
 
 DebugUIPanel::~DebugUIPanel() {
+  stopTimer();
   // Destructor (JUCE handles cleanup of child components as they are owned)
   // Listeners are lambda based and managed by JUCE Slider/ComboBox, no manual
   // removal needed.
@@ -123,6 +170,143 @@ void DebugUIPanel::paint(juce::Graphics& g) {
   // Fill the background
   g.fillAll(
       getLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId));
+  if (telemetry != nullptr)
+    paintTelemetry(g);
+}
+
+void DebugUIPanel::toggleTracing() {
+  if (!SpanTracer::isEnabled()) {
+    SpanTracer::setEnabled(true);
+    traceButton.setButtonText("Save trace");
+    traceStatusLabel.setText("Recording...", juce::dontSendNotification);
+    return;
+  }
+
+  SpanTracer::setEnabled(false);
+  traceButton.setButtonText("Start trace");
+  const auto file =
+      juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+          .getNonexistentChildFile("PointilSynth trace", ".json");
+  traceStatusLabel.setText(SpanTracer::writeChromeTrace(file)
+                               ? "Saved " + file.getFileName()
+                               : juce::String("Could not write trace"),
+                           juce::dontSendNotification);
+}
+
+void DebugUIPanel::updateTelemetry() {
+  if (telemetry == nullptr)
+    return;
+  if (telemetry->drain(telemetryHistory, kTelemetryHistoryBlocks) > 0) {
+    telemetrySummary = RenderTelemetry::summarise(telemetryHistory);
+    repaint(telemetryArea);
+  }
+}
+
+void DebugUIPanel::timerCallback() {
+  POINTILSYNTH_TRACE_SCOPE("DebugUIPanel::timerCallback");
+  updateTelemetry();
+}
+
+void DebugUIPanel::paintTelemetry(juce::Graphics& g) const {
+  const auto& summary = telemetrySummary;
+  const auto& latest = summary.latest;
+  auto area = telemetryArea;
+  const int rowHeight = area.getHeight() / getNumTelemetryRows();
+  const auto textColour = getLookAndFeel().findColour(juce::Label::textColourId);
+
+  // Load meter: the latest block's render time against its budget, with a
+  // tick at the p99 load.
+  auto meter = area.removeFromTop(rowHeight).reduced(2).toFloat();
+  g.setColour(juce::Colours::black.withAlpha(0.4f));
+  g.fillRect(meter);
+  const float load = latest.getLoad();
+  g.setColour(load < 0.5f   ? juce::Colours::limegreen
+              : load < 0.8f ? juce::Colours::orange
+                            : juce::Colours::red);
+  g.fillRect(meter.withWidth(meter.getWidth() * juce::jmin(load, 1.0f)));
+  g.setColour(textColour);
+  const float p99X =
+      meter.getX() + meter.getWidth() * juce::jmin(summary.p99Load, 1.0f);
+  g.drawVerticalLine(juce::roundToInt(p99X), meter.getY(), meter.getBottom());
+  g.drawText("Load " + formatPercent(load) + " of " +
+                 juce::String(latest.budgetMicroseconds, 0) + " us",
+             meter.reduced(4.0f, 0.0f), juce::Justification::centredLeft);
+
+  g.drawText("p50 " + formatPercent(summary.p50Load) + "  p95 " +
+                 formatPercent(summary.p95Load) + "  p99 " +
+                 formatPercent(summary.p99Load) + "  max " +
+                 formatPercent(summary.maxLoad),
+             area.removeFromTop(rowHeight), juce::Justification::centredLeft);
+  g.drawText("Grains " + juce::String(latest.liveGrains) + " (" +
+                 juce::String(latest.sampleGrains) + " sample, " +
+                 juce::String(latest.oscillatorGrains) + " osc)  +" +
+                 juce::String(summary.spawnedPerSecond, 0) + "/s  -" +
+                 juce::String(summary.killedPerSecond, 0) + "/s",
+             area.removeFromTop(rowHeight), juce::Justification::centredLeft);
+
+  auto overrunRow = area.removeFromTop(rowHeight);
+  overrunRow.removeFromRight(resetOverrunsButton.getWidth());
+  const auto dropped = telemetry->getNumDropped();
+  g.setColour(telemetry->getNumOverruns() > 0 ? juce::Colours::red
+                                              : textColour);
+  g.drawText("Overruns " + juce::String(telemetry->getNumOverruns()) +
+                 (dropped > 0 ? "  (" + juce::String(dropped) +
+                                    " records dropped)"
+                              : juce::String()),
+             overrunRow, juce::Justification::centredLeft);
+
+  if (PerfCounters::isSupported()) {
+    g.setColour(textColour);
+    paintPerfCounters(g, area);
+  }
+}
+
+void DebugUIPanel::paintPerfCounters(juce::Graphics& g,
+                                     juce::Rectangle<int> area) const {
+  const auto& summary = telemetrySummary;
+  const int rowHeight = area.getHeight() / 2;
+  auto statusRow = area.removeFromTop(rowHeight);
+  statusRow.removeFromRight(perfCountersToggle.getWidth());
+
+  const auto state = telemetry->getPerfState();
+  if (!telemetry->isPerfCountersRequested() ||
+      state == RenderTelemetry::PerfState::Off) {
+    g.drawText("Hardware counters off", statusRow,
+               juce::Justification::centredLeft);
+    return;
+  }
+  if (state == RenderTelemetry::PerfState::Unavailable) {
+    g.drawText("Hardware counters unavailable (see perf_event_paranoid)",
+               statusRow, juce::Justification::centredLeft);
+    return;
+  }
+  if (summary.numPerfBlocks == 0)
+    return;
+
+  // Per-block means over the blocks in the history that were counted.
+  const double cycles = summary.getPerfTotal(PerfCounters::kCycles);
+  const double instructions = summary.getPerfTotal(PerfCounters::kInstructions);
+  auto perBlock = [&summary](int counter) {
+    return juce::String(summary.getPerfTotal(counter), 0);
+  };
+  const double ipc = cycles > 0.0 ? instructions / cycles : 0.0;
+  g.drawText("IPC " + juce::String(ipc, 2) + "  misses/block: L1D " +
+                 perBlock(PerfCounters::kL1DataMisses) + "  LLC " +
+                 perBlock(PerfCounters::kLastLevelMisses) + "  branch " +
+                 perBlock(PerfCounters::kBranchMisses),
+             statusRow, juce::Justification::centredLeft);
+
+  juce::String stages = "Cycles:";
+  for (int stage = 0; stage < RenderTelemetry::kNumStages; ++stage) {
+    const double stageCycles =
+        summary.perfPerBlock[static_cast<size_t>(stage)]
+                            [static_cast<size_t>(PerfCounters::kCycles)];
+    stages << " " << RenderTelemetry::getStageName(stage) << " "
+           << formatPercent(cycles > 0.0
+                                ? static_cast<float>(stageCycles / cycles)
+                                : 0.0f);
+  }
+  g.drawText(stages, area, juce::Justification::centredLeft);
 }
 
 void DebugUIPanel::resized() {
@@ -144,4 +328,23 @@ void DebugUIPanel::resized() {
   layoutRow(*panSpreadSlider, panSpreadLabel);
   layoutRow(*densitySlider, densityLabel);
   layoutRow(*temporalDistributionComboBox, temporalDistributionLabel);
+
+  auto traceRow = area.removeFromTop(rowHeight);
+  traceButton.setBounds(traceRow.removeFromLeft(labelWidth).reduced(2));
+  traceStatusLabel.setBounds(traceRow.reduced(2));
+
+  if (telemetry != nullptr) {
+    area.removeFromTop(rowHeight / 2);
+    telemetryArea = area.removeFromTop(getNumTelemetryRows() * rowHeight);
+    resetOverrunsButton.setBounds(
+        telemetryArea.withTrimmedTop(3 * rowHeight)
+            .removeFromTop(rowHeight)
+            .removeFromRight(60)
+            .reduced(2));
+    perfCountersToggle.setBounds(
+        telemetryArea.withTrimmedTop(4 * rowHeight)
+            .removeFromTop(rowHeight)
+            .removeFromRight(110)
+            .reduced(2));
+  }
 }
@@ -1,14 +1,17 @@
 #include "Pointilsynth/DebugWindow.h"
 
-DebugWindow::DebugWindow(std::shared_ptr<ConfigManager> cfg)
+DebugWindow::DebugWindow(std::shared_ptr<ConfigManager> cfg,
+                         RenderTelemetry* telemetry)
     : juce::DocumentWindow("Debug",
                            juce::Colours::lightgrey,
                            juce::DocumentWindow::allButtons) {
   setUsingNativeTitleBar(true);
   setResizable(true, true);
   setAlwaysOnTop(true);
-  setContentOwned(new DebugUIPanel(std::move(cfg)), true);
-  centreWithSize(400, 300);
+  setContentOwned(new DebugUIPanel(std::move(cfg), telemetry), true);
+  const bool showsTelemetry = telemetry != nullptr && RenderTelemetry::kEnabled;
+  const int telemetryHeight = PerfCounters::isSupported() ? 150 : 100;
+  centreWithSize(400, showsTelemetry ? 330 + telemetryHeight : 330);
 }
 
 void DebugWindow::closeButtonPressed() {
@@ -0,0 +1,40 @@
+#include "Pointilsynth/GrainDensityGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+int GrainDensityGrid::cellIndex(float pitch, float pan) {
+  const int row = std::clamp(
+      static_cast<int>(std::lround(pitch - kLowestPitch)), 0, kPitchBins - 1);
+  const int column =
+      std::clamp(static_cast<int>((pan + 1.0f) * 0.5f *
+                                  static_cast<float>(kPanBins)),
+                 0, kPanBins - 1);
+  return row * kPanBins + column;
+}
+
+bool GrainDensityGrid::publish(double blockSeconds) noexcept {
+  if (clearRequested_.load(std::memory_order_relaxed))
+    clear();
+  if (!backHasData_)
+    return false;
+  if (grids_.hasUnreadPublish()) {
+    unreadSeconds_ += blockSeconds;
+    if (unreadSeconds_ > kMaxUnreadSeconds)
+      clear();
+    return false;
+  }
+  grids_.publish().fill(0.0f);
+  backHasData_ = false;
+  unreadSeconds_ = 0.0;
+  return true;
+}
+
+void GrainDensityGrid::clear() noexcept {
+  clearRequested_.store(false, std::memory_order_relaxed);
+  grids_.getWriteBuffer().fill(0.0f);
+  if (grids_.hasUnreadPublish())
+    grids_.publish().fill(0.0f);
+  backHasData_ = false;
+  unreadSeconds_ = 0.0;
+}
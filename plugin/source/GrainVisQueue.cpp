@@ -0,0 +1,29 @@
+#include "Pointilsynth/GrainVisQueue.h"
+
+#include <algorithm>
+
+int GrainVisQueue::push(const GrainInfoForVis* records, int count) noexcept {
+  if (count <= 0)
+    return 0;
+  int start1, size1, start2, size2;
+  fifo_.prepareToWrite(count, start1, size1, start2, size2);
+  std::copy_n(records, size1, records_.begin() + start1);
+  std::copy_n(records + size1, size2, records_.begin() + start2);
+  const int written = size1 + size2;
+  fifo_.finishedWrite(written);
+  if (written < count)
+    dropped_.fetch_add(static_cast<uint32_t>(count - written),
+                       std::memory_order_relaxed);
+  return written;
+}
+
+int GrainVisQueue::drain(std::vector<GrainInfoForVis>& out) {
+  int start1, size1, start2, size2;
+  fifo_.prepareToRead(fifo_.getNumReady(), start1, size1, start2, size2);
+  out.insert(out.end(), records_.begin() + start1,
+             records_.begin() + start1 + size1);
+  out.insert(out.end(), records_.begin() + start2,
+             records_.begin() + start2 + size2);
+  fifo_.finishedRead(size1 + size2);
+  return size1 + size2;
+}
@@ -1,41 +1,153 @@
 #include "Pointilsynth/InertialHistoryManager.h"
+#include "Pointilsynth/SimdKernels.h"
 
 #include <algorithm>
 #include <cmath>
 
+namespace {
+constexpr double kTwoPi = 2.0 * M_PI;
+
+/** Calls fn(begin, end) for the one or two runs of slots that hold
+ * numNotes notes starting at head. */
+template <typename Fn>
+void forEachRun(size_t head, size_t numNotes, size_t capacity, Fn&& fn) {
+  const size_t firstEnd = std::min(head + numNotes, capacity);
+  if (head < firstEnd)
+    fn(head, firstEnd);
+  if (head + numNotes > capacity)
+    fn(size_t{0}, head + numNotes - capacity);
+}
+}  // namespace
+
 void InertialHistoryManager::addNote(int noteNumber,
                                      float velocity,
                                      double currentPpq) {
-  InertialNote note;
-  note.noteNumber = noteNumber;
-  note.initialInfluence = velocity;
-  note.currentInfluence = velocity;
-  note.startPpq = currentPpq;
-  note.ageInBars = 0.0;
-  notes_.push_back(note);
+  if (numNotes_ == kMaxNotes) {
+    size_t weakest = 0;
+    for (size_t i = 1; i < numNotes_; ++i)
+      if (influences_[slot(i)] < influences_[slot(weakest)])
+        weakest = i;
+    removeAt(weakest);
+  }
+  const size_t newSlot = slot(numNotes_++);
+  ++numNew_;
+  noteNumbers_[newSlot] = noteNumber;
+  initialInfluences_[newSlot] = velocity;
+  influences_[newSlot] = velocity;
+  startPpqs_[newSlot] = currentPpq;
+  ages_[newSlot] = 0.0;
+  lfoSines_[newSlot] = 0.0f;
+  lfoCosines_[newSlot] = 1.0f;
 }
 
 void InertialHistoryManager::update(double currentPpq, double ppqPerBar) {
-  for (auto it = notes_.begin(); it != notes_.end();) {
-    double ageInBars = (currentPpq - it->startPpq) / ppqPerBar;
-    it->ageInBars = ageInBars;
-    it->currentInfluence =
-        it->initialInfluence * static_cast<float>(std::pow(0.5, ageInBars));
-    if (it->currentInfluence < it->initialInfluence * 0.125f) {
-      it = notes_.erase(it);
-    } else {
-      ++it;
-    }
+  const double elapsedBars = (currentPpq - lastPpq_) / ppqPerBar;
+  const bool isContinuous = ppqPerBar == lastPpqPerBar_ && elapsedBars >= 0.0;
+  lastPpq_ = currentPpq;
+  lastPpqPerBar_ = ppqPerBar;
+
+  if (isContinuous && elapsedBars > 0.0) {
+    // Every note ages by elapsedBars: one decay factor and one rotation of
+    // the (sin, cos) pair serve them all. The rotation is renormalised to
+    // first order so its rounding error cannot build up.
+    const auto decay = static_cast<float>(std::exp2(-elapsedBars));
+    const double angle = kTwoPi * elapsedBars;
+    const auto rotationSin = static_cast<float>(std::sin(angle));
+    const auto rotationCos = static_cast<float>(std::cos(angle));
+    forEachRun(head_, numNotes_ - numNew_, kMaxNotes,
+               [&](size_t begin, size_t end) {
+                 for (size_t k = begin; k < end; ++k) {
+                   ages_[k] += elapsedBars;
+                   influences_[k] *= decay;
+                   const float s = lfoSines_[k] * rotationCos +
+                                   lfoCosines_[k] * rotationSin;
+                   const float c = lfoCosines_[k] * rotationCos -
+                                   lfoSines_[k] * rotationSin;
+                   const float gain = 1.5f - 0.5f * (s * s + c * c);
+                   lfoSines_[k] = s * gain;
+                   lfoCosines_[k] = c * gain;
+                 }
+               });
+  }
+
+  // New notes, and after a transport jump or metre change every note, are
+  // evaluated from their start position.
+  const size_t firstExact = isContinuous ? numNotes_ - numNew_ : 0;
+  for (size_t i = firstExact; i < numNotes_; ++i)
+    evaluateClosedForm(slot(i), currentPpq, ppqPerBar);
+  numNew_ = 0;
+
+  // Notes age together, so the expired ones are the oldest. After a jump
+  // back in time they may not be, and the whole ring is compacted instead.
+  while (numNotes_ > 0 && isExpired(head_)) {
+    head_ = (head_ + 1) & kIndexMask;
+    --numNotes_;
+  }
+  if (!isContinuous) {
+    size_t numKept = 0;
+    for (size_t i = 0; i < numNotes_; ++i)
+      if (!isExpired(slot(i)))
+        moveSlot(slot(i), slot(numKept++));
+    numNotes_ = numKept;
   }
 }
 
-float InertialHistoryManager::getModulationValue() {
+float InertialHistoryManager::getModulationValue() const {
+  const auto& kernels = SimdKernels::active();
   float totalModulation = 0.0f;
-  for (const auto& note : notes_) {
-    float lfo = std::sin(static_cast<float>(note.ageInBars) * 2.0f *
-                         static_cast<float>(M_PI)) *
-                note.currentInfluence;
-    totalModulation += lfo;
-  }
+  forEachRun(head_, numNotes_, kMaxNotes, [&](size_t begin, size_t end) {
+    totalModulation += kernels.dot(lfoSines_.data() + begin,
+                                   influences_.data() + begin,
+                                   static_cast<int>(end - begin));
+  });
   return totalModulation;
 }
+
+InertialNote InertialHistoryManager::getNote(size_t index) const {
+  const size_t k = slot(index);
+  InertialNote note;
+  note.noteNumber = noteNumbers_[k];
+  note.initialInfluence = initialInfluences_[k];
+  note.currentInfluence = influences_[k];
+  note.startPpq = startPpqs_[k];
+  note.ageInBars = ages_[k];
+  return note;
+}
+
+void InertialHistoryManager::publishSnapshot() noexcept {
+  auto& snapshot = snapshots_.getWriteBuffer();
+  for (size_t i = 0; i < numNotes_; ++i)
+    snapshot.notes[i] = getNote(i);
+  snapshot.numNotes = numNotes_;
+  snapshots_.publish();
+}
+
+void InertialHistoryManager::evaluateClosedForm(size_t k,
+                                                double currentPpq,
+                                                double ppqPerBar) {
+  const double ageInBars = (currentPpq - startPpqs_[k]) / ppqPerBar;
+  const double phase = kTwoPi * (ageInBars - std::floor(ageInBars));
+  ages_[k] = ageInBars;
+  influences_[k] =
+      initialInfluences_[k] * static_cast<float>(std::exp2(-ageInBars));
+  lfoSines_[k] = static_cast<float>(std::sin(phase));
+  lfoCosines_[k] = static_cast<float>(std::cos(phase));
+}
+
+void InertialHistoryManager::moveSlot(size_t from, size_t to) {
+  noteNumbers_[to] = noteNumbers_[from];
+  initialInfluences_[to] = initialInfluences_[from];
+  influences_[to] = influences_[from];
+  startPpqs_[to] = startPpqs_[from];
+  ages_[to] = ages_[from];
+  lfoSines_[to] = lfoSines_[from];
+  lfoCosines_[to] = lfoCosines_[from];
+}
+
+void InertialHistoryManager::removeAt(size_t index) {
+  for (size_t i = index + 1; i < numNotes_; ++i)
+    moveSlot(slot(i), slot(i - 1));
+  if (index >= numNotes_ - numNew_)
+    --numNew_;
+  --numNotes_;
+}
@@ -0,0 +1,168 @@
+#include "Pointilsynth/ModulationMatrix.h"
+
+#include <algorithm>
+#include <cmath>
+
+bool ModulationMatrix::addRoute(Source source,
+                                Destination destination,
+                                float depth) {
+  if (staging_.numRoutes == kMaxRoutes)
+    return false;
+  const auto route = static_cast<size_t>(staging_.numRoutes++);
+  staging_.sources[route] = source;
+  staging_.destinations[route] = destination;
+  staging_.depths[route] = depth;
+  publishSettings();
+  return true;
+}
+
+void ModulationMatrix::clearRoutes() {
+  staging_.numRoutes = 0;
+  publishSettings();
+}
+
+void ModulationMatrix::setLfo(int index, LfoSettings settings) {
+  staging_.lfos[static_cast<size_t>(std::clamp(index, 0, kNumLfos - 1))] =
+      settings;
+  publishSettings();
+}
+
+void ModulationMatrix::setEnvelope(EnvelopeSettings settings) {
+  staging_.envelope = settings;
+  publishSettings();
+}
+
+void ModulationMatrix::publishSettings() {
+  // The buffer handed back by publish() holds stale settings, so every
+  // publish writes the whole table.
+  published_.getWriteBuffer() = staging_;
+  published_.publish();
+}
+
+void ModulationMatrix::prepare(double sampleRate) {
+  sampleRate_ = sampleRate;
+  if (const auto* settings = published_.acquire())
+    settings_ = *settings;
+}
+
+void ModulationMatrix::noteOn(float velocity) {
+  envelopeVelocity_ = velocity;
+  envelopeStage_ = EnvelopeStage::Attack;
+}
+
+void ModulationMatrix::noteOff() {
+  if (envelopeStage_ == EnvelopeStage::Idle ||
+      envelopeStage_ == EnvelopeStage::Release)
+    return;
+  envelopeStage_ = EnvelopeStage::Release;
+  releaseStep_ = envelopeLevel_ / msToSamples(settings_.envelope.releaseMs);
+}
+
+bool ModulationMatrix::isRouted(Source source) const {
+  for (int route = 0; route < settings_.numRoutes; ++route)
+    if (settings_.sources[static_cast<size_t>(route)] == source)
+      return true;
+  return false;
+}
+
+void ModulationMatrix::process(int numSamples, float inertia) {
+  if (const auto* settings = published_.acquire())
+    settings_ = *settings;
+
+  sourceValues_[static_cast<size_t>(Source::Lfo1)] = lfoValue(0);
+  sourceValues_[static_cast<size_t>(Source::Lfo2)] = lfoValue(1);
+  sourceValues_[static_cast<size_t>(Source::Envelope)] =
+      envelopeLevel_ * envelopeVelocity_;
+  sourceValues_[static_cast<size_t>(Source::Inertia)] =
+      std::clamp(inertia, -1.0f, 1.0f);
+
+  offsets_.fill(0.0f);
+  for (int route = 0; route < settings_.numRoutes; ++route) {
+    const auto r = static_cast<size_t>(route);
+    offsets_[static_cast<size_t>(settings_.destinations[r])] +=
+        settings_.depths[r] *
+        sourceValues_[static_cast<size_t>(settings_.sources[r])];
+  }
+
+  for (size_t lfo = 0; lfo < lfoPhases_.size(); ++lfo) {
+    auto& phase = lfoPhases_[lfo];
+    phase += static_cast<double>(settings_.lfos[lfo].rateHz) * numSamples /
+             sampleRate_;
+    phase -= std::floor(phase);
+  }
+  advanceEnvelope(numSamples);
+}
+
+float ModulationMatrix::lfoValue(int index) const {
+  const auto lfo = static_cast<size_t>(index);
+  const auto phase = static_cast<float>(lfoPhases_[lfo]);
+  switch (settings_.lfos[lfo].shape) {
+    case LfoShape::Sine:
+      return std::sin(phase * 2.0f * static_cast<float>(M_PI));
+    case LfoShape::Triangle:
+      return 1.0f - 4.0f * std::abs(phase - 0.5f);
+    case LfoShape::Saw:
+      return 2.0f * phase - 1.0f;
+    case LfoShape::Square:
+      return phase < 0.5f ? 1.0f : -1.0f;
+  }
+  return 0.0f;
+}
+
+float ModulationMatrix::msToSamples(float ms) const {
+  return std::max(1.0f, ms * 0.001f * static_cast<float>(sampleRate_));
+}
+
+void ModulationMatrix::advanceEnvelope(int numSamples) {
+  // Linear segments, stepped once per sub-block.
+  const auto& envelope = settings_.envelope;
+  auto remaining = static_cast<float>(numSamples);
+  while (remaining > 0.0f) {
+    switch (envelopeStage_) {
+      case EnvelopeStage::Idle:
+      case EnvelopeStage::Sustain:
+        envelopeLevel_ = envelopeStage_ == EnvelopeStage::Idle
+                             ? 0.0f
+                             : std::clamp(envelope.sustain, 0.0f, 1.0f);
+        return;
+      case EnvelopeStage::Attack: {
+        const float step = 1.0f / msToSamples(envelope.attackMs);
+        const float needed = (1.0f - envelopeLevel_) / step;
+        if (needed > remaining) {
+          envelopeLevel_ += step * remaining;
+          return;
+        }
+        envelopeLevel_ = 1.0f;
+        remaining -= needed;
+        envelopeStage_ = EnvelopeStage::Decay;
+        break;
+      }
+      case EnvelopeStage::Decay: {
+        const float sustain = std::clamp(envelope.sustain, 0.0f, 1.0f);
+        const float step = (1.0f - sustain) / msToSamples(envelope.decayMs);
+        const float needed =
+            step > 0.0f ? (envelopeLevel_ - sustain) / step : 0.0f;
+        if (needed > remaining) {
+          envelopeLevel_ -= step * remaining;
+          return;
+        }
+        envelopeLevel_ = sustain;
+        remaining -= needed;
+        envelopeStage_ = EnvelopeStage::Sustain;
+        break;
+      }
+      case EnvelopeStage::Release: {
+        const float needed =
+            releaseStep_ > 0.0f ? envelopeLevel_ / releaseStep_ : 0.0f;
+        if (needed > remaining) {
+          envelopeLevel_ -= releaseStep_ * remaining;
+          return;
+        }
+        envelopeLevel_ = 0.0f;
+        remaining -= needed;
+        envelopeStage_ = EnvelopeStage::Idle;
+        break;
+      }
+    }
+  }
+}
@@ -0,0 +1,172 @@
+#include "Pointilsynth/PerfCounters.h"
+
+#if JUCE_LINUX
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+
+PerfCounters::Counts& PerfCounters::Counts::operator+=(const Counts& other) {
+  for (size_t i = 0; i < values.size(); ++i)
+    values[i] += other.values[i];
+  timeEnabled += other.timeEnabled;
+  timeRunning += other.timeRunning;
+  return *this;
+}
+
+PerfCounters::Counts PerfCounters::Counts::operator-(
+    const Counts& other) const {
+  auto minus = [](uint64_t a, uint64_t b) { return a >= b ? a - b : 0; };
+  Counts difference;
+  for (size_t i = 0; i < values.size(); ++i)
+    difference.values[i] = minus(values[i], other.values[i]);
+  difference.timeEnabled = minus(timeEnabled, other.timeEnabled);
+  difference.timeRunning = minus(timeRunning, other.timeRunning);
+  return difference;
+}
+
+PerfCounters::~PerfCounters() {
+  close();
+}
+
+const char* PerfCounters::getName(int counter) {
+  switch (counter) {
+    case kCycles:
+      return "cycles";
+    case kInstructions:
+      return "instructions";
+    case kL1DataMisses:
+      return "l1dMisses";
+    case kLastLevelMisses:
+      return "llcMisses";
+    case kBranchMisses:
+      return "branchMisses";
+    default:
+      return "unknown";
+  }
+}
+
+#if JUCE_LINUX
+namespace {
+perf_event_attr makeAttributes(int counter) {
+  perf_event_attr attributes;
+  std::memset(&attributes, 0, sizeof(attributes));
+  attributes.size = sizeof(attributes);
+  attributes.exclude_kernel = 1;
+  attributes.exclude_hv = 1;
+  attributes.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                           PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+  auto cacheMiss = [](perf_hw_cache_id cache) {
+    return static_cast<uint64_t>(cache) |
+           (static_cast<uint64_t>(PERF_COUNT_HW_CACHE_OP_READ) << 8) |
+           (static_cast<uint64_t>(PERF_COUNT_HW_CACHE_RESULT_MISS) << 16);
+  };
+  switch (counter) {
+    case PerfCounters::kCycles:
+      attributes.type = PERF_TYPE_HARDWARE;
+      attributes.config = PERF_COUNT_HW_CPU_CYCLES;
+      attributes.disabled = 1;  // The group leader starts disabled.
+      break;
+    case PerfCounters::kInstructions:
+      attributes.type = PERF_TYPE_HARDWARE;
+      attributes.config = PERF_COUNT_HW_INSTRUCTIONS;
+      break;
+    case PerfCounters::kL1DataMisses:
+      attributes.type = PERF_TYPE_HW_CACHE;
+      attributes.config = cacheMiss(PERF_COUNT_HW_CACHE_L1D);
+      break;
+    case PerfCounters::kLastLevelMisses:
+      attributes.type = PERF_TYPE_HW_CACHE;
+      attributes.config = cacheMiss(PERF_COUNT_HW_CACHE_LL);
+      break;
+    case PerfCounters::kBranchMisses:
+    default:
+      attributes.type = PERF_TYPE_HARDWARE;
+      attributes.config = PERF_COUNT_HW_BRANCH_MISSES;
+      break;
+  }
+  return attributes;
+}
+
+int openCounter(perf_event_attr& attributes, int groupFd) {
+  return static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1,
+                                  groupFd, PERF_FLAG_FD_CLOEXEC));
+}
+}  // namespace
+
+bool PerfCounters::isSupported() {
+  return true;
+}
+
+bool PerfCounters::open() {
+  close();
+  for (int counter = 0; counter < kNumCounters; ++counter) {
+    auto attributes = makeAttributes(counter);
+    const int fd = openCounter(attributes, groupFd_);
+    if (fd < 0) {
+      if (counter == kCycles)
+        return false;
+      continue;  // Not every CPU or VM provides every counter.
+    }
+    if (counter == kCycles)
+      groupFd_ = fd;
+    fds_[static_cast<size_t>(counter)] = fd;
+    groupSlot_[static_cast<size_t>(counter)] = numInGroup_++;
+  }
+  ioctl(groupFd_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(groupFd_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  return true;
+}
+
+void PerfCounters::close() {
+  for (auto& fd : fds_) {
+    if (fd >= 0)
+      ::close(fd);
+    fd = -1;
+  }
+  groupSlot_.fill(-1);
+  groupFd_ = -1;
+  numInGroup_ = 0;
+}
+
+PerfCounters::Counts PerfCounters::read() const noexcept {
+  Counts counts;
+  if (groupFd_ < 0)
+    return counts;
+
+  // Group read layout: the number of counters, the enabled and running
+  // times, then the counter values.
+  constexpr size_t kNumHeaderWords = 3;
+  std::array<uint64_t, kNumHeaderWords + kNumCounters> buffer{};
+  const auto bytes = ::read(groupFd_, buffer.data(), sizeof(buffer));
+  if (bytes < static_cast<ssize_t>(kNumHeaderWords * sizeof(uint64_t)))
+    return counts;
+  counts.timeEnabled = buffer[1];
+  counts.timeRunning = buffer[2];
+  for (size_t counter = 0; counter < counts.values.size(); ++counter) {
+    const int slot = groupSlot_[counter];
+    if (slot >= 0 && static_cast<uint64_t>(slot) < buffer[0])
+      counts.values[counter] =
+          buffer[kNumHeaderWords + static_cast<size_t>(slot)];
+  }
+  return counts;
+}
+#else
+bool PerfCounters::isSupported() {
+  return false;
+}
+
+bool PerfCounters::open() {
+  return false;
+}
+
+void PerfCounters::close() {}
+
+PerfCounters::Counts PerfCounters::read() const noexcept {
+  return {};
+}
+#endif
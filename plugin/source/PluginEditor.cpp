@@ -7,15 +7,15 @@ namespace audio_plugin {
 
 PointillisticSynthAudioProcessorEditor::PointillisticSynthAudioProcessorEditor(
     audio_plugin::AudioPluginAudioProcessor& p,
-    juce::AbstractFifo& fifo,
-    GrainInfoForVis* buffer)
+    GrainVisQueue& visQueue,
+    GrainDensityGrid& densityGrid)
     : juce::AudioProcessorEditor(&p),
       processorRef(p),
       pitchPod(ConfigManager::ParamID::pitch, "Pitch"),
       densityPod(ConfigManager::ParamID::density, "Density"),
       durationPod(ConfigManager::ParamID::avgDuration, "Duration"),
       panPod(ConfigManager::ParamID::pan, "Pan"),
-      visualizationComponent(fifo, buffer) {
+      visualizationComponent(visQueue, densityGrid, &p.getGrainSnapshots()) {
   addAndMakeVisible(visualizationComponent);
   addAndMakeVisible(debugButton);
   addAndMakeVisible(pitchPod);
@@ -25,8 +25,8 @@ PointillisticSynthAudioProcessorEditor::PointillisticSynthAudioProcessorEditor(
 
   debugButton.onClick = [this] {
     if (!debugWindow)
-      debugWindow =
-          std::make_unique<DebugWindow>(processorRef.getConfigManager());
+      debugWindow = std::make_unique<DebugWindow>(
+          processorRef.getConfigManager(), &processorRef.getRenderTelemetry());
     debugWindow->setVisible(true);
     debugWindow->toFront(true);
   };
@@ -2,6 +2,7 @@
 #include "Pointilsynth/PluginProcessor.h"
 #include "Pointilsynth/PluginEditor.h"
 #include "Pointilsynth/ConfigManager.h"
+#include "Pointilsynth/SpanTracer.h"
 #include <juce_dsp/juce_dsp.h>
 
 namespace audio_plugin {
@@ -16,9 +17,15 @@ AudioPluginAudioProcessor::AudioPluginAudioProcessor()
 #endif
               ),
       configManager(ConfigManager::getInstance(this)),
-      audioEngine(configManager,
-                  &visualizationFifo,
-                  visualizationBuffer.data()) {
+      audioEngine(configManager->getParameterHandles(),
+                  &visQueue_,
+                  &densityGrid_) {
+  audioEngine.setLogger(&rtLogger_);
+  audioEngine.setTelemetry(&renderTelemetry_);
+  audioEngine.setGrainSnapshots(&grainSnapshots_);
+#if JUCE_DEBUG
+  rtLogger_.startDrainingToConsole();
+#endif
 }
 
 AudioPluginAudioProcessor::~AudioPluginAudioProcessor() {
@@ -132,35 +139,18 @@ bool AudioPluginAudioProcessor::isBusesLayoutSupported(
 void AudioPluginAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer,
                                              juce::MidiBuffer& midiMessages) {
   // juce::ignoreUnused(midiMessages); // We will use midiMessages now
+  SpanTracer::nameCurrentThread("Audio thread");
+  POINTILSYNTH_TRACE_SCOPE("PluginProcessor::processBlock");
 
-  for (const auto metadata : midiMessages) {
-    const auto msg = metadata.getMessage();
-    if (msg.isNoteOn()) {
-      int noteNumber = msg.getNoteNumber();
-      float velocity = static_cast<float>(msg.getVelocity()) / 127.0f;
-      DBG("PluginProcessor::processBlock - MIDI Note On: Note " +
-          juce::String(noteNumber) + ", Velocity: " + juce::String(velocity));
-      audioEngine.applyMidiInfluence(noteNumber, velocity);
-      activeMidiNote_.store(noteNumber);
-    } else if (msg.isNoteOff()) {
-      int noteNumber = msg.getNoteNumber();
-      DBG("PluginProcessor::processBlock - MIDI Note Off: Note " +
-          juce::String(noteNumber));
-      if (activeMidiNote_.load() == noteNumber) {
-        DBG("PluginProcessor::processBlock - Resetting MIDI influence for "
-            "Note " +
-            juce::String(noteNumber));
-        audioEngine.applyMidiInfluence(noteNumber, 0.0f);
-        activeMidiNote_.store(-1);  // Reset active MIDI note
-      }
-    }
+  juce::AudioPlayHead::PositionInfo pos{};
+  if (auto* ph = getPlayHead()) {
+    if (auto opt = ph->getPosition())
+      pos = *opt;
   }
-  // It's good practice to clear MIDI messages you've processed if they aren't
-  // needed downstream, though in this plugin architecture, AudioEngine's
-  // processBlock receives it again. If AudioEngine itself doesn't process MIDI,
-  // you might clear it here: midiMessages.clear(); However, since
-  // AudioEngine::processBlock takes midiMessages as an argument, it might still
-  // need them. For now, let's assume AudioEngine might use them or ignore them.
+  sessionTrace_.captureBlock(buffer.getNumSamples(), pos, midiMessages);
+
+  // MIDI is handled, and logged, by the AudioEngine at each event's sample
+  // position.
 
   juce::ScopedNoDenormals noDenormals;
   auto totalNumInputChannels = getTotalNumInputChannels();
@@ -187,11 +177,6 @@ void AudioPluginAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer,
   //   juce::ignoreUnused(channelData);
   //   // ..do something to the data...
   // }
-  juce::AudioPlayHead::PositionInfo pos{};
-  if (auto* ph = getPlayHead()) {
-    if (auto opt = ph->getPosition())
-      pos = *opt;
-  }
   audioEngine.processBlock(buffer, midiMessages, pos);
 
   juce::dsp::AudioBlock<float> block(buffer);
@@ -199,13 +184,21 @@ void AudioPluginAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer,
   outputCompressor.process(context);
 }
 
+bool AudioPluginAudioProcessor::startSessionCapture(const juce::File& file) {
+  return sessionTrace_.start(file, *this);
+}
+
+void AudioPluginAudioProcessor::stopSessionCapture() {
+  sessionTrace_.stop();
+}
+
 bool AudioPluginAudioProcessor::hasEditor() const {
   return true;  // (change this to false if you choose to not supply an editor)
 }
 
 juce::AudioProcessorEditor* AudioPluginAudioProcessor::createEditor() {
-  return new PointillisticSynthAudioProcessorEditor(*this, visualizationFifo,
-                                                    visualizationBuffer.data());
+  return new PointillisticSynthAudioProcessorEditor(*this, visQueue_,
+                                                    densityGrid_);
 }
 
 void AudioPluginAudioProcessor::getStateInformation(
@@ -1,5 +1,5 @@
 #include "Pointilsynth/PresetManager.h"
-#include "Pointilsynth/ConfigManager.h"
+#include "Pointilsynth/SpanTracer.h"
 #include "juce_core/juce_core.h"  // For juce::File
 #include "nlohmann/json.hpp"      // For nlohmann::json
 
@@ -38,6 +38,7 @@ bool PresetManager::savePreset(const juce::File& fileToSave) {
 }
 
 bool PresetManager::loadPreset(const juce::File& fileToLoad) {
+  POINTILSYNTH_TRACE_SCOPE("PresetManager::loadPreset");
   juce::FileInputStream in(fileToLoad);
   if (!in.openedOk()) {
     return false;
@@ -51,6 +52,11 @@ bool PresetManager::loadPreset(const juce::File& fileToLoad) {
     return false;
   }
 
+  applyPreset(j);
+  return true;
+}
+
+void PresetManager::applyPreset(const nlohmann::json& j) {
   if (j.contains("pitch") && j.contains("dispersion"))
     model_.setPitchAndDispersion(j["pitch"].get<float>(),
                                  j["dispersion"].get<float>());
@@ -85,8 +91,6 @@ bool PresetManager::loadPreset(const juce::File& fileToLoad) {
     model_.setGlobalTemporalDistribution(
         static_cast<StochasticModel::TemporalDistribution>(
             j["globalTemporalDistribution"].get<int>()));
-
-  return true;
 }
 
 }  // namespace Pointilism
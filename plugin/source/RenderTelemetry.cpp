@@ -0,0 +1,116 @@
+#include "Pointilsynth/RenderTelemetry.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Nearest-rank percentile of sorted, which must not be empty.
+float percentile(const std::vector<float>& sorted, float percent) {
+  const auto rank = static_cast<size_t>(
+      std::ceil(percent / 100.0f * static_cast<float>(sorted.size())));
+  return sorted[std::clamp(rank, size_t{1}, sorted.size()) - 1];
+}
+}  // namespace
+
+const char* RenderTelemetry::getStageName(int stage) {
+  switch (stage) {
+    case kControlStage:
+      return "control";
+    case kRenderStage:
+      return "render";
+    case kOutputStage:
+      return "output";
+    case kCleanupStage:
+      return "cleanup";
+    default:
+      return "unknown";
+  }
+}
+
+double RenderTelemetry::Summary::getPerfTotal(int counter) const {
+  double total = 0.0;
+  for (const auto& stage : perfPerBlock)
+    total += stage[static_cast<size_t>(counter)];
+  return total;
+}
+
+bool RenderTelemetry::push(const BlockStats& stats) noexcept {
+  if (stats.isOverrun())
+    overruns_.fetch_add(1, std::memory_order_relaxed);
+
+  int start1, size1, start2, size2;
+  fifo_.prepareToWrite(1, start1, size1, start2, size2);
+  if (size1 + size2 < 1) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  records_[static_cast<size_t>(size1 > 0 ? start1 : start2)] = stats;
+  fifo_.finishedWrite(1);
+  return true;
+}
+
+int RenderTelemetry::drain(std::vector<BlockStats>& history,
+                           size_t maxHistory) {
+  int start1, size1, start2, size2;
+  fifo_.prepareToRead(fifo_.getNumReady(), start1, size1, start2, size2);
+  for (int i = 0; i < size1; ++i)
+    history.push_back(records_[static_cast<size_t>(start1 + i)]);
+  for (int i = 0; i < size2; ++i)
+    history.push_back(records_[static_cast<size_t>(start2 + i)]);
+  fifo_.finishedRead(size1 + size2);
+
+  if (history.size() > maxHistory)
+    history.erase(history.begin(),
+                  history.end() - static_cast<std::ptrdiff_t>(maxHistory));
+  return size1 + size2;
+}
+
+RenderTelemetry::Summary RenderTelemetry::summarise(
+    const std::vector<BlockStats>& blocks) {
+  Summary summary;
+  if (blocks.empty())
+    return summary;
+
+  std::vector<float> loads;
+  loads.reserve(blocks.size());
+  double loadSum = 0.0;
+  double budgetMicroseconds = 0.0;
+  int spawned = 0;
+  int killed = 0;
+  for (const auto& block : blocks) {
+    loads.push_back(block.getLoad());
+    loadSum += static_cast<double>(block.getLoad());
+    budgetMicroseconds += static_cast<double>(block.budgetMicroseconds);
+    spawned += block.grainsSpawned;
+    killed += block.grainsKilled;
+    summary.numOverruns += block.isOverrun() ? 1 : 0;
+    if (block.hasPerfCounts) {
+      ++summary.numPerfBlocks;
+      for (size_t stage = 0; stage < summary.perfPerBlock.size(); ++stage)
+        for (size_t counter = 0; counter < PerfCounters::kNumCounters;
+             ++counter)
+          summary.perfPerBlock[stage][counter] += static_cast<double>(
+              block.stageCounts[stage].values[counter]);
+    }
+  }
+  if (summary.numPerfBlocks > 0)
+    for (auto& stage : summary.perfPerBlock)
+      for (auto& count : stage)
+        count /= summary.numPerfBlocks;
+  std::sort(loads.begin(), loads.end());
+
+  summary.numBlocks = static_cast<int>(blocks.size());
+  summary.meanLoad =
+      static_cast<float>(loadSum / static_cast<double>(blocks.size()));
+  summary.p50Load = percentile(loads, 50.0f);
+  summary.p95Load = percentile(loads, 95.0f);
+  summary.p99Load = percentile(loads, 99.0f);
+  summary.maxLoad = loads.back();
+  if (budgetMicroseconds > 0.0) {
+    const double seconds = budgetMicroseconds / 1.0e6;
+    summary.spawnedPerSecond = static_cast<float>(spawned / seconds);
+    summary.killedPerSecond = static_cast<float>(killed / seconds);
+  }
+  summary.latest = blocks.back();
+  return summary;
+}
@@ -0,0 +1,145 @@
+#include "Pointilsynth/RtLogger.h"
+#include "Pointilsynth/SpanTracer.h"
+
+#include <cmath>
+
+namespace {
+struct EventFormat {
+  const char* message;
+  std::array<const char*, RtLogger::kMaxArgs> argNames;
+};
+
+EventFormat getEventFormat(RtLogEvent event) {
+  switch (event) {
+    case RtLogEvent::MidiNoteOn:
+      return {"AudioEngine::handleMidiEvent - MIDI Note On",
+              {"Note", "Velocity"}};
+    case RtLogEvent::MidiNoteOff:
+      return {"AudioEngine::handleMidiEvent - MIDI Note Off", {"Note"}};
+    case RtLogEvent::MidiInfluenceReset:
+      return {"AudioEngine::handleMidiEvent - Voice released", {"Note"}};
+    case RtLogEvent::GrainMidiInfluence:
+      return {"StochasticModel::generateNewGrain - MIDI Influence Active",
+              {"Base Pitch", "Target Pitch", "Influence", "Effective Pitch"}};
+  }
+  return {"Unknown event", {}};
+}
+
+juce::String formatArg(float value) {
+  // Note numbers and counts are logged as floats; print them as integers.
+  if (juce::exactlyEqual(value, std::round(value)) &&
+      std::abs(value) < 1.0e7f)
+    return juce::String(juce::roundToInt(value));
+  return juce::String(value);
+}
+}  // namespace
+
+RtLogger::RtLogger() : juce::Thread("RtLogger drain") {}
+
+RtLogger::~RtLogger() {
+  stopDraining();
+}
+
+bool RtLogger::push(const Record& record) noexcept {
+  POINTILSYNTH_TRACE_SCOPE("RtLogger push");
+  int start1, size1, start2, size2;
+  fifo_.prepareToWrite(1, start1, size1, start2, size2);
+  if (size1 + size2 < 1) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  records_[static_cast<size_t>(size1 > 0 ? start1 : start2)] = record;
+  fifo_.finishedWrite(1);
+  return true;
+}
+
+int RtLogger::drain(const Sink& sink) {
+  int numDrained = 0;
+  int start1, size1, start2, size2;
+  fifo_.prepareToRead(fifo_.getNumReady(), start1, size1, start2, size2);
+  for (int i = 0; i < size1; ++i)
+    sink(format(records_[static_cast<size_t>(start1 + i)]));
+  for (int i = 0; i < size2; ++i)
+    sink(format(records_[static_cast<size_t>(start2 + i)]));
+  numDrained = size1 + size2;
+  fifo_.finishedRead(numDrained);
+
+  const auto dropped = dropped_.load(std::memory_order_relaxed);
+  if (dropped != droppedReported_) {
+    sink("RtLogger: dropped " + juce::String(dropped - droppedReported_) +
+         " records (ring full)");
+    droppedReported_ = dropped;
+  }
+  return numDrained;
+}
+
+const char* RtLogger::getFormat(RtLogEvent event) {
+  return getEventFormat(event).message;
+}
+
+juce::String RtLogger::format(const Record& record) {
+  const auto eventFormat = getEventFormat(record.event);
+  const double ms = juce::Time::highResolutionTicksToSeconds(record.ticks) *
+                    1000.0;
+  juce::String text =
+      "[" + juce::String(ms, 3) + " ms] " + eventFormat.message;
+  for (int i = 0; i < record.numArgs && i < kMaxArgs; ++i) {
+    const auto index = static_cast<size_t>(i);
+    text << (i == 0 ? ": " : ", ");
+    if (eventFormat.argNames[index] != nullptr)
+      text << eventFormat.argNames[index] << " ";
+    text << formatArg(record.args[index]);
+  }
+  return text;
+}
+
+void RtLogger::startDraining(Sink sink, int intervalMs) {
+  stopDraining();
+  launch(std::move(sink), intervalMs);
+}
+
+void RtLogger::startDrainingToConsole() {
+  startDraining(
+      [](const juce::String& line) { juce::Logger::outputDebugString(line); });
+}
+
+void RtLogger::startDrainingToFile(const juce::File& file) {
+  stopDraining();
+  file_ = std::make_unique<juce::FileOutputStream>(file);
+  if (file_->failedToOpen()) {
+    file_.reset();
+    return;
+  }
+  launch(
+      [this](const juce::String& line) {
+        file_->writeText(line + "\n", false, false, nullptr);
+      },
+      50);
+}
+
+void RtLogger::stopDraining() {
+  enabled_.store(false);
+  if (isThreadRunning())
+    stopThread(1000);
+  if (sink_)
+    drain(sink_);
+  sink_ = nullptr;
+  if (file_ != nullptr)
+    file_->flush();
+  file_.reset();
+}
+
+void RtLogger::launch(Sink sink, int intervalMs) {
+  sink_ = std::move(sink);
+  intervalMs_ = juce::jmax(1, intervalMs);
+  enabled_.store(true);
+  startThread(juce::Thread::Priority::background);
+}
+
+void RtLogger::run() {
+  while (!threadShouldExit()) {
+    if (drain(sink_) > 0 && file_ != nullptr)
+      file_->flush();
+    wait(intervalMs_);
+  }
+}
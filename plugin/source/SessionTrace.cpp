@@ -0,0 +1,449 @@
+#include "Pointilsynth/SessionTrace.h"
+#include "Pointilsynth/SpanTracer.h"
+
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+namespace SessionTrace {
+namespace {
+constexpr char kMagic[4] = {'P', 'S', 'T', 'R'};
+
+// Bits of the per-block positionFlags byte.
+enum PositionFlag : uint8_t {
+  kHasPpq = 1 << 0,
+  kHasBpm = 1 << 1,
+  kHasTimeSignature = 1 << 2,
+  kHasTimeInSamples = 1 << 3,
+  kHasBarStart = 1 << 4,
+  kIsPlaying = 1 << 5,
+  kIsRecording = 1 << 6,
+  kIsLooping = 1 << 7,
+};
+
+/** Appends plain values to a fixed buffer; fails instead of overflowing. */
+class ByteWriter {
+public:
+  ByteWriter(uint8_t* data, size_t capacity)
+      : data_(data), capacity_(capacity) {}
+
+  template <typename T>
+  bool put(const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    return putBytes(&value, sizeof(T));
+  }
+
+  bool putBytes(const void* bytes, size_t numBytes) {
+    if (size_ + numBytes > capacity_)
+      return false;
+    std::memcpy(data_ + size_, bytes, numBytes);
+    size_ += numBytes;
+    return true;
+  }
+
+  uint8_t* reserve(size_t numBytes) {
+    if (size_ + numBytes > capacity_)
+      return nullptr;
+    auto* slot = data_ + size_;
+    size_ += numBytes;
+    return slot;
+  }
+
+  size_t size() const { return size_; }
+
+private:
+  uint8_t* data_;
+  size_t capacity_;
+  size_t size_ = 0;
+};
+
+bool writePosition(ByteWriter& out,
+                   const juce::AudioPlayHead::PositionInfo& position) {
+  uint8_t flags = 0;
+  if (position.getPpqPosition())
+    flags |= kHasPpq;
+  if (position.getBpm())
+    flags |= kHasBpm;
+  if (position.getTimeSignature())
+    flags |= kHasTimeSignature;
+  if (position.getTimeInSamples())
+    flags |= kHasTimeInSamples;
+  if (position.getPpqPositionOfLastBarStart())
+    flags |= kHasBarStart;
+  if (position.getIsPlaying())
+    flags |= kIsPlaying;
+  if (position.getIsRecording())
+    flags |= kIsRecording;
+  if (position.getIsLooping())
+    flags |= kIsLooping;
+
+  bool ok = out.put(flags);
+  if (auto ppq = position.getPpqPosition())
+    ok = ok && out.put(*ppq);
+  if (auto bpm = position.getBpm())
+    ok = ok && out.put(*bpm);
+  if (auto signature = position.getTimeSignature()) {
+    ok = ok && out.put(static_cast<int32_t>(signature->numerator)) &&
+         out.put(static_cast<int32_t>(signature->denominator));
+  }
+  if (auto time = position.getTimeInSamples())
+    ok = ok && out.put(static_cast<int64_t>(*time));
+  if (auto barStart = position.getPpqPositionOfLastBarStart())
+    ok = ok && out.put(*barStart);
+  return ok;
+}
+
+/** Copies numBytes into the ring, which the caller has checked has room. */
+void writeToRing(juce::AbstractFifo& fifo,
+                 uint8_t* ring,
+                 const uint8_t* bytes,
+                 int numBytes) {
+  int start1, size1, start2, size2;
+  fifo.prepareToWrite(numBytes, start1, size1, start2, size2);
+  std::memcpy(ring + start1, bytes, static_cast<size_t>(size1));
+  if (size2 > 0)
+    std::memcpy(ring + start2, bytes + size1, static_cast<size_t>(size2));
+  fifo.finishedWrite(size1 + size2);
+}
+}  // namespace
+
+//==============================================================================
+Writer::Writer() : juce::Thread("SessionTrace writer") {}
+
+Writer::~Writer() {
+  stop();
+}
+
+bool Writer::start(const juce::File& file, juce::AudioProcessor& processor) {
+  stop();
+  file.deleteFile();
+  file_ = std::make_unique<juce::FileOutputStream>(file);
+  if (file_->failedToOpen()) {
+    file_.reset();
+    return false;
+  }
+
+  ring_.assign(static_cast<size_t>(kRingBytes), 0);
+  scratch_.assign(static_cast<size_t>(kMaxBlockBytes), 0);
+  fifo_.reset();
+  dropped_.store(0);
+
+  parameters_ = processor.getParameters();
+  lastValues_.clear();
+  resyncParameters_ = false;
+  file_->write(kMagic, sizeof(kMagic));
+  const uint32_t version = kVersion;
+  const double sampleRate = processor.getSampleRate();
+  const auto numParameters = static_cast<int32_t>(parameters_.size());
+  file_->write(&version, sizeof(version));
+  file_->write(&sampleRate, sizeof(sampleRate));
+  file_->write(&numParameters, sizeof(numParameters));
+  for (auto* parameter : parameters_) {
+    juce::String id;
+    if (auto* hosted =
+            dynamic_cast<juce::HostedAudioProcessorParameter*>(parameter))
+      id = hosted->getParameterID();
+    const auto utf8 = id.toStdString();
+    const auto length = static_cast<uint16_t>(utf8.size());
+    const float value = parameter->getValue();
+    file_->write(&length, sizeof(length));
+    file_->write(utf8.data(), length);
+    file_->write(&value, sizeof(value));
+    lastValues_.push_back(value);
+  }
+
+  capturing_.store(true);
+  startThread(juce::Thread::Priority::background);
+  return true;
+}
+
+void Writer::stop() {
+  capturing_.store(false);
+  // Wait out a captureBlock() that saw capturing_ still set.
+  while (audioThreadBusy_.load())
+    std::this_thread::yield();
+  if (isThreadRunning())
+    stopThread(1000);
+  if (file_ != nullptr) {
+    drain();
+    file_->flush();
+    file_.reset();
+  }
+}
+
+void Writer::captureBlock(int numSamples,
+                          const juce::AudioPlayHead::PositionInfo& position,
+                          const juce::MidiBuffer& midi) noexcept {
+  // Paired with stop(): either stop() sees the busy flag and waits, or this
+  // sees capturing_ cleared and returns without touching the buffers.
+  audioThreadBusy_.store(true);
+  if (capturing_.load()) {
+    POINTILSYNTH_TRACE_SCOPE("SessionTrace capture");
+    serialiseBlock(numSamples, position, midi);
+  }
+  audioThreadBusy_.store(false);
+}
+
+void Writer::serialiseBlock(int numSamples,
+                            const juce::AudioPlayHead::PositionInfo& position,
+                            const juce::MidiBuffer& midi) noexcept {
+  ByteWriter out(scratch_.data(), scratch_.size());
+  bool ok = out.put(static_cast<int32_t>(numSamples)) &&
+            writePosition(out, position);
+
+  // Parameter changes since the previous block. The count is patched in once
+  // the changes have been written. After a dropped block every parameter is
+  // written, since the changes it carried never reached the trace.
+  uint16_t numChanges = 0;
+  auto* numChangesSlot = out.reserve(sizeof(numChanges));
+  ok = ok && numChangesSlot != nullptr;
+  for (int i = 0; ok && i < parameters_.size(); ++i) {
+    const auto index = static_cast<size_t>(i);
+    const float value = parameters_.getUnchecked(i)->getValue();
+    if (!resyncParameters_ && juce::exactlyEqual(value, lastValues_[index]))
+      continue;
+    lastValues_[index] = value;
+    ok = out.put(static_cast<uint16_t>(i)) && out.put(value);
+    ++numChanges;
+  }
+  if (ok)
+    std::memcpy(numChangesSlot, &numChanges, sizeof(numChanges));
+
+  uint16_t numEvents = 0;
+  auto* numEventsSlot = ok ? out.reserve(sizeof(numEvents)) : nullptr;
+  ok = ok && numEventsSlot != nullptr;
+  for (const auto metadata : midi) {
+    if (!ok)
+      break;
+    ok = metadata.numBytes <= 0xffff &&
+         out.put(static_cast<int32_t>(metadata.samplePosition)) &&
+         out.put(static_cast<uint16_t>(metadata.numBytes)) &&
+         out.putBytes(metadata.data, static_cast<size_t>(metadata.numBytes));
+    ++numEvents;
+  }
+  if (ok)
+    std::memcpy(numEventsSlot, &numEvents, sizeof(numEvents));
+
+  const int numBytes = static_cast<int>(out.size());
+  if (!ok || fifo_.getFreeSpace() < numBytes) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    resyncParameters_ = true;
+    return;
+  }
+  writeToRing(fifo_, ring_.data(), scratch_.data(), numBytes);
+  resyncParameters_ = false;
+}
+
+void Writer::drain() {
+  int start1, size1, start2, size2;
+  fifo_.prepareToRead(fifo_.getNumReady(), start1, size1, start2, size2);
+  if (size1 > 0)
+    file_->write(ring_.data() + start1, static_cast<size_t>(size1));
+  if (size2 > 0)
+    file_->write(ring_.data() + start2, static_cast<size_t>(size2));
+  fifo_.finishedRead(size1 + size2);
+}
+
+void Writer::run() {
+  while (!threadShouldExit()) {
+    drain();
+    wait(20);
+  }
+}
+
+//==============================================================================
+Reader::Reader(const juce::File& file) {
+  if (!file.loadFileAsData(data_))
+    return;
+
+  char magic[4] = {};
+  uint32_t version = 0;
+  int32_t numParameters = 0;
+  if (!read(magic) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+      !read(version) || version != kVersion || !read(sampleRate_) ||
+      !read(numParameters) || numParameters < 0)
+    return;
+
+  for (int32_t i = 0; i < numParameters; ++i) {
+    uint16_t length = 0;
+    if (!read(length) || offset_ + length > data_.getSize())
+      return;
+    parameterIds_.add(juce::String::fromUTF8(
+        static_cast<const char*>(data_.getData()) + offset_, length));
+    offset_ += length;
+    float value = 0.0f;
+    if (!read(value))
+      return;
+    initialValues_.push_back(value);
+  }
+
+  firstBlockOffset_ = offset_;
+  valid_ = true;
+}
+
+template <typename T>
+bool Reader::read(T& value) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  if (offset_ + sizeof(T) > data_.getSize())
+    return false;
+  std::memcpy(&value, static_cast<const uint8_t*>(data_.getData()) + offset_,
+              sizeof(T));
+  offset_ += sizeof(T);
+  return true;
+}
+
+bool Reader::readNextBlock(Block& block) {
+  if (!valid_)
+    return false;
+
+  int32_t numSamples = 0;
+  uint8_t flags = 0;
+  if (!read(numSamples) || !read(flags))
+    return false;
+  block.numSamples = numSamples;
+
+  juce::AudioPlayHead::PositionInfo position;
+  if ((flags & kHasPpq) != 0) {
+    double ppq = 0.0;
+    if (!read(ppq))
+      return false;
+    position.setPpqPosition(ppq);
+  }
+  if ((flags & kHasBpm) != 0) {
+    double bpm = 0.0;
+    if (!read(bpm))
+      return false;
+    position.setBpm(bpm);
+  }
+  if ((flags & kHasTimeSignature) != 0) {
+    int32_t numerator = 0;
+    int32_t denominator = 0;
+    if (!read(numerator) || !read(denominator))
+      return false;
+    position.setTimeSignature(
+        juce::AudioPlayHead::TimeSignature{numerator, denominator});
+  }
+  if ((flags & kHasTimeInSamples) != 0) {
+    int64_t time = 0;
+    if (!read(time))
+      return false;
+    position.setTimeInSamples(time);
+  }
+  if ((flags & kHasBarStart) != 0) {
+    double barStart = 0.0;
+    if (!read(barStart))
+      return false;
+    position.setPpqPositionOfLastBarStart(barStart);
+  }
+  position.setIsPlaying((flags & kIsPlaying) != 0);
+  position.setIsRecording((flags & kIsRecording) != 0);
+  position.setIsLooping((flags & kIsLooping) != 0);
+  block.position = position;
+
+  uint16_t numChanges = 0;
+  if (!read(numChanges))
+    return false;
+  block.parameterChanges.clear();
+  for (uint16_t i = 0; i < numChanges; ++i) {
+    ParameterChange change;
+    if (!read(change.index) || !read(change.value))
+      return false;
+    block.parameterChanges.push_back(change);
+  }
+
+  uint16_t numEvents = 0;
+  if (!read(numEvents))
+    return false;
+  block.midi.clear();
+  for (uint16_t i = 0; i < numEvents; ++i) {
+    int32_t sampleOffset = 0;
+    uint16_t numBytes = 0;
+    if (!read(sampleOffset) || !read(numBytes) ||
+        offset_ + numBytes > data_.getSize())
+      return false;
+    block.midi.addEvent(static_cast<const uint8_t*>(data_.getData()) + offset_,
+                        numBytes, sampleOffset);
+    offset_ += numBytes;
+  }
+  return true;
+}
+
+//==============================================================================
+namespace {
+class ReplayPlayHead : public juce::AudioPlayHead {
+public:
+  juce::Optional<PositionInfo> getPosition() const override {
+    return position;
+  }
+
+  PositionInfo position;
+};
+}  // namespace
+
+ReplayResult replay(Reader& reader, juce::AudioProcessor& processor) {
+  ReplayResult result;
+  if (!reader.isValid())
+    return result;
+
+  // Map the trace's parameters onto the processor's by ID.
+  std::vector<juce::AudioProcessorParameter*> parameters;
+  const auto& ids = reader.getParameterIds();
+  for (const auto& id : ids) {
+    juce::AudioProcessorParameter* match = nullptr;
+    for (auto* parameter : processor.getParameters()) {
+      auto* hosted =
+          dynamic_cast<juce::HostedAudioProcessorParameter*>(parameter);
+      if (hosted != nullptr && hosted->getParameterID() == id)
+        match = parameter;
+    }
+    parameters.push_back(match);
+  }
+  const auto& initialValues = reader.getInitialValues();
+  for (size_t i = 0; i < parameters.size(); ++i)
+    if (parameters[i] != nullptr)
+      parameters[i]->setValueNotifyingHost(initialValues[i]);
+
+  Block block;
+  int maxBlockSize = 1;
+  reader.rewind();
+  while (reader.readNextBlock(block))
+    maxBlockSize = std::max(maxBlockSize, block.numSamples);
+  reader.rewind();
+
+  const int numChannels =
+      std::max(processor.getTotalNumInputChannels(),
+               processor.getTotalNumOutputChannels());
+  processor.setRateAndBufferSizeDetails(reader.getSampleRate(), maxBlockSize);
+  processor.prepareToPlay(reader.getSampleRate(), maxBlockSize);
+
+  ReplayPlayHead playHead;
+  auto* previousPlayHead = processor.getPlayHead();
+  processor.setPlayHead(&playHead);
+  juce::AudioBuffer<float> buffer(numChannels, maxBlockSize);
+
+  while (reader.readNextBlock(block)) {
+    for (const auto& change : block.parameterChanges)
+      if (change.index < parameters.size() &&
+          parameters[change.index] != nullptr)
+        parameters[change.index]->setValueNotifyingHost(change.value);
+    playHead.position = block.position;
+    buffer.setSize(numChannels, block.numSamples, false, false, true);
+    buffer.clear();
+
+    const auto start = juce::Time::getHighResolutionTicks();
+    processor.processBlock(buffer, block.midi);
+    const auto seconds = juce::Time::highResolutionTicksToSeconds(
+        juce::Time::getHighResolutionTicks() - start);
+
+    result.blockSeconds.push_back(seconds);
+    result.renderSeconds += seconds;
+    result.numSamples += block.numSamples;
+    ++result.numBlocks;
+  }
+
+  processor.setPlayHead(previousPlayHead);
+  processor.releaseResources();
+  return result;
+}
+
+}  // namespace SessionTrace
@@ -0,0 +1,618 @@
+#include "Pointilsynth/SimdKernels.h"
+
+#include "Pointilsynth/FastMath.h"
+
+#include <atomic>
+
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define POINTILSYNTH_SIMD_X86 1
+#include <immintrin.h>
+#define POINTILSYNTH_TARGET(isa) __attribute__((target(isa)))
+#else
+#define POINTILSYNTH_SIMD_X86 0
+#endif
+
+namespace SimdKernels {
+namespace {
+
+// Coefficients of the sine polynomial in Pointilsynth::fastSin2Pi(). The
+// vector variants evaluate it in the same Horner order.
+constexpr float kTwoPi = 6.28318530717958647692f;
+constexpr float kSin3 = -1.6666667e-1f;
+constexpr float kSin5 = 8.3333333e-3f;
+constexpr float kSin7 = -1.9841270e-4f;
+constexpr float kSin9 = 2.7557319e-6f;
+
+//==============================================================================
+// Scalar reference
+
+float dotScalar(const float* a, const float* b, int numSamples) {
+  float sum = 0.0f;
+  for (int i = 0; i < numSamples; ++i)
+    sum += a[i] * b[i];
+  return sum;
+}
+
+void sineScalar(float* dest, float phase, float increment, int numSamples) {
+  for (int i = 0; i < numSamples; ++i) {
+    float p = phase + increment * static_cast<float>(i);
+    p -= static_cast<float>(static_cast<int>(p));
+    dest[i] = Pointilsynth::fastSin2Pi(p);
+  }
+}
+
+void hannScalar(float* dest, float phase, float increment, int numSamples) {
+  for (int i = 0; i < numSamples; ++i) {
+    const float p = phase + increment * static_cast<float>(i);
+    dest[i] = 0.5f * (1.0f - Pointilsynth::fastCos2Pi(p));
+  }
+}
+
+void rampScalar(float* dest, float start, float increment, int numSamples) {
+  for (int i = 0; i < numSamples; ++i)
+    dest[i] = start + increment * static_cast<float>(i);
+}
+
+void mixMonoScalar(float* out,
+                   const float* source,
+                   const float* envelope,
+                   float gain,
+                   int numSamples) {
+  for (int i = 0; i < numSamples; ++i)
+    out[i] += source[i] * envelope[i] * gain;
+}
+
+void mixStereoScalar(float* left,
+                     float* right,
+                     const float* source,
+                     const float* envelope,
+                     float gainLeft,
+                     float gainRight,
+                     int numSamples) {
+  for (int i = 0; i < numSamples; ++i) {
+    const float sample = source[i] * envelope[i];
+    left[i] += sample * gainLeft;
+    right[i] += sample * gainRight;
+  }
+}
+
+constexpr KernelSet kScalar{Isa::Scalar,  "scalar",      &dotScalar,
+                            &sineScalar,  &hannScalar,   &rampScalar,
+                            &mixMonoScalar, &mixStereoScalar};
+
+#if POINTILSYNTH_SIMD_X86
+//==============================================================================
+// SSE2, 4 lanes
+
+POINTILSYNTH_TARGET("sse2")
+inline __m128 select(__m128 mask, __m128 ifTrue, __m128 ifFalse) {
+  return _mm_or_ps(_mm_and_ps(mask, ifTrue), _mm_andnot_ps(mask, ifFalse));
+}
+
+POINTILSYNTH_TARGET("sse2") inline __m128 fractionalPart(__m128 phase) {
+  return _mm_sub_ps(phase, _mm_cvtepi32_ps(_mm_cvttps_epi32(phase)));
+}
+
+POINTILSYNTH_TARGET("sse2") inline __m128 sin2Pi(__m128 phase) {
+  const __m128 signMask = _mm_set1_ps(-0.0f);
+  __m128 t = _mm_sub_ps(phase, _mm_set1_ps(0.5f));
+  const __m128 folded =
+      _mm_sub_ps(_mm_or_ps(_mm_set1_ps(0.5f), _mm_and_ps(t, signMask)), t);
+  t = select(_mm_cmpgt_ps(_mm_andnot_ps(signMask, t), _mm_set1_ps(0.25f)),
+             folded, t);
+  const __m128 x = _mm_mul_ps(t, _mm_set1_ps(kTwoPi));
+  const __m128 x2 = _mm_mul_ps(x, x);
+  __m128 poly = _mm_set1_ps(kSin9);
+  poly = _mm_add_ps(_mm_mul_ps(poly, x2), _mm_set1_ps(kSin7));
+  poly = _mm_add_ps(_mm_mul_ps(poly, x2), _mm_set1_ps(kSin5));
+  poly = _mm_add_ps(_mm_mul_ps(poly, x2), _mm_set1_ps(kSin3));
+  poly = _mm_add_ps(_mm_mul_ps(poly, x2), _mm_set1_ps(1.0f));
+  return _mm_xor_ps(_mm_mul_ps(poly, x), signMask);
+}
+
+POINTILSYNTH_TARGET("sse2")
+float dotSse2(const float* a, const float* b, int numSamples) {
+  __m128 sum0 = _mm_setzero_ps();
+  __m128 sum1 = _mm_setzero_ps();
+  int i = 0;
+  for (; i + 8 <= numSamples; i += 8) {
+    sum0 = _mm_add_ps(sum0,
+                      _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    sum1 = _mm_add_ps(
+        sum1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+  }
+  for (; i + 4 <= numSamples; i += 4)
+    sum0 = _mm_add_ps(sum0,
+                      _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+  __m128 sum = _mm_add_ps(sum0, sum1);
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+  float result = _mm_cvtss_f32(sum);
+  for (; i < numSamples; ++i)
+    result += a[i] * b[i];
+  return result;
+}
+
+POINTILSYNTH_TARGET("sse2")
+void sineSse2(float* dest, float phase, float increment, int numSamples) {
+  const __m128 start = _mm_set1_ps(phase);
+  const __m128 step = _mm_set1_ps(increment);
+  __m128 index = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+  int i = 0;
+  for (; i + 4 <= numSamples; i += 4) {
+    const __m128 p = _mm_add_ps(start, _mm_mul_ps(step, index));
+    _mm_storeu_ps(dest + i, sin2Pi(fractionalPart(p)));
+    index = _mm_add_ps(index, _mm_set1_ps(4.0f));
+  }
+  sineScalar(dest + i, phase + increment * static_cast<float>(i), increment,
+             numSamples - i);
+}
+
+POINTILSYNTH_TARGET("sse2")
+void hannSse2(float* dest, float phase, float increment, int numSamples) {
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 half = _mm_set1_ps(0.5f);
+  // cos(2 * pi * p) == sin(2 * pi * (p + 0.25)), wrapped back into [0, 1).
+  const __m128 start = _mm_set1_ps(phase + 0.25f);
+  const __m128 step = _mm_set1_ps(increment);
+  __m128 index = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+  int i = 0;
+  for (; i + 4 <= numSamples; i += 4) {
+    __m128 p = _mm_add_ps(start, _mm_mul_ps(step, index));
+    p = _mm_sub_ps(p, _mm_and_ps(_mm_cmpge_ps(p, one), one));
+    _mm_storeu_ps(dest + i, _mm_mul_ps(half, _mm_sub_ps(one, sin2Pi(p))));
+    index = _mm_add_ps(index, _mm_set1_ps(4.0f));
+  }
+  hannScalar(dest + i, phase + increment * static_cast<float>(i), increment,
+             numSamples - i);
+}
+
+POINTILSYNTH_TARGET("sse2")
+void rampSse2(float* dest, float start, float increment, int numSamples) {
+  const __m128 base = _mm_set1_ps(start);
+  const __m128 step = _mm_set1_ps(increment);
+  __m128 index = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+  int i = 0;
+  for (; i + 4 <= numSamples; i += 4) {
+    _mm_storeu_ps(dest + i, _mm_add_ps(base, _mm_mul_ps(step, index)));
+    index = _mm_add_ps(index, _mm_set1_ps(4.0f));
+  }
+  for (; i < numSamples; ++i)
+    dest[i] = start + increment * static_cast<float>(i);
+}
+
+POINTILSYNTH_TARGET("sse2")
+void mixMonoSse2(float* out,
+                 const float* source,
+                 const float* envelope,
+                 float gain,
+                 int numSamples) {
+  const __m128 g = _mm_set1_ps(gain);
+  int i = 0;
+  for (; i + 4 <= numSamples; i += 4) {
+    const __m128 sample =
+        _mm_mul_ps(_mm_loadu_ps(source + i), _mm_loadu_ps(envelope + i));
+    _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i),
+                                      _mm_mul_ps(sample, g)));
+  }
+  mixMonoScalar(out + i, source + i, envelope + i, gain, numSamples - i);
+}
+
+POINTILSYNTH_TARGET("sse2")
+void mixStereoSse2(float* left,
+                   float* right,
+                   const float* source,
+                   const float* envelope,
+                   float gainLeft,
+                   float gainRight,
+                   int numSamples) {
+  const __m128 gl = _mm_set1_ps(gainLeft);
+  const __m128 gr = _mm_set1_ps(gainRight);
+  int i = 0;
+  for (; i + 4 <= numSamples; i += 4) {
+    const __m128 sample =
+        _mm_mul_ps(_mm_loadu_ps(source + i), _mm_loadu_ps(envelope + i));
+    _mm_storeu_ps(left + i, _mm_add_ps(_mm_loadu_ps(left + i),
+                                       _mm_mul_ps(sample, gl)));
+    _mm_storeu_ps(right + i, _mm_add_ps(_mm_loadu_ps(right + i),
+                                        _mm_mul_ps(sample, gr)));
+  }
+  mixStereoScalar(left + i, right + i, source + i, envelope + i, gainLeft,
+                  gainRight, numSamples - i);
+}
+
+constexpr KernelSet kSse2{Isa::SSE2,   "sse2",       &dotSse2,
+                          &sineSse2,   &hannSse2,    &rampSse2,
+                          &mixMonoSse2, &mixStereoSse2};
+
+//==============================================================================
+// AVX2 + FMA, 8 lanes
+
+POINTILSYNTH_TARGET("avx2,fma") inline __m256 fractionalPart(__m256 phase) {
+  return _mm256_sub_ps(
+      phase, _mm256_round_ps(phase, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC));
+}
+
+POINTILSYNTH_TARGET("avx2,fma") inline __m256 sin2Pi(__m256 phase) {
+  const __m256 signMask = _mm256_set1_ps(-0.0f);
+  __m256 t = _mm256_sub_ps(phase, _mm256_set1_ps(0.5f));
+  const __m256 folded = _mm256_sub_ps(
+      _mm256_or_ps(_mm256_set1_ps(0.5f), _mm256_and_ps(t, signMask)), t);
+  const __m256 fold = _mm256_cmp_ps(_mm256_andnot_ps(signMask, t),
+                                    _mm256_set1_ps(0.25f), _CMP_GT_OQ);
+  t = _mm256_blendv_ps(t, folded, fold);
+  const __m256 x = _mm256_mul_ps(t, _mm256_set1_ps(kTwoPi));
+  const __m256 x2 = _mm256_mul_ps(x, x);
+  __m256 poly = _mm256_set1_ps(kSin9);
+  poly = _mm256_fmadd_ps(poly, x2, _mm256_set1_ps(kSin7));
+  poly = _mm256_fmadd_ps(poly, x2, _mm256_set1_ps(kSin5));
+  poly = _mm256_fmadd_ps(poly, x2, _mm256_set1_ps(kSin3));
+  poly = _mm256_fmadd_ps(poly, x2, _mm256_set1_ps(1.0f));
+  return _mm256_xor_ps(_mm256_mul_ps(poly, x), signMask);
+}
+
+POINTILSYNTH_TARGET("avx2,fma")
+float dotAvx2(const float* a, const float* b, int numSamples) {
+  __m256 sum0 = _mm256_setzero_ps();
+  __m256 sum1 = _mm256_setzero_ps();
+  int i = 0;
+  for (; i + 16 <= numSamples; i += 16) {
+    sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i),
+                           sum0);
+    sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8),
+                           _mm256_loadu_ps(b + i + 8), sum1);
+  }
+  for (; i + 8 <= numSamples; i += 8)
+    sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i),
+                           sum0);
+  const __m256 sum8 = _mm256_add_ps(sum0, sum1);
+  __m128 sum = _mm_add_ps(_mm256_castps256_ps128(sum8),
+                          _mm256_extractf128_ps(sum8, 1));
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+  float result = _mm_cvtss_f32(sum);
+  for (; i < numSamples; ++i)
+    result += a[i] * b[i];
+  return result;
+}
+
+POINTILSYNTH_TARGET("avx2,fma")
+void sineAvx2(float* dest, float phase, float increment, int numSamples) {
+  const __m256 start = _mm256_set1_ps(phase);
+  const __m256 step = _mm256_set1_ps(increment);
+  __m256 index = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+  int i = 0;
+  for (; i + 8 <= numSamples; i += 8) {
+    const __m256 p = _mm256_add_ps(start, _mm256_mul_ps(step, index));
+    _mm256_storeu_ps(dest + i, sin2Pi(fractionalPart(p)));
+    index = _mm256_add_ps(index, _mm256_set1_ps(8.0f));
+  }
+  sineScalar(dest + i, phase + increment * static_cast<float>(i), increment,
+             numSamples - i);
+}
+
+POINTILSYNTH_TARGET("avx2,fma")
+void hannAvx2(float* dest, float phase, float increment, int numSamples) {
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 half = _mm256_set1_ps(0.5f);
+  const __m256 start = _mm256_set1_ps(phase + 0.25f);
+  const __m256 step = _mm256_set1_ps(increment);
+  __m256 index = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+  int i = 0;
+  for (; i + 8 <= numSamples; i += 8) {
+    __m256 p = _mm256_add_ps(start, _mm256_mul_ps(step, index));
+    p = _mm256_sub_ps(p, _mm256_and_ps(_mm256_cmp_ps(p, one, _CMP_GE_OQ), one));
+    _mm256_storeu_ps(dest + i, _mm256_fnmadd_ps(half, sin2Pi(p), half));
+    index = _mm256_add_ps(index, _mm256_set1_ps(8.0f));
+  }
+  hannScalar(dest + i, phase + increment * static_cast<float>(i), increment,
+             numSamples - i);
+}
+
+POINTILSYNTH_TARGET("avx2,fma")
+void rampAvx2(float* dest, float start, float increment, int numSamples) {
+  const __m256 base = _mm256_set1_ps(start);
+  const __m256 step = _mm256_set1_ps(increment);
+  __m256 index = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+  int i = 0;
+  for (; i + 8 <= numSamples; i += 8) {
+    _mm256_storeu_ps(dest + i, _mm256_add_ps(base, _mm256_mul_ps(step, index)));
+    index = _mm256_add_ps(index, _mm256_set1_ps(8.0f));
+  }
+  for (; i < numSamples; ++i)
+    dest[i] = start + increment * static_cast<float>(i);
+}
+
+POINTILSYNTH_TARGET("avx2,fma")
+void mixMonoAvx2(float* out,
+                 const float* source,
+                 const float* envelope,
+                 float gain,
+                 int numSamples) {
+  const __m256 g = _mm256_set1_ps(gain);
+  int i = 0;
+  for (; i + 8 <= numSamples; i += 8) {
+    const __m256 sample = _mm256_mul_ps(_mm256_loadu_ps(source + i),
+                                        _mm256_loadu_ps(envelope + i));
+    _mm256_storeu_ps(out + i,
+                     _mm256_fmadd_ps(sample, g, _mm256_loadu_ps(out + i)));
+  }
+  mixMonoScalar(out + i, source + i, envelope + i, gain, numSamples - i);
+}
+
+POINTILSYNTH_TARGET("avx2,fma")
+void mixStereoAvx2(float* left,
+                   float* right,
+                   const float* source,
+                   const float* envelope,
+                   float gainLeft,
+                   float gainRight,
+                   int numSamples) {
+  const __m256 gl = _mm256_set1_ps(gainLeft);
+  const __m256 gr = _mm256_set1_ps(gainRight);
+  int i = 0;
+  for (; i + 8 <= numSamples; i += 8) {
+    const __m256 sample = _mm256_mul_ps(_mm256_loadu_ps(source + i),
+                                        _mm256_loadu_ps(envelope + i));
+    _mm256_storeu_ps(left + i,
+                     _mm256_fmadd_ps(sample, gl, _mm256_loadu_ps(left + i)));
+    _mm256_storeu_ps(right + i,
+                     _mm256_fmadd_ps(sample, gr, _mm256_loadu_ps(right + i)));
+  }
+  mixStereoScalar(left + i, right + i, source + i, envelope + i, gainLeft,
+                  gainRight, numSamples - i);
+}
+
+constexpr KernelSet kAvx2{Isa::AVX2,   "avx2",       &dotAvx2,
+                          &sineAvx2,   &hannAvx2,    &rampAvx2,
+                          &mixMonoAvx2, &mixStereoAvx2};
+
+//==============================================================================
+// AVX-512F, 16 lanes. Tails use masked loads and stores.
+
+// GCC 12's avx512fintrin.h seeds several intrinsics with a deliberately
+// uninitialised vector, which trips -Wuninitialized once they are inlined.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+constexpr __mmask16 kAllLanes = 0xFFFF;
+
+POINTILSYNTH_TARGET("avx512f") inline __mmask16 tailMask(int remaining) {
+  return static_cast<__mmask16>((1u << remaining) - 1u);
+}
+
+POINTILSYNTH_TARGET("avx512f") inline __m512 fractionalPart(__m512 phase) {
+  return _mm512_sub_ps(
+      phase,
+      _mm512_roundscale_ps(phase, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC));
+}
+
+POINTILSYNTH_TARGET("avx512f") inline __m512 sin2Pi(__m512 phase) {
+  const __m512i signBit = _mm512_set1_epi32(static_cast<int>(0x80000000u));
+  __m512 t = _mm512_sub_ps(phase, _mm512_set1_ps(0.5f));
+  const __mmask16 negative =
+      _mm512_cmp_ps_mask(t, _mm512_setzero_ps(), _CMP_LT_OQ);
+  const __m512 halfWithSign = _mm512_mask_blend_ps(
+      negative, _mm512_set1_ps(0.5f), _mm512_set1_ps(-0.5f));
+  const __mmask16 fold =
+      _mm512_cmp_ps_mask(_mm512_abs_ps(t), _mm512_set1_ps(0.25f), _CMP_GT_OQ);
+  t = _mm512_mask_blend_ps(fold, t, _mm512_sub_ps(halfWithSign, t));
+  const __m512 x = _mm512_mul_ps(t, _mm512_set1_ps(kTwoPi));
+  const __m512 x2 = _mm512_mul_ps(x, x);
+  __m512 poly = _mm512_set1_ps(kSin9);
+  poly = _mm512_fmadd_ps(poly, x2, _mm512_set1_ps(kSin7));
+  poly = _mm512_fmadd_ps(poly, x2, _mm512_set1_ps(kSin5));
+  poly = _mm512_fmadd_ps(poly, x2, _mm512_set1_ps(kSin3));
+  poly = _mm512_fmadd_ps(poly, x2, _mm512_set1_ps(1.0f));
+  return _mm512_castsi512_ps(
+      _mm512_xor_si512(_mm512_castps_si512(_mm512_mul_ps(poly, x)), signBit));
+}
+
+POINTILSYNTH_TARGET("avx512f") inline __m512 laneIndices() {
+  return _mm512_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f,
+                        9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f);
+}
+
+POINTILSYNTH_TARGET("avx512f")
+float dotAvx512(const float* a, const float* b, int numSamples) {
+  __m512 sum = _mm512_setzero_ps();
+  int i = 0;
+  for (; i + 16 <= numSamples; i += 16)
+    sum = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), sum);
+  if (i < numSamples) {
+    const __mmask16 mask = tailMask(numSamples - i);
+    sum = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a + i),
+                          _mm512_maskz_loadu_ps(mask, b + i), sum);
+  }
+  // Fold 512 -> 128 bits with lane shuffles, then finish as in SSE2.
+  sum = _mm512_add_ps(
+      sum, _mm512_mask_shuffle_f32x4(sum, kAllLanes, sum, sum, 0x4E));
+  sum = _mm512_add_ps(
+      sum, _mm512_mask_shuffle_f32x4(sum, kAllLanes, sum, sum, 0xB1));
+  __m128 sum4 = _mm512_castps512_ps128(sum);
+  sum4 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+  sum4 = _mm_add_ss(sum4, _mm_shuffle_ps(sum4, sum4, 1));
+  return _mm_cvtss_f32(sum4);
+}
+
+POINTILSYNTH_TARGET("avx512f")
+void sineAvx512(float* dest, float phase, float increment, int numSamples) {
+  const __m512 start = _mm512_set1_ps(phase);
+  const __m512 step = _mm512_set1_ps(increment);
+  __m512 index = laneIndices();
+  for (int i = 0; i < numSamples; i += 16) {
+    const __m512 p = _mm512_add_ps(start, _mm512_mul_ps(step, index));
+    const __m512 value = sin2Pi(fractionalPart(p));
+    if (i + 16 <= numSamples)
+      _mm512_storeu_ps(dest + i, value);
+    else
+      _mm512_mask_storeu_ps(dest + i, tailMask(numSamples - i), value);
+    index = _mm512_add_ps(index, _mm512_set1_ps(16.0f));
+  }
+}
+
+POINTILSYNTH_TARGET("avx512f")
+void hannAvx512(float* dest, float phase, float increment, int numSamples) {
+  const __m512 one = _mm512_set1_ps(1.0f);
+  const __m512 half = _mm512_set1_ps(0.5f);
+  const __m512 start = _mm512_set1_ps(phase + 0.25f);
+  const __m512 step = _mm512_set1_ps(increment);
+  __m512 index = laneIndices();
+  for (int i = 0; i < numSamples; i += 16) {
+    __m512 p = _mm512_add_ps(start, _mm512_mul_ps(step, index));
+    p = _mm512_mask_sub_ps(p, _mm512_cmp_ps_mask(p, one, _CMP_GE_OQ), p, one);
+    const __m512 value = _mm512_fnmadd_ps(half, sin2Pi(p), half);
+    if (i + 16 <= numSamples)
+      _mm512_storeu_ps(dest + i, value);
+    else
+      _mm512_mask_storeu_ps(dest + i, tailMask(numSamples - i), value);
+    index = _mm512_add_ps(index, _mm512_set1_ps(16.0f));
+  }
+}
+
+POINTILSYNTH_TARGET("avx512f")
+void rampAvx512(float* dest, float start, float increment, int numSamples) {
+  const __m512 base = _mm512_set1_ps(start);
+  const __m512 step = _mm512_set1_ps(increment);
+  __m512 index = laneIndices();
+  for (int i = 0; i < numSamples; i += 16) {
+    const __m512 value = _mm512_add_ps(base, _mm512_mul_ps(step, index));
+    if (i + 16 <= numSamples)
+      _mm512_storeu_ps(dest + i, value);
+    else
+      _mm512_mask_storeu_ps(dest + i, tailMask(numSamples - i), value);
+    index = _mm512_add_ps(index, _mm512_set1_ps(16.0f));
+  }
+}
+
+POINTILSYNTH_TARGET("avx512f")
+void mixMonoAvx512(float* out,
+                   const float* source,
+                   const float* envelope,
+                   float gain,
+                   int numSamples) {
+  const __m512 g = _mm512_set1_ps(gain);
+  for (int i = 0; i < numSamples; i += 16) {
+    const __mmask16 mask =
+        i + 16 <= numSamples ? kAllLanes : tailMask(numSamples - i);
+    const __m512 sample =
+        _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, source + i),
+                      _mm512_maskz_loadu_ps(mask, envelope + i));
+    _mm512_mask_storeu_ps(
+        out + i, mask,
+        _mm512_fmadd_ps(sample, g, _mm512_maskz_loadu_ps(mask, out + i)));
+  }
+}
+
+POINTILSYNTH_TARGET("avx512f")
+void mixStereoAvx512(float* left,
+                     float* right,
+                     const float* source,
+                     const float* envelope,
+                     float gainLeft,
+                     float gainRight,
+                     int numSamples) {
+  const __m512 gl = _mm512_set1_ps(gainLeft);
+  const __m512 gr = _mm512_set1_ps(gainRight);
+  for (int i = 0; i < numSamples; i += 16) {
+    const __mmask16 mask =
+        i + 16 <= numSamples ? kAllLanes : tailMask(numSamples - i);
+    const __m512 sample =
+        _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, source + i),
+                      _mm512_maskz_loadu_ps(mask, envelope + i));
+    _mm512_mask_storeu_ps(
+        left + i, mask,
+        _mm512_fmadd_ps(sample, gl, _mm512_maskz_loadu_ps(mask, left + i)));
+    _mm512_mask_storeu_ps(
+        right + i, mask,
+        _mm512_fmadd_ps(sample, gr, _mm512_maskz_loadu_ps(mask, right + i)));
+  }
+}
+
+constexpr KernelSet kAvx512{Isa::AVX512,   "avx512",       &dotAvx512,
+                            &sineAvx512,   &hannAvx512,    &rampAvx512,
+                            &mixMonoAvx512, &mixStereoAvx512};
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif  // POINTILSYNTH_SIMD_X86
+
+bool isSupported(Isa isa) {
+#if POINTILSYNTH_SIMD_X86
+  __builtin_cpu_init();
+  switch (isa) {
+    case Isa::Scalar:
+      return true;
+    case Isa::SSE2:
+      return __builtin_cpu_supports("sse2");
+    case Isa::AVX2:
+      return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case Isa::AVX512:
+      return __builtin_cpu_supports("avx512f");
+  }
+  return false;
+#else
+  return isa == Isa::Scalar;
+#endif
+}
+
+std::atomic<const KernelSet*>& activeKernelSet() {
+  static std::atomic<const KernelSet*> kernels{getKernelSet(detectIsa())};
+  return kernels;
+}
+
+}  // namespace
+
+Isa detectIsa() {
+  for (auto isa : {Isa::AVX512, Isa::AVX2, Isa::SSE2}) {
+    if (isSupported(isa))
+      return isa;
+  }
+  return Isa::Scalar;
+}
+
+const KernelSet* getKernelSet(Isa isa) {
+  if (!isSupported(isa))
+    return nullptr;
+  switch (isa) {
+#if POINTILSYNTH_SIMD_X86
+    case Isa::SSE2:
+      return &kSse2;
+    case Isa::AVX2:
+      return &kAvx2;
+    case Isa::AVX512:
+      return &kAvx512;
+#else
+    case Isa::SSE2:
+    case Isa::AVX2:
+    case Isa::AVX512:
+      return nullptr;
+#endif
+    case Isa::Scalar:
+      return &kScalar;
+  }
+  return nullptr;
+}
+
+const KernelSet& scalar() {
+  return kScalar;
+}
+
+const KernelSet& active() {
+  return *activeKernelSet().load(std::memory_order_acquire);
+}
+
+bool setActiveIsa(Isa isa) {
+  const auto* kernels = getKernelSet(isa);
+  if (kernels == nullptr)
+    return false;
+  activeKernelSet().store(kernels, std::memory_order_release);
+  return true;
+}
+
+}  // namespace SimdKernels
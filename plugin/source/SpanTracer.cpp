@@ -0,0 +1,266 @@
+#include "Pointilsynth/SpanTracer.h"
+
+#include <juce_events/juce_events.h>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <initializer_list>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr size_t kThreadNameSize = 64;
+// One slot more than the events a snapshot keeps, so the slot the writer is
+// filling is never one of them.
+constexpr auto kNumSlots =
+    static_cast<uint64_t>(SpanTracer::kEventsPerThread) + 1;
+
+struct Event {
+  const char* name = nullptr;
+  juce::int64 startTicks = 0;
+  juce::int64 endTicks = 0;
+  int arg = SpanTracer::kNoArg;
+};
+
+/**
+ * One thread's spans. Only the owning thread writes; readers copy the newest
+ * kEventsPerThread events and discard any the writer overwrote meanwhile.
+ * When its thread exits the ring is freed but keeps its spans until another
+ * thread claims it.
+ */
+struct ThreadRing {
+  std::atomic<bool> inUse{false};  // Owned by a running thread.
+  // 0 until the ring is first claimed. Odd while a new owner writes
+  // threadName, even once it is published, so readers can retry a name that
+  // changed under them.
+  std::atomic<uint32_t> nameVersion{0};
+  std::atomic<const char*> explicitName{nullptr};
+  std::array<std::atomic<char>, kThreadNameSize> threadName{};
+  // written only grows, so readers can tell a reused ring's earlier spans
+  // from its current owner's.
+  std::atomic<uint64_t> firstEvent{0};
+  std::atomic<uint64_t> written{0};
+  std::array<Event, kNumSlots> events{};
+};
+
+// Allocated by the first setEnabled(true) and never freed, since threads may
+// still hold a pointer to their ring.
+std::atomic<ThreadRing*> rings{nullptr};
+std::atomic<uint32_t> numDropped{0};
+std::mutex allocationMutex;
+
+/** Frees the thread's ring when the thread exits. */
+struct RingOwner {
+  ThreadRing* ring = nullptr;
+
+  ~RingOwner() {
+    if (ring != nullptr)
+      ring->inUse.store(false, std::memory_order_release);
+  }
+};
+
+thread_local ThreadRing* currentRing = nullptr;
+thread_local RingOwner ringOwner;
+
+/** Takes a free ring, preferring one that never held spans so that exited
+ * threads' spans stay in the trace as long as possible. */
+ThreadRing* claimFreeRing(ThreadRing* allRings) noexcept {
+  for (const bool reuse : {false, true}) {
+    for (int i = 0; i < SpanTracer::kMaxThreads; ++i) {
+      auto& ring = allRings[i];
+      if (!reuse && ring.nameVersion.load(std::memory_order_relaxed) != 0)
+        continue;
+      bool expected = false;
+      if (!ring.inUse.load(std::memory_order_relaxed) &&
+          ring.inUse.compare_exchange_strong(expected, true,
+                                             std::memory_order_acquire))
+        return &ring;
+    }
+  }
+  return nullptr;
+}
+
+/** Returns the calling thread's ring, claiming one on first use. */
+ThreadRing* getCurrentRing() noexcept {
+  if (currentRing != nullptr)
+    return currentRing;
+  auto* allRings = rings.load(std::memory_order_acquire);
+  if (allRings == nullptr)
+    return nullptr;
+  auto* claimedRing = claimFreeRing(allRings);
+  if (claimedRing == nullptr)
+    return nullptr;
+
+  char threadName[kThreadNameSize] = {};
+  auto* messageManager = juce::MessageManager::getInstanceWithoutCreating();
+  if (messageManager != nullptr && messageManager->isThisTheMessageThread())
+    std::strncpy(threadName, "Message thread", sizeof(threadName) - 1);
+  else if (auto* thread = juce::Thread::getCurrentThread())
+    thread->getThreadName().copyToUTF8(threadName, sizeof(threadName));
+
+  auto& ring = *claimedRing;
+  const uint32_t version = ring.nameVersion.load(std::memory_order_relaxed);
+  ring.nameVersion.store(version + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  ring.explicitName.store(nullptr, std::memory_order_relaxed);
+  for (size_t i = 0; i < sizeof(threadName); ++i)
+    ring.threadName[i].store(threadName[i], std::memory_order_relaxed);
+  ring.firstEvent.store(ring.written.load(std::memory_order_relaxed),
+                        std::memory_order_relaxed);
+  ring.nameVersion.store(version + 2, std::memory_order_release);
+  ringOwner.ring = &ring;
+  currentRing = &ring;
+  return currentRing;
+}
+
+/** Copies ring's automatic thread name into name. Returns false if the ring
+ * was never claimed or is being claimed right now. */
+bool readThreadName(const ThreadRing& ring, std::string& name) {
+  const uint32_t version = ring.nameVersion.load(std::memory_order_acquire);
+  if (version == 0 || version % 2 != 0)
+    return false;
+  name.clear();
+  for (const auto& c : ring.threadName) {
+    const char value = c.load(std::memory_order_relaxed);
+    if (value == '\0')
+      break;
+    name += value;
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return ring.nameVersion.load(std::memory_order_relaxed) == version;
+}
+
+/** Copies the events ring currently holds, oldest first. */
+std::vector<Event> snapshot(const ThreadRing& ring) {
+  constexpr auto kCapacity =
+      static_cast<uint64_t>(SpanTracer::kEventsPerThread);
+  const uint64_t end = ring.written.load(std::memory_order_acquire);
+  const uint64_t begin =
+      std::min(std::max(end > kCapacity ? end - kCapacity : 0,
+                        ring.firstEvent.load(std::memory_order_acquire)),
+               end);
+  std::vector<Event> events;
+  events.reserve(static_cast<size_t>(end - begin));
+  for (uint64_t i = begin; i < end; ++i)
+    events.push_back(ring.events[static_cast<size_t>(i % kNumSlots)]);
+
+  // Drop the events the writer may have overwritten while we copied, and any
+  // left by the ring's previous owner if it was reused meanwhile. The writer
+  // fills the slot for index `after` before publishing it, so that slot may
+  // be torn too.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  const uint64_t after = ring.written.load(std::memory_order_relaxed);
+  const uint64_t firstIntact =
+      std::max(after + 1 > kNumSlots ? after + 1 - kNumSlots : 0,
+               ring.firstEvent.load(std::memory_order_relaxed));
+  if (firstIntact > begin) {
+    const auto numOverwritten =
+        std::min(static_cast<size_t>(firstIntact - begin), events.size());
+    events.erase(events.begin(),
+                 events.begin() + static_cast<std::ptrdiff_t>(numOverwritten));
+  }
+  return events;
+}
+}  // namespace
+
+void SpanTracer::setEnabled(bool shouldBeEnabled) {
+  if (shouldBeEnabled) {
+    const std::lock_guard<std::mutex> lock(allocationMutex);
+    if (rings.load() == nullptr)
+      rings.store(new ThreadRing[kMaxThreads], std::memory_order_release);
+  }
+  enabled_.store(shouldBeEnabled);
+}
+
+void SpanTracer::record(const char* name,
+                        juce::int64 startTicks,
+                        juce::int64 endTicks,
+                        int arg) noexcept {
+  auto* ring = getCurrentRing();
+  if (ring == nullptr) {
+    numDropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  const uint64_t index = ring->written.load(std::memory_order_relaxed);
+  ring->events[static_cast<size_t>(index % kNumSlots)] = {
+      name, startTicks, endTicks, arg};
+  ring->written.store(index + 1, std::memory_order_release);
+}
+
+void SpanTracer::nameCurrentThread(const char* name) noexcept {
+  if (!isEnabled())
+    return;
+  if (auto* ring = getCurrentRing())
+    ring->explicitName.store(name, std::memory_order_relaxed);
+}
+
+uint32_t SpanTracer::getNumDropped() noexcept {
+  return numDropped.load();
+}
+
+std::string SpanTracer::toChromeTraceJson() {
+  auto traceEvents = nlohmann::json::array();
+  auto* allRings = rings.load(std::memory_order_acquire);
+  const int numRings = allRings == nullptr ? 0 : kMaxThreads;
+
+  std::vector<std::vector<Event>> events(static_cast<size_t>(numRings));
+  std::vector<std::string> threadNames(static_cast<size_t>(numRings));
+  std::vector<bool> isClaimed(static_cast<size_t>(numRings));
+  juce::int64 origin = std::numeric_limits<juce::int64>::max();
+  for (int i = 0; i < numRings; ++i) {
+    const auto index = static_cast<size_t>(i);
+    isClaimed[index] = readThreadName(allRings[i], threadNames[index]);
+    if (!isClaimed[index])
+      continue;
+    events[index] = snapshot(allRings[i]);
+    for (const auto& event : events[static_cast<size_t>(i)])
+      origin = std::min(origin, event.startTicks);
+  }
+
+  auto toMicroseconds = [](juce::int64 ticks) {
+    return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e6;
+  };
+  for (int tid = 0; tid < numRings; ++tid) {
+    const auto index = static_cast<size_t>(tid);
+    if (!isClaimed[index])
+      continue;
+    std::string threadName = "Thread " + std::to_string(tid);
+    if (auto* name =
+            allRings[tid].explicitName.load(std::memory_order_relaxed))
+      threadName = name;
+    else if (!threadNames[index].empty())
+      threadName = threadNames[index];
+    traceEvents.push_back({{"name", "thread_name"},
+                           {"ph", "M"},
+                           {"pid", 1},
+                           {"tid", tid},
+                           {"args", {{"name", threadName}}}});
+
+    for (const auto& event : events[index]) {
+      nlohmann::json span = {
+          {"name", event.name != nullptr ? event.name : "?"},
+          {"cat", "pointilsynth"},
+          {"ph", "X"},
+          {"pid", 1},
+          {"tid", tid},
+          {"ts", toMicroseconds(event.startTicks - origin)},
+          {"dur", toMicroseconds(event.endTicks - event.startTicks)}};
+      if (event.arg != kNoArg)
+        span["args"] = {{"value", event.arg}};
+      traceEvents.push_back(std::move(span));
+    }
+  }
+
+  return nlohmann::json({{"traceEvents", traceEvents},
+                         {"displayTimeUnit", "ms"},
+                         {"otherData", {{"droppedSpans", getNumDropped()}}}})
+      .dump();
+}
+
+bool SpanTracer::writeChromeTrace(const juce::File& file) {
+  return file.replaceWithText(toChromeTraceJson());
+}
@@ -1,35 +1,65 @@
 #include "Pointilsynth/PointilismInterfaces.h"  // Assuming this is the correct path relative to the cpp file
-#include "Pointilsynth/ConfigManager.h"
 #include <random>  // For distributions if needed directly in setters, though likely just for storage here
 #include <cmath>   // For std::abs, std::max etc. if needed
 #include <limits>  // For std::numeric_limits<double>::epsilon(), INT_MAX
 #include <algorithm>  // Will be needed for std::clamp in other methods
 
-StochasticModel::StochasticModel(std::shared_ptr<ConfigManager> cfg)
-    : config_(std::move(cfg)) {
-  if (config_) {
-    config_->addListener(ConfigManager::ParamID::pitch,
-                         [this](float v) { pitch = v; });
-    config_->addListener(ConfigManager::ParamID::dispersion,
-                         [this](float v) { dispersion = v; });
-    config_->addListener(ConfigManager::ParamID::avgDuration,
-                         [this](float v) { averageDurationMs_ = v; });
-    config_->addListener(ConfigManager::ParamID::durationVariation,
-                         [this](float v) { durationVariation_ = v; });
-    config_->addListener(ConfigManager::ParamID::pan,
-                         [this](float v) { centralPan = v; });
-    config_->addListener(ConfigManager::ParamID::panSpread,
-                         [this](float v) { panSpread = v; });
-    config_->addListener(ConfigManager::ParamID::density,
-                         [this](float v) { globalDensity_ = v; });
-    config_->addListener(
-        ConfigManager::ParamID::temporalDistribution, [this](float v) {
-          globalTemporalDistribution_ =
-              static_cast<TemporalDistribution>(static_cast<int>(v));
-        });
+StochasticModel::StochasticModel(ParameterHandles handles)
+    : handles_(handles) {
+  if (handles_.isBound()) {
+    lastPolled_.pitch = handles_.pitch->load();
+    lastPolled_.dispersion = handles_.dispersion->load();
+    lastPolled_.avgDuration = handles_.avgDuration->load();
+    lastPolled_.durationVariation = handles_.durationVariation->load();
+    lastPolled_.pan = handles_.pan->load();
+    lastPolled_.panSpread = handles_.panSpread->load();
+    lastPolled_.density = handles_.density->load();
+    lastPolled_.temporalDistribution = handles_.temporalDistribution->load();
   }
 }
 
+void StochasticModel::pollParameters() {
+  if (handles_.isBound())
+    pollParameterHandles();
+
+  // Retarget the ramps once per block. Values that arrive through the direct
+  // setters are picked up here too.
+  densitySmoother_.setTargetValue(
+      globalDensity_.load(std::memory_order_relaxed));
+  pitchSmoother_.setTargetValue(pitch.load(std::memory_order_relaxed));
+  panSmoother_.setTargetValue(centralPan.load(std::memory_order_relaxed));
+}
+
+void StochasticModel::pollParameterHandles() {
+  float value = 0.0f;
+  auto changed = [&value](const std::atomic<float>* handle, float& lastSeen) {
+    value = handle->load(std::memory_order_relaxed);
+    if (juce::exactlyEqual(value, lastSeen))
+      return false;
+    lastSeen = value;
+    return true;
+  };
+
+  if (changed(handles_.pitch, lastPolled_.pitch))
+    pitch.store(value, std::memory_order_relaxed);
+  if (changed(handles_.dispersion, lastPolled_.dispersion))
+    dispersion.store(value, std::memory_order_relaxed);
+  if (changed(handles_.avgDuration, lastPolled_.avgDuration))
+    averageDurationMs_.store(value, std::memory_order_relaxed);
+  if (changed(handles_.durationVariation, lastPolled_.durationVariation))
+    durationVariation_.store(value, std::memory_order_relaxed);
+  if (changed(handles_.pan, lastPolled_.pan))
+    centralPan.store(value, std::memory_order_relaxed);
+  if (changed(handles_.panSpread, lastPolled_.panSpread))
+    panSpread.store(value, std::memory_order_relaxed);
+  if (changed(handles_.density, lastPolled_.density))
+    globalDensity_.store(value, std::memory_order_relaxed);
+  if (changed(handles_.temporalDistribution, lastPolled_.temporalDistribution))
+    globalTemporalDistribution_.store(
+        static_cast<TemporalDistribution>(static_cast<int>(value)),
+        std::memory_order_relaxed);
+}
+
 // Forward declaration or ensure StochasticModel is fully defined via header
 // class StochasticModel; // Not needed if PointilismInterfaces.h includes full
 // definition
@@ -40,13 +70,52 @@ void StochasticModel::setDurationAndVariation(float averageDurationMs,
   durationVariation_ = variation;
 }
 
+void StochasticModel::setRandomSeed(uint32_t seed) {
+  randomEngine.seed(seed);
+  // normal_distribution caches its second variate; drop it with the old seed.
+  poissonDistribution_.reset();
+  uniformRealDistribution_.reset();
+  pitchDistribution.reset();
+  panDistribution.reset();
+  durationDistribution.reset();
+}
+
 void StochasticModel::setSampleRate(double newSampleRate) {
   sampleRate_ = newSampleRate;
+  densitySmoother_.reset(newSampleRate, kParameterRampSeconds);
+  pitchSmoother_.reset(newSampleRate, kParameterRampSeconds);
+  panSmoother_.reset(newSampleRate, kParameterRampSeconds);
+  densitySmoother_.setCurrentAndTargetValue(globalDensity_.load());
+  pitchSmoother_.setCurrentAndTargetValue(pitch.load());
+  panSmoother_.setCurrentAndTargetValue(centralPan.load());
 }
 
-void StochasticModel::generateNewGrain(Grain& newGrain) {
+void StochasticModel::setModulation(const ModulationMatrix::Offsets& offsets) {
+  auto offset = [&offsets](ModulationMatrix::Destination destination) {
+    return offsets[static_cast<size_t>(destination)];
+  };
+  using Destination = ModulationMatrix::Destination;
+  modulation_.pitch = offset(Destination::Pitch);
+  modulation_.dispersion = offset(Destination::Dispersion);
+  modulation_.pan = offset(Destination::Pan);
+  modulation_.panSpread = offset(Destination::PanSpread);
+  modulation_.densityScale = std::exp2(offset(Destination::Density));
+  modulation_.durationScale = std::exp2(offset(Destination::Duration));
+}
+
+void StochasticModel::advanceSmoothing(int numSamples) {
+  if (numSamples <= 0)
+    return;
+  densitySmoother_.skip(numSamples);
+  pitchSmoother_.skip(numSamples);
+  panSmoother_.skip(numSamples);
+}
+
+void StochasticModel::generateNewGrain(Grain& newGrain,
+                                       MidiInfluence midiInfluence) {
   // 1. Get atomic values
-  float avgDurationMs = averageDurationMs_.load(std::memory_order_relaxed);
+  float avgDurationMs = averageDurationMs_.load(std::memory_order_relaxed) *
+                        modulation_.durationScale;
   float variation = durationVariation_.load(
       std::memory_order_relaxed);  // This is the 'variation' parameter, e.g.,
                                    // 0.1 for 10%
@@ -79,31 +148,32 @@ void StochasticModel::generateNewGrain(Grain& newGrain) {
   // as per the current task. They would be set by other parts of
   // StochasticModel or have default values. Pitch
 
-  // Retrieve base pitch, MIDI target pitch, and MIDI influence
-  float basePitch = pitch.load(std::memory_order_relaxed);
-  float targetPitch = midiTargetPitch_.load(std::memory_order_relaxed);
-  float influence = midiInfluence_.load(std::memory_order_relaxed);
+  // Retrieve base pitch and the spawning voice's MIDI target and influence
+  float basePitch = currentValue(pitchSmoother_, pitch);
+  float targetPitch = midiInfluence.targetPitch;
+  float influence = midiInfluence.amount;
 
   // Calculate effective pitch based on MIDI influence
   float effectivePitch = (basePitch * (1.0f - influence)) + (targetPitch * influence);
+  effectivePitch += modulation_.pitch;
 
-  if (influence > 0.0f) {
-    DBG("StochasticModel::generateNewGrain - MIDI Influence Active:");
-    DBG("  Base Pitch: " + juce::String(basePitch));
-    DBG("  Target Pitch: " + juce::String(targetPitch));
-    DBG("  Influence: " + juce::String(influence));
-    DBG("  Effective Pitch: " + juce::String(effectivePitch));
+  if (influence > 0.0f && logger_ != nullptr) {
+    logger_->log(RtLogEvent::GrainMidiInfluence, basePitch, targetPitch,
+                 influence, effectivePitch);
   }
 
   using PitchDistributionParams = std::normal_distribution<float>::param_type;
-  pitchDistribution.param(
-      PitchDistributionParams(effectivePitch, dispersion.load(std::memory_order_relaxed)));
+  pitchDistribution.param(PitchDistributionParams(
+      effectivePitch,
+      std::max(0.0f, dispersion.load(std::memory_order_relaxed) +
+                         modulation_.dispersion)));
   newGrain.pitch = pitchDistribution(randomEngine);
 
   // Pan
   using PanDistributionParams = std::normal_distribution<float>::param_type;
-  panDistribution.param(
-      PanDistributionParams(centralPan.load(), panSpread.load()));
+  panDistribution.param(PanDistributionParams(
+      currentValue(panSmoother_, centralPan) + modulation_.pan,
+      std::max(0.0f, panSpread.load() + modulation_.panSpread)));
   float generatedPan = panDistribution(randomEngine);
   newGrain.pan = std::clamp(generatedPan, -1.0f, 1.0f);
 
@@ -126,7 +196,7 @@ void StochasticModel::generateNewGrain(Grain& newGrain) {
 
 int StochasticModel::getSamplesUntilNextEvent() {
   // 1. Get atomic values
-  float currentGrainsPerSecond = globalDensity_.load(std::memory_order_relaxed);
+  float currentGrainsPerSecond = getSmoothedDensity();
   double currentSampleRate = sampleRate_.load(std::memory_order_relaxed);
   TemporalDistribution currentModel =
       globalTemporalDistribution_.load(std::memory_order_relaxed);
@@ -173,8 +243,3 @@ int StochasticModel::getSamplesUntilNextEvent() {
   // Fallback, though ideally all enum values should be handled.
   return INT_MAX;
 }
-
-void StochasticModel::setMidiInfluence(int noteNumber, float influenceAmount) {
-  midiTargetPitch_.store(static_cast<float>(noteNumber));
-  midiInfluence_.store(influenceAmount);
-}
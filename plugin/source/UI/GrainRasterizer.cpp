@@ -0,0 +1,125 @@
+#include "UI/GrainRasterizer.h"
+#include "Pointilsynth/SpanTracer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace audio_plugin {
+
+GrainRasterizer::GrainRasterizer(bool useBackgroundThread)
+    : juce::Thread("Grain rasterizer"),
+      useBackgroundThread_(useBackgroundThread) {
+  for (int i = 0; i < kNumSprites; ++i) {
+    const float radius = kMinRadius + kRadiusStep * static_cast<float>(i);
+    auto& sprite = sprites_[static_cast<size_t>(i)];
+    sprite.size = 2 * static_cast<int>(std::ceil(radius)) + 2;
+    sprite.coverage.resize(static_cast<size_t>(sprite.size * sprite.size));
+    const float centre = static_cast<float>(sprite.size) * 0.5f;
+    for (int y = 0; y < sprite.size; ++y) {
+      for (int x = 0; x < sprite.size; ++x) {
+        // Distance from the pixel centre to the disc centre, with a one
+        // pixel wide anti-aliased edge.
+        const float dx = static_cast<float>(x) + 0.5f - centre;
+        const float dy = static_cast<float>(y) + 0.5f - centre;
+        const float distance = std::sqrt(dx * dx + dy * dy);
+        sprite.coverage[static_cast<size_t>(y * sprite.size + x)] =
+            std::clamp(radius + 0.5f - distance, 0.0f, 1.0f);
+      }
+    }
+  }
+  if (useBackgroundThread_)
+    startThread(juce::Thread::Priority::low);
+}
+
+GrainRasterizer::~GrainRasterizer() {
+  if (useBackgroundThread_) {
+    signalThreadShouldExit();
+    frameSubmitted_.signal();
+    stopThread(1000);
+  }
+}
+
+void GrainRasterizer::submit(std::vector<Dot>& dots, int width, int height) {
+  auto& frame = frames_.getWriteBuffer();
+  frame.dots.swap(dots);
+  frame.width = width;
+  frame.height = height;
+  frames_.publish().dots.clear();
+  dots.clear();
+  if (useBackgroundThread_) {
+    frameSubmitted_.signal();
+  } else if (const auto* submitted = frames_.acquire()) {
+    render(*submitted);
+  }
+}
+
+void GrainRasterizer::run() {
+  SpanTracer::nameCurrentThread("Grain rasterizer");
+  while (!threadShouldExit()) {
+    frameSubmitted_.wait(100);
+    if (const auto* frame = frames_.acquire())
+      render(*frame);
+  }
+}
+
+void GrainRasterizer::render(const Frame& frame) {
+  POINTILSYNTH_TRACE_SCOPE("GrainRasterizer::render");
+  auto& image = images_.getWriteBuffer();
+  if (image.getWidth() != frame.width || image.getHeight() != frame.height) {
+    if (frame.width <= 0 || frame.height <= 0)
+      return;
+    image = juce::Image(juce::Image::RGB, frame.width, frame.height, false,
+                        juce::SoftwareImageType());
+  }
+  rasterize(frame.dots, image);
+  images_.publish();
+}
+
+const GrainRasterizer::Sprite& GrainRasterizer::spriteFor(float radius) const {
+  const int index = static_cast<int>(
+      std::lround((std::clamp(radius, kMinRadius, kMaxRadius) - kMinRadius) /
+                  kRadiusStep));
+  return sprites_[static_cast<size_t>(std::clamp(index, 0, kNumSprites - 1))];
+}
+
+void GrainRasterizer::rasterize(const std::vector<Dot>& dots,
+                                juce::Image& image) const {
+  jassert(image.getFormat() == juce::Image::RGB);
+  const int width = image.getWidth();
+  const int height = image.getHeight();
+  juce::Image::BitmapData pixels(image, juce::Image::BitmapData::readWrite);
+  for (int y = 0; y < height; ++y)
+    std::fill_n(pixels.getLinePointer(y),
+                static_cast<size_t>(width * pixels.pixelStride), uint8_t{0});
+
+  // Every channel of a grey pixel holds the same value and the dots are
+  // white, so blending one channel and copying it into the others works
+  // whatever the byte order.
+  for (const auto& dot : dots) {
+    const float alpha = std::clamp(dot.alpha, 0.0f, 1.0f);
+    if (alpha <= 0.0f)
+      continue;
+    const auto& sprite = spriteFor(dot.radius);
+    const int left = static_cast<int>(std::lround(dot.x)) - sprite.size / 2;
+    const int top = static_cast<int>(std::lround(dot.y)) - sprite.size / 2;
+    const int x0 = std::max(0, -left);
+    const int x1 = std::min(sprite.size, width - left);
+    for (int sy = std::max(0, -top); sy < std::min(sprite.size, height - top);
+         ++sy) {
+      const float* coverage =
+          sprite.coverage.data() + static_cast<size_t>(sy * sprite.size);
+      for (int sx = x0; sx < x1; ++sx) {
+        const float amount = coverage[sx] * alpha;
+        if (amount <= 0.0f)
+          continue;
+        uint8_t* pixel = pixels.getPixelPointer(left + sx, top + sy);
+        const float value = static_cast<float>(pixel[0]);
+        const auto blended =
+            static_cast<uint8_t>(value + (255.0f - value) * amount + 0.5f);
+        pixel[0] = pixel[1] = pixel[2] = blended;
+      }
+    }
+  }
+}
+
+}  // namespace audio_plugin
@@ -1,78 +1,119 @@
 #include "UI/InertialHistoryVisualizer.h"
+#include "Pointilsynth/SpanTracer.h"
 
+#include <algorithm>
 #include <cmath>
 
 namespace audio_plugin {
 
+namespace {
+// The value a column shows for layer i: a layer the column lacks sits on
+// top of the ones it has.
+float layerTop(int numLayers, const float* tops, int layer) {
+  if (numLayers == 0)
+    return 0.0f;
+  return tops[std::min(layer, numLayers - 1)];
+}
+}  // namespace
+
 InertialHistoryVisualizer::InertialHistoryVisualizer(
     InertialHistoryManager& manager)
-    : manager_(manager) {
+    : manager_(manager), columns_(kMaxPoints), numQuietTicks_(kMaxPoints) {
   startTimerHz(30);
 }
 
+void InertialHistoryVisualizer::resized() {
+  redrawPlot();
+}
+
 void InertialHistoryVisualizer::timerCallback() {
-  const size_t noteCount = manager_.getNumNotes();
-  if (histories_.size() < noteCount)
-    histories_.resize(noteCount);
+  POINTILSYNTH_TRACE_SCOPE("InertialHistoryVisualizer::timerCallback");
+  if (const auto* snapshot = manager_.acquireSnapshot())
+    latest_ = snapshot;
+  const size_t noteCount = latest_ != nullptr ? latest_->numNotes : 0;
 
+  // Once every stored column is empty the plot is flat black; stop
+  // scrolling it until notes return.
+  numQuietTicks_ =
+      noteCount > 0 ? 0 : std::min(numQuietTicks_ + 1, kMaxPoints + 1);
+  if (numQuietTicks_ > kMaxPoints)
+    return;
+
+  newestColumn_ = (newestColumn_ + 1) % kMaxPoints;
+  numColumns_ = std::min(numColumns_ + 1, kMaxPoints);
+  auto& column = columns_[static_cast<size_t>(newestColumn_)];
+  float top = 0.0f;
   for (size_t i = 0; i < noteCount; ++i) {
-    const auto& note = manager_.getNote(i);
-    const float value = std::sin(static_cast<float>(note.ageInBars) *
-                                 juce::MathConstants<float>::twoPi) *
-                        note.currentInfluence;
-    auto& hist = histories_[i];
-    hist.push_back(value);
-    if (static_cast<int>(hist.size()) > maxPoints_)
-      hist.pop_front();
-  }
-  for (size_t i = noteCount; i < histories_.size(); ++i) {
-    auto& hist = histories_[i];
-    hist.push_back(0.0f);
-    if (static_cast<int>(hist.size()) > maxPoints_)
-      hist.pop_front();
+    const auto& note = latest_->notes[i];
+    top += std::sin(static_cast<float>(note.ageInBars) *
+                    juce::MathConstants<float>::twoPi) *
+           note.currentInfluence;
+    column.tops[i] = top;
+    column.noteNumbers[i] = note.noteNumber;
   }
+  column.numLayers = static_cast<int>(noteCount);
 
+  if (plot_.isValid()) {
+    const int width = plot_.getWidth();
+    const int height = plot_.getHeight();
+    plot_.moveImageSection(0, 0, kPixelsPerPoint, 0, width - kPixelsPerPoint,
+                           height);
+    juce::Graphics g(plot_);
+    g.setColour(juce::Colours::black);
+    g.fillRect(width - kPixelsPerPoint, 0, kPixelsPerPoint, height);
+    if (numColumns_ > 1) {
+      const int previous = (newestColumn_ + kMaxPoints - 1) % kMaxPoints;
+      drawSegment(g, columns_[static_cast<size_t>(previous)], column,
+                  static_cast<float>(width - 1 - kPixelsPerPoint));
+    }
+  }
   repaint();
 }
 
-void InertialHistoryVisualizer::paint(juce::Graphics& g) {
-  g.fillAll(juce::Colours::black);
-  const int width = getWidth();
-  const int height = getHeight();
-
-  if (histories_.empty())
-    return;
+void InertialHistoryVisualizer::drawSegment(juce::Graphics& g,
+                                            const Column& previous,
+                                            const Column& next,
+                                            float x) const {
+  const auto height = static_cast<float>(plot_.getHeight());
+  const float scale = height / 4.0f;
+  for (int i = 0; i < next.numLayers; ++i) {
+    const auto layer = static_cast<size_t>(i);
+    const float y0 = height / 2.0f -
+                     layerTop(previous.numLayers, previous.tops.data(), i) *
+                         scale;
+    const float y1 = height / 2.0f - next.tops[layer] * scale;
+    // Coloured by pitch class, so a note keeps its colour as layers shift.
+    g.setColour(juce::Colour::fromHSV(
+        static_cast<float>(next.noteNumbers[layer] % 12) / 12.0f, 0.7f, 0.9f,
+        1.0f));
+    g.drawLine(x, y0, x + static_cast<float>(kPixelsPerPoint), y1, 1.0f);
+  }
+}
 
-  const size_t historyPoints = histories_.front().size();
-  if (historyPoints < 2)
+void InertialHistoryVisualizer::redrawPlot() {
+  if (getHeight() <= 0) {
+    plot_ = {};
     return;
-
-  std::vector<float> baseline(historyPoints, 0.0f);
-  const float scale = static_cast<float>(height) / 4.0f;
-  const float xStep =
-      static_cast<float>(width) / static_cast<float>(maxPoints_ - 1);
-
-  for (size_t i = 0; i < histories_.size(); ++i) {
-    const auto& hist = histories_[i];
-    if (hist.empty())
-      continue;
-
-    juce::Path p;
-    for (size_t j = 0; j < historyPoints; ++j) {
-      baseline[j] += hist[j];
-      const float x = static_cast<float>(j) * xStep;
-      const float y = static_cast<float>(height) / 2.0f - baseline[j] * scale;
-      if (j == 0)
-        p.startNewSubPath(x, y);
-      else
-        p.lineTo(x, y);
-    }
-    juce::Colour colour = juce::Colour::fromHSV(
-        static_cast<float>(i) / static_cast<float>(histories_.size()), 0.7f,
-        0.9f, 1.0f);
-    g.setColour(colour);
-    g.strokePath(p, juce::PathStrokeType(1.0f));
   }
+  plot_ = juce::Image(juce::Image::RGB, (kMaxPoints - 1) * kPixelsPerPoint + 1,
+                      getHeight(), true);
+  juce::Graphics g(plot_);
+  g.fillAll(juce::Colours::black);
+  // The newest column sits on the right edge, older ones to its left.
+  for (int age = numColumns_ - 1; age > 0; --age) {
+    const int next = (newestColumn_ + kMaxPoints - age + 1) % kMaxPoints;
+    const int previous = (next + kMaxPoints - 1) % kMaxPoints;
+    drawSegment(g, columns_[static_cast<size_t>(previous)],
+                columns_[static_cast<size_t>(next)],
+                static_cast<float>(plot_.getWidth() - 1 -
+                                   age * kPixelsPerPoint));
+  }
+}
+
+void InertialHistoryVisualizer::paint(juce::Graphics& g) {
+  g.fillAll(juce::Colours::black);
+  if (plot_.isValid())
+    g.drawImage(plot_, getLocalBounds().toFloat());
 }
 
 }  // namespace audio_plugin
@@ -1,4 +1,8 @@
 #include "UI/VisualizationComponent.h"
+#include "Pointilsynth/SpanTracer.h"
+
+#include <algorithm>
+#include <cmath>
 
 namespace audio_plugin {
 
@@ -6,62 +10,220 @@ namespace {
 inline double currentTimeSeconds() {
   return juce::Time::getMillisecondCounterHiRes() / 1000.0;
 }
+
+// Heat halves in about a fifth of a second, so the map follows the sound.
+// The normalising peak falls ten times slower, so silence fades to black.
+constexpr double kHeatDecaySeconds = 0.3;
+constexpr double kPeakDecaySeconds = 3.0;
 }  // namespace
 
-VisualizationComponent::VisualizationComponent(juce::AbstractFifo& fifo,
-                                               GrainInfoForVis* buffer)
-    : fifo_(fifo), buffer_(buffer) {
+VisualizationComponent::VisualizationComponent(GrainVisQueue& queue,
+                                               GrainDensityGrid& densityGrid,
+                                               GrainSnapshotBuffer* snapshots)
+    : queue_(queue),
+      snapshots_(snapshots),
+      densityGrid_(densityGrid),
+      heatmapImage_(juce::Image::ARGB,
+                    GrainDensityGrid::kPanBins,
+                    GrainDensityGrid::kPitchBins,
+                    true) {
+  incoming_.reserve(GrainVisQueue::kCapacity);
+  if (snapshots_ != nullptr)
+    snapshots_->setEnabled(true);
+  heatmapToggle_.setToggleState(densityGrid_.isEnabled(),
+                                juce::dontSendNotification);
+  heatmapToggle_.setColour(juce::ToggleButton::textColourId,
+                           juce::Colours::grey);
+  heatmapToggle_.onClick = [this] {
+    setHeatmapMode(heatmapToggle_.getToggleState());
+  };
+  addAndMakeVisible(heatmapToggle_);
+  lastTickSeconds_ = currentTimeSeconds();
   openGLContext.attachTo(*this);
-  startTimerHz(60);  // 60 FPS
+  setFrameRateHz(kActiveHz);
 }
 
 VisualizationComponent::~VisualizationComponent() {
   stopTimer();
+  if (snapshots_ != nullptr)
+    snapshots_->setEnabled(false);
   openGLContext.detach();
 }
 
+void VisualizationComponent::setHeatmapMode(bool shouldShowHeatmap) {
+  densityGrid_.setEnabled(shouldShowHeatmap);
+  heatmapToggle_.setToggleState(shouldShowHeatmap, juce::dontSendNotification);
+  grains.clear();
+  grainFrame_ = nullptr;
+  numNotShown_ = 0;
+  sizeChanged_ = true;  // Redraw whichever picture is now shown
+  sceneIsIdle_ = false;
+  heat_.fill(0.0f);
+  heatPeak_ = 0.0f;
+  repaint();
+}
+
+void VisualizationComponent::resized() {
+  auto toggleArea = getLocalBounds().removeFromBottom(24);
+  heatmapToggle_.setBounds(toggleArea.removeFromLeft(90));
+  sizeChanged_ = true;
+}
+
 void VisualizationComponent::timerCallback() {
+  POINTILSYNTH_TRACE_SCOPE("VisualizationComponent::timerCallback");
   const double now = currentTimeSeconds();
+  const double elapsed = now - lastTickSeconds_;
+  lastTickSeconds_ = now;
 
-  grains.erase(std::remove_if(grains.begin(), grains.end(),
-                              [now](const VisualGrain& g) {
-                                return now - g.startTime > g.maxAge;
-                              }),
-               grains.end());
-  int start1, size1, start2, size2;
-  while (true) {
-    fifo_.prepareToRead(1, start1, size1, start2, size2);
-    if (size1 == 0)
-      break;
-    GrainInfoForVis info = buffer_[start1];
-    fifo_.finishedRead(size1);
-    VisualGrain g;
-    g.pan = info.pan;
-    g.pitch = info.pitch;
-    g.size = 4.0f;
-    g.colour = juce::Colours::white;
-    g.startTime = now;
-    g.maxAge = static_cast<double>(info.durationSeconds);
-    grains.push_back(g);
+  const bool changed = isHeatmapMode() ? updateHeatmap(elapsed)
+                                       : updateGrains(now);
+  setFrameRateHz(sceneIsIdle_ ? kIdleHz : kActiveHz);
+  if (changed)
+    repaint();
+}
+
+void VisualizationComponent::setFrameRateHz(int hz) {
+  if (hz == frameRateHz_)
+    return;
+  frameRateHz_ = hz;
+  startTimerHz(hz);
+}
+
+juce::Point<float> VisualizationComponent::toScreen(float pan,
+                                                    float pitch) const {
+  return {juce::jmap(pan, -1.0f, 1.0f, 0.0f, static_cast<float>(getWidth())),
+          juce::jmap(pitch, 108.0f, 21.0f, 0.0f,
+                     static_cast<float>(getHeight()))};
+}
+
+bool VisualizationComponent::updateGrains(double now) {
+  // Pick up what the rasterizer finished since the last tick, then hand it
+  // the next frame if the cloud has changed.
+  bool changed = false;
+  if (rasterizer_.hasNewFrame()) {
+    grainFrame_ = rasterizer_.acquireFrame();
+    changed = true;
   }
 
-  repaint();
+  bool cloudChanged = false;
+  dots_.clear();
+  if (snapshots_ != nullptr) {
+    if (const auto* snapshot = snapshots_->acquire()) {
+      collectSnapshotDots(*snapshot);
+      cloudChanged = true;
+      sizeChanged_ = false;
+    }
+  } else {
+    // Expire and collect in one pass, keeping the survivors in order.
+    incoming_.clear();
+    queue_.drain(incoming_);
+    numNotShown_ = queue_.getNumDropped();
+    for (const auto& info : incoming_) {
+      VisualGrain g;
+      g.pan = info.pan;
+      g.pitch = info.pitch;
+      g.size = 4.0f;
+      g.colour = juce::Colours::white;
+      g.startTime = now;
+      g.maxAge = static_cast<double>(info.durationSeconds);
+      grains.push_back(g);
+    }
+    size_t numKept = 0;
+    for (const auto& grain : grains) {
+      if (now - grain.startTime > grain.maxAge)
+        continue;
+      const auto centre = toScreen(grain.pan, grain.pitch);
+      dots_.push_back(
+          {centre.x, centre.y, grain.size, grain.colour.getFloatAlpha()});
+      grains[numKept++] = grain;
+    }
+    cloudChanged =
+        sizeChanged_ || !incoming_.empty() || numKept != grains.size();
+    sizeChanged_ = false;
+    grains.resize(numKept);
+  }
+
+  // An empty frame after an empty frame would draw nothing new.
+  if (cloudChanged && (!dots_.empty() || numDotsSubmitted_ > 0)) {
+    numDotsSubmitted_ = dots_.size();
+    rasterizer_.submit(dots_, getWidth(), getHeight());
+  }
+  sceneIsIdle_ = numDotsSubmitted_ == 0 && !rasterizer_.hasNewFrame();
+  return changed;
+}
+
+void VisualizationComponent::collectSnapshotDots(
+    const GrainSnapshot& snapshot) {
+  // Each grain grows and brightens with its envelope.
+  for (int i = 0; i < snapshot.numGrains; ++i) {
+    const auto& grain = snapshot.grains[static_cast<size_t>(i)];
+    const float level = std::clamp(grain.gain, 0.0f, 1.0f);
+    const auto centre = toScreen(grain.pan, grain.pitch);
+    dots_.push_back({centre.x, centre.y, 1.0f + 4.0f * std::sqrt(level),
+                     0.25f + 0.75f * level});
+  }
+  numNotShown_ = static_cast<uint32_t>(
+      std::max(0, snapshot.numLive - snapshot.numGrains));
+}
+
+bool VisualizationComponent::updateHeatmap(double elapsedSeconds) {
+  const auto decay =
+      static_cast<float>(std::exp(-elapsedSeconds / kHeatDecaySeconds));
+  const auto* published = densityGrid_.acquire();
+  float peak = 0.0f;
+  for (size_t cell = 0; cell < heat_.size(); ++cell) {
+    heat_[cell] *= decay;
+    if (published != nullptr)
+      heat_[cell] += (*published)[cell];
+    peak = std::max(peak, heat_[cell]);
+  }
+  // Normalise to a peak that falls slowly, so the map does not flicker as
+  // the loudest cell comes and goes.
+  heatPeak_ = std::max(
+      peak, heatPeak_ * static_cast<float>(
+                            std::exp(-elapsedSeconds / kPeakDecaySeconds)));
+
+  // Below a level of 1/256 every cell draws as black, so a map that was
+  // already black need not be redrawn.
+  const bool wasIdle = sceneIsIdle_;
+  sceneIsIdle_ = !(peak * 65536.0f > heatPeak_);
+  if (sceneIsIdle_ && wasIdle)
+    return false;
+
+  juce::Image::BitmapData pixels(heatmapImage_,
+                                 juce::Image::BitmapData::writeOnly);
+  for (int row = 0; row < GrainDensityGrid::kPitchBins; ++row) {
+    const int y = GrainDensityGrid::kPitchBins - 1 - row;  // High notes on top
+    for (int column = 0; column < GrainDensityGrid::kPanBins; ++column) {
+      const float value =
+          heat_[static_cast<size_t>(row * GrainDensityGrid::kPanBins + column)];
+      const float level =
+          heatPeak_ > 0.0f ? std::sqrt(value / heatPeak_) : 0.0f;
+      pixels.setPixelColour(
+          column, y,
+          juce::Colour::fromHSV(0.66f * (1.0f - level), 1.0f, level, 1.0f));
+    }
+  }
+  return true;
 }
 
 void VisualizationComponent::paint(juce::Graphics& g) {
   g.fillAll(juce::Colours::black);
+  if (isHeatmapMode()) {
+    g.setImageResamplingQuality(juce::Graphics::lowResamplingQuality);
+    g.drawImage(heatmapImage_, getLocalBounds().toFloat());
+    return;
+  }
+
+  if (grainFrame_ != nullptr)
+    g.drawImageAt(*grainFrame_, 0, 0);
 
-  const int width = getWidth();
-  const int height = getHeight();
-
-  for (const auto& grain : grains) {
-    float x =
-        juce::jmap(grain.pan, -1.0f, 1.0f, 0.0f, static_cast<float>(width));
-    float y = juce::jmap(grain.pitch, 108.0f, 21.0f, 0.0f,
-                         static_cast<float>(height));
-    float diameter = grain.size * 2.0f;
-    g.setColour(grain.colour);
-    g.fillEllipse(x - grain.size, y - grain.size, diameter, diameter);
+  // The picture is missing grains; say so rather than show a thinner cloud.
+  if (numNotShown_ > 0) {
+    g.setColour(juce::Colours::orange);
+    g.setFont(12.0f);
+    g.drawText(juce::String(numNotShown_) + " grains not shown",
+               getLocalBounds().reduced(4), juce::Justification::topRight);
   }
 }
 
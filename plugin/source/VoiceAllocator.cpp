@@ -0,0 +1,148 @@
+#include "Pointilsynth/VoiceAllocator.h"
+
+#include <algorithm>
+
+void VoiceAllocator::reset(int samplesUntilNextGrain, float density) {
+  // Live grain counts are left alone: grains still in the pool are counted
+  // out as they finish.
+  for (auto& voice : voices_) {
+    voice.isActive = false;
+    voice.isSpawning = false;
+    voice.isHeld = false;
+  }
+  auto& freeStream = voices_[0];
+  freeStream.isActive = true;
+  freeStream.isSpawning = true;
+  freeStream.noteNumber = -1;
+  freeStream.influence = 0.0f;
+  freeStream.startOrder = nextOrder_++;
+  freeStream.samplesUntilNextGrain = samplesUntilNextGrain;
+  freeStream.scheduledDensity = density;
+}
+
+int VoiceAllocator::noteOn(int noteNumber, float velocity, int maxVoices) {
+  maxVoices = std::clamp(maxVoices, 1, kMaxVoices);
+  int numActive = 0;
+  int unused = -1;
+  int freeStream = -1;
+  int retriggered = -1;
+  int oldestReleased = -1;
+  int oldestHeld = -1;
+  auto isOlder = [this](int voice, int than) {
+    return than < 0 || getVoice(voice).startOrder < getVoice(than).startOrder;
+  };
+  for (int i = 0; i < kMaxVoices; ++i) {
+    const auto& voice = getVoice(i);
+    if (!voice.isActive) {
+      if (unused < 0)
+        unused = i;
+      continue;
+    }
+    ++numActive;
+    if (!voice.isHeld && voice.isSpawning) {
+      freeStream = i;
+    } else if (!voice.isHeld) {
+      if (isOlder(i, oldestReleased))
+        oldestReleased = i;
+    } else {
+      if (voice.noteNumber == noteNumber)
+        retriggered = i;
+      if (isOlder(i, oldestHeld))
+        oldestHeld = i;
+    }
+  }
+
+  // A held voice keeps its schedule when it changes note; a voice that was
+  // not spawning starts paused.
+  int chosen = -1;
+  bool keepsSchedule = true;
+  if (retriggered >= 0) {
+    chosen = retriggered;
+  } else if (freeStream >= 0) {
+    chosen = freeStream;
+  } else if (numActive < maxVoices) {
+    chosen = unused;
+    keepsSchedule = false;
+  } else if (oldestReleased >= 0) {
+    chosen = oldestReleased;
+    keepsSchedule = false;
+  } else {
+    chosen = oldestHeld;
+  }
+
+  auto& voice = getVoice(chosen);
+  voice.isActive = true;
+  voice.isSpawning = true;
+  voice.isHeld = true;
+  voice.noteNumber = noteNumber;
+  voice.influence = velocity;
+  voice.startOrder = nextOrder_++;
+  if (!keepsSchedule) {
+    voice.samplesUntilNextGrain = INT_MAX;
+    voice.scheduledDensity = 0.0f;
+  }
+  return chosen;
+}
+
+int VoiceAllocator::noteOff(int noteNumber) {
+  int released = -1;
+  bool othersHeld = false;
+  for (int i = 0; i < kMaxVoices; ++i) {
+    const auto& voice = getVoice(i);
+    if (!voice.isHeld)
+      continue;
+    if (voice.noteNumber == noteNumber &&
+        (released < 0 || voice.startOrder > getVoice(released).startOrder)) {
+      if (released >= 0)
+        othersHeld = true;
+      released = i;
+    } else {
+      othersHeld = true;
+    }
+  }
+  if (released < 0)
+    return -1;
+
+  auto& voice = getVoice(released);
+  voice.isHeld = false;
+  if (othersHeld) {
+    voice.isSpawning = false;
+    voice.samplesUntilNextGrain = INT_MAX;
+  } else {
+    // The last note released: its stream plays on without influence.
+    voice.noteNumber = -1;
+    voice.influence = 0.0f;
+  }
+  return released;
+}
+
+void VoiceAllocator::cullSilentVoices() {
+  for (auto& voice : voices_) {
+    if (voice.isActive && !voice.isSpawning && voice.numLiveGrains <= 0)
+      voice.isActive = false;
+  }
+}
+
+int VoiceAllocator::nextOnset(int numSamples) const {
+  int next = -1;
+  for (int i = 0; i < kMaxVoices; ++i) {
+    const auto& voice = getVoice(i);
+    if (voice.isSpawning && voice.samplesUntilNextGrain < numSamples &&
+        (next < 0 || voice.samplesUntilNextGrain <
+                         getVoice(next).samplesUntilNextGrain))
+      next = i;
+  }
+  return next;
+}
+
+int VoiceAllocator::getNumActiveVoices() const {
+  return static_cast<int>(
+      std::count_if(voices_.begin(), voices_.end(),
+                    [](const Voice& voice) { return voice.isActive; }));
+}
+
+int VoiceAllocator::getNumHeldVoices() const {
+  return static_cast<int>(
+      std::count_if(voices_.begin(), voices_.end(),
+                    [](const Voice& voice) { return voice.isHeld; }));
+}
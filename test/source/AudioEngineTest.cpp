@@ -1,7 +1,10 @@
 #include "Pointilsynth/PluginProcessor.h"
 #include "melatonin_test_helpers/melatonin_test_helpers.h"
+#include "RealtimeSafety.h"
 #include <catch2/catch_test_macros.hpp>
 
+#include <memory>
+
 using namespace audio_plugin;
 using namespace melatonin;
 
@@ -13,7 +16,7 @@ TEST_CASE("AudioEngine: Silence") {
   if (auto* param = apvts.getParameter(ConfigManager::ParamID::density)) {
     param->setValueNotifyingHost(param->convertTo0to1(0.0f));
   }
-  AudioEngine engine(cfg);
+  AudioEngine engine(cfg->getParameterHandles());
   engine.prepareToPlay(44100.0, 512);
   juce::AudioBuffer<float> buffer(2, 512);
   juce::MidiBuffer midi;
@@ -21,3 +24,109 @@ TEST_CASE("AudioEngine: Silence") {
   engine.processBlock(buffer, midi, pos);
   REQUIRE_THAT(buffer, isEmpty());
 }
+
+TEST_CASE("AudioEngine: SubBlockSizeIsClamped") {
+  AudioEngine engine;
+  engine.setSubBlockSize(100000);
+  REQUIRE(engine.getSubBlockSize() == AudioEngine::kMaxSubBlockSize);
+  engine.setSubBlockSize(0);
+  REQUIRE(engine.getSubBlockSize() == 1);
+}
+
+TEST_CASE("AudioEngine: RendersHostBlocksNotMultipleOfSubBlock") {
+  AudioEngine engine;
+  engine.getStochasticModel()->setGlobalDensity(50.0f);
+  engine.setSubBlockSize(32);
+  engine.prepareToPlay(44100.0, 1000);
+  juce::AudioBuffer<float> buffer(2, 1000);
+  juce::MidiBuffer midi;
+  juce::AudioPlayHead::PositionInfo pos;
+  for (int block = 0; block < 20; ++block)
+    engine.processBlock(buffer, midi, pos);
+  REQUIRE(buffer.getMagnitude(0, 0, buffer.getNumSamples()) > 0.0f);
+}
+
+TEST_CASE("AudioEngine: ProcessBlockIsRealtimeSafe") {
+  AudioEngine engine;
+  engine.getStochasticModel()->setGlobalDensity(200.0f);
+  engine.prepareToPlay(44100.0, 512);
+  juce::AudioBuffer<float> buffer(2, 512);
+  juce::MidiBuffer midi;
+  juce::AudioPlayHead::PositionInfo pos;
+  pos.setPpqPosition(0.0);
+  pos.setBpm(120.0);
+
+  // Warm up so the grain pool is in its steady state.
+  for (int block = 0; block < 20; ++block)
+    engine.processBlock(buffer, midi, pos);
+
+  for (int note = 0; note < 200; ++note)
+    midi.addEvent(juce::MidiMessage::noteOn(1, 36 + note % 48, 0.8f),
+                  note % 512);
+  REQUIRE_REALTIME_SAFE({
+    for (int block = 0; block < 20; ++block)
+      engine.processBlock(buffer, midi, pos);
+  });
+}
+
+TEST_CASE("AudioEngine: NotesTakeEffectAtTheirSamplePosition") {
+  auto snapshots = std::make_unique<GrainSnapshotBuffer>();
+  snapshots->setEnabled(true);
+  AudioEngine engine;
+  engine.setGrainSnapshots(snapshots.get());
+  auto* model = engine.getStochasticModel();
+  model->setPitchAndDispersion(60.0f, 0.0f);
+  model->setDurationAndVariation(500.0f, 0.0f);
+  model->setGlobalDensity(2000.0f);
+  engine.prepareToPlay(48000.0, 1024);
+
+  juce::AudioBuffer<float> buffer(2, 1024);
+  juce::MidiBuffer midi;
+  midi.addEvent(juce::MidiMessage::noteOn(1, 84, 1.0f), 700);
+  juce::AudioPlayHead::PositionInfo pos;
+  engine.processBlock(buffer, midi, pos);
+
+  // Grains spawned before the note keep the model's pitch; from the note on
+  // they take its pitch.
+  const auto* snapshot = snapshots->acquire();
+  REQUIRE(snapshot != nullptr);
+  const float durationInSamples = 0.5f * 48000.0f;
+  int numBefore = 0;
+  int numAfter = 0;
+  for (int i = 0; i < snapshot->numGrains; ++i) {
+    const auto& grain = snapshot->grains[static_cast<size_t>(i)];
+    const float onset = 1024.0f - grain.progress * durationInSamples;
+    if (grain.pitch == 84.0f) {
+      REQUIRE(onset >= 699.5f);
+      ++numAfter;
+    } else {
+      REQUIRE(grain.pitch == 60.0f);
+      REQUIRE(onset < 700.5f);
+      ++numBefore;
+    }
+  }
+  REQUIRE(numBefore > 0);
+  REQUIRE(numAfter > 0);
+}
+
+TEST_CASE("AudioEngine: NoteOnBurstStartsAtTheNote") {
+  AudioEngine engine;
+  engine.getStochasticModel()->setGlobalDensity(0.0f);
+  engine.setNoteOnBurst(8);
+  REQUIRE(engine.getNoteOnBurst() == 8);
+  engine.prepareToPlay(48000.0, 1024);
+
+  juce::AudioBuffer<float> buffer(2, 1024);
+  juce::MidiBuffer midi;
+  midi.addEvent(juce::MidiMessage::noteOn(1, 72, 1.0f), 300);
+  juce::AudioPlayHead::PositionInfo pos;
+  engine.processBlock(buffer, midi, pos);
+
+  // Without density only the burst sounds, from the note-on sample.
+  REQUIRE(engine.getNumActiveGrains() == 8);
+  REQUIRE(buffer.getMagnitude(0, 0, 300) == 0.0f);
+  REQUIRE(buffer.getMagnitude(0, 300, 200) > 0.0f);
+
+  engine.setNoteOnBurst(1000);
+  REQUIRE(engine.getNoteOnBurst() == AudioEngine::kMaxNoteOnBurst);
+}
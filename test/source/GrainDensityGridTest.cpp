@@ -0,0 +1,126 @@
+#include "Pointilsynth/GrainDensityGrid.h"
+#include "Pointilsynth/PointilismInterfaces.h"
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include <memory>
+#include <numeric>
+#include <vector>
+
+namespace {
+constexpr double kBlockSeconds = 0.01;
+
+float total(const GrainDensityGrid::Grid& grid) {
+  return std::accumulate(grid.begin(), grid.end(), 0.0f);
+}
+}  // namespace
+
+TEST_CASE("CellsCoverPitchAndPanRanges", "[GrainDensityGridTest]") {
+  constexpr int kPanBins = GrainDensityGrid::kPanBins;
+  REQUIRE(GrainDensityGrid::cellIndex(21.0f, -1.0f) == 0);
+  REQUIRE(GrainDensityGrid::cellIndex(108.0f, 1.0f) ==
+          GrainDensityGrid::kNumCells - 1);
+  REQUIRE(GrainDensityGrid::cellIndex(60.0f, 0.0f) ==
+          39 * kPanBins + kPanBins / 2);
+  // Out-of-range grains land on the edges rather than outside the grid.
+  REQUIRE(GrainDensityGrid::cellIndex(0.0f, -5.0f) == 0);
+  REQUIRE(GrainDensityGrid::cellIndex(200.0f, 5.0f) ==
+          GrainDensityGrid::kNumCells - 1);
+}
+
+TEST_CASE("UnreadGridsKeepAccumulating", "[GrainDensityGridTest]") {
+  auto grid = std::make_unique<GrainDensityGrid>();
+  REQUIRE_FALSE(grid->publish(kBlockSeconds));  // Nothing to hand over yet.
+  REQUIRE(grid->acquire() == nullptr);
+
+  grid->add(60.0f, 0.0f, 1.0f);
+  REQUIRE(grid->publish(kBlockSeconds));
+  grid->add(60.0f, 0.0f, 2.0f);
+  // The reader has not taken the first.
+  REQUIRE_FALSE(grid->publish(kBlockSeconds));
+  grid->add(72.0f, 0.5f, 4.0f);
+
+  const auto* first = grid->acquire();
+  REQUIRE(first != nullptr);
+  REQUIRE(total(*first) == Catch::Approx(1.0f));
+  REQUIRE(grid->acquire() == nullptr);
+
+  REQUIRE(grid->publish(kBlockSeconds));
+  const auto* second = grid->acquire();
+  REQUIRE(second != nullptr);
+  REQUIRE(total(*second) == Catch::Approx(6.0f));
+  REQUIRE((*second)[static_cast<size_t>(
+              GrainDensityGrid::cellIndex(72.0f, 0.5f))] ==
+          Catch::Approx(4.0f));
+
+  // Grids come back to the writer cleared.
+  for (int i = 0; i < 5; ++i) {
+    grid->add(40.0f, -0.5f, 1.0f);
+    REQUIRE(grid->publish(kBlockSeconds));
+    REQUIRE(total(*grid->acquire()) == Catch::Approx(1.0f));
+  }
+}
+
+TEST_CASE("GridsTheReaderLeavesAreDropped", "[GrainDensityGridTest]") {
+  auto grid = std::make_unique<GrainDensityGrid>();
+  grid->add(60.0f, 0.0f, 1.0f);
+  REQUIRE(grid->publish(kBlockSeconds));
+
+  // The reader stays away for just longer than a grid may wait.
+  for (double waited = 0.0; waited <= GrainDensityGrid::kMaxUnreadSeconds;
+       waited += kBlockSeconds) {
+    grid->add(60.0f, 0.0f, 1.0f);
+    REQUIRE_FALSE(grid->publish(kBlockSeconds));
+  }
+  const auto* stale = grid->acquire();
+  REQUIRE(stale != nullptr);
+  REQUIRE(total(*stale) == Catch::Approx(0.0f));
+
+  // Only what arrives once the reader is back is shown.
+  grid->add(72.0f, 0.0f, 2.0f);
+  REQUIRE(grid->publish(kBlockSeconds));
+  REQUIRE(total(*grid->acquire()) == Catch::Approx(2.0f));
+}
+
+TEST_CASE("ReenablingStartsFromAnEmptyGrid", "[GrainDensityGridTest]") {
+  auto grid = std::make_unique<GrainDensityGrid>();
+  grid->setEnabled(true);
+  grid->add(60.0f, 0.0f, 1.0f);
+  REQUIRE(grid->publish(kBlockSeconds));
+  grid->add(60.0f, 0.0f, 2.0f);
+
+  grid->setEnabled(false);
+  grid->setEnabled(true);
+  grid->add(72.0f, 0.0f, 4.0f);
+  REQUIRE_FALSE(grid->publish(kBlockSeconds));
+  // The unread grid from before was replaced by an empty one.
+  REQUIRE(total(*grid->acquire()) == Catch::Approx(0.0f));
+  REQUIRE(grid->publish(kBlockSeconds));
+  REQUIRE(total(*grid->acquire()) == Catch::Approx(4.0f));
+}
+
+TEST_CASE("EngineFillsTheGridInsteadOfTheQueue", "[GrainDensityGridTest]") {
+  auto queue = std::make_unique<GrainVisQueue>();
+  auto grid = std::make_unique<GrainDensityGrid>();
+  grid->setEnabled(true);
+  AudioEngine engine({}, queue.get(), grid.get());
+  engine.getStochasticModel()->setGlobalDensity(1000.0f);
+  engine.prepareToPlay(48000.0, 480);
+  juce::AudioBuffer<float> buffer(2, 480);
+  juce::MidiBuffer midi;
+  juce::AudioPlayHead::PositionInfo pos;
+
+  float energy = 0.0f;
+  for (int block = 0; block < 50; ++block) {
+    engine.processBlock(buffer, midi, pos);
+    if (const auto* published = grid->acquire())
+      energy += total(*published);
+  }
+  REQUIRE(energy > 0.0f);
+  REQUIRE(queue->getNumReady() == 0);
+
+  grid->setEnabled(false);
+  engine.processBlock(buffer, midi, pos);
+  REQUIRE(grid->acquire() == nullptr);
+  REQUIRE(queue->getNumReady() > 0);
+}
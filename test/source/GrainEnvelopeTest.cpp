@@ -1,6 +1,34 @@
 #include "Pointilsynth/GrainEnvelope.h"
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <array>
 
 TEST_CASE("CanConstruct", "[GrainEnvelopeTest]") {
   REQUIRE_NOTHROW(std::make_unique<GrainEnvelope>());
 }
+
+TEST_CASE("FillMatchesGetAmplitude", "[GrainEnvelopeTest]") {
+  GrainEnvelope env;
+  std::array<float, 64> block{};
+  for (int duration : {1, 2, 3, 17, 100, 1000}) {
+    for (int start : {-8, 0, 5, duration - 10}) {
+      env.setShape(GrainEnvelope::Shape::Trapezoid);
+      GrainEnvelope::fill<GrainEnvelope::Shape::Trapezoid>(
+          block.data(), start, static_cast<int>(block.size()), duration);
+      for (size_t i = 0; i < block.size(); ++i)
+        REQUIRE(block[i] ==
+                Catch::Approx(env.getAmplitude(start + static_cast<int>(i),
+                                               duration))
+                    .margin(1e-6f));
+
+      env.setShape(GrainEnvelope::Shape::Hann);
+      GrainEnvelope::fill<GrainEnvelope::Shape::Hann>(
+          block.data(), start, static_cast<int>(block.size()), duration);
+      for (size_t i = 0; i < block.size(); ++i)
+        REQUIRE(block[i] ==
+                Catch::Approx(env.getAmplitude(start + static_cast<int>(i),
+                                               duration))
+                    .margin(1e-5f));
+    }
+  }
+}
@@ -0,0 +1,72 @@
+#include "Pointilsynth/GrainRenderKernels.h"
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <array>
+
+namespace {
+struct KernelFixture {
+  std::array<float, 64> left{};
+  std::array<float, 64> right{};
+  std::array<float, 64> envelope{};
+  std::array<float, 64> source{};
+  GrainRenderKernels::Context context{nullptr, envelope.data(), source.data()};
+
+  static Grain makeGrain(int duration) {
+    Grain grain;
+    grain.durationInSamples = duration;
+    grain.gainLeft = 0.5f;
+    grain.gainRight = 0.25f;
+    grain.phaseIncrement = 0.01f;
+    return grain;
+  }
+};
+}  // namespace
+
+TEST_CASE_METHOD(KernelFixture,
+                 "RendersFromStartOffsetAndRetiresGrain",
+                 "[GrainRenderKernelsTest]") {
+  auto grain = makeGrain(40);
+  grain.startOffset = 30;
+  const auto group = GrainRenderKernels::groupIndex(
+      GrainRenderKernels::Source::Saw, GrainEnvelope::Shape::Trapezoid);
+  auto kernel = GrainRenderKernels::getKernel(group, 2);
+
+  kernel(context, grain, left.data(), right.data(), 64);
+  for (int i = 0; i < 30; ++i)
+    REQUIRE(left[static_cast<size_t>(i)] == 0.0f);
+  REQUIRE(grain.ageInSamples == 34);
+  REQUIRE(grain.isAlive);
+
+  grain.startOffset = 0;
+  kernel(context, grain, left.data(), right.data(), 64);
+  REQUIRE(grain.ageInSamples == 40);
+  REQUIRE_FALSE(grain.isAlive);
+}
+
+TEST_CASE_METHOD(KernelFixture,
+                 "StereoKernelAppliesPanGains",
+                 "[GrainRenderKernelsTest]") {
+  auto grain = makeGrain(64);
+  const auto group = GrainRenderKernels::groupIndex(
+      GrainRenderKernels::Source::Square, GrainEnvelope::Shape::Hann);
+  GrainRenderKernels::getKernel(group, 2)(context, grain, left.data(),
+                                          right.data(), 64);
+  for (size_t i = 0; i < left.size(); ++i)
+    REQUIRE(right[i] == Catch::Approx(left[i] * 0.5f).margin(1e-6f));
+}
+
+TEST_CASE_METHOD(KernelFixture,
+                 "MonoKernelLeavesRightUntouched",
+                 "[GrainRenderKernelsTest]") {
+  auto grain = makeGrain(64);
+  const auto group = GrainRenderKernels::groupIndex(
+      GrainRenderKernels::Source::Sine, GrainEnvelope::Shape::Hann);
+  GrainRenderKernels::getKernel(group, 1)(context, grain, left.data(),
+                                          right.data(), 64);
+  float leftEnergy = 0.0f;
+  for (size_t i = 0; i < left.size(); ++i) {
+    leftEnergy += std::abs(left[i]);
+    REQUIRE(right[i] == 0.0f);
+  }
+  REQUIRE(leftEnergy > 0.0f);
+}
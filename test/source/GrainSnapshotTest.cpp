@@ -0,0 +1,89 @@
+#include "Pointilsynth/GrainSnapshot.h"
+#include "Pointilsynth/PointilismInterfaces.h"
+#include "Pointilsynth/TripleBuffer.h"
+#include <catch2/catch_test_macros.hpp>
+
+#include <memory>
+
+TEST_CASE("TripleBufferHandsOverTheNewestValue", "[GrainSnapshotTest]") {
+  TripleBuffer<int> buffer;
+  REQUIRE(buffer.acquire() == nullptr);
+
+  buffer.getWriteBuffer() = 1;
+  buffer.publish() = 2;
+  REQUIRE(buffer.hasUnreadPublish());
+  buffer.publish();  // Replaces the unread 1.
+  const int* value = buffer.acquire();
+  REQUIRE(value != nullptr);
+  REQUIRE(*value == 2);
+  REQUIRE_FALSE(buffer.hasUnreadPublish());
+  REQUIRE(buffer.acquire() == nullptr);
+
+  // The writer never gets the buffer the reader holds.
+  for (int i = 3; i < 10; ++i) {
+    buffer.getWriteBuffer() = i;
+    buffer.publish();
+    REQUIRE(*value == 2);
+  }
+  REQUIRE(*buffer.acquire() == 9);
+}
+
+TEST_CASE("EngineSnapshotsLiveGrainsWithTheirEnvelope",
+          "[GrainSnapshotTest]") {
+  auto queue = std::make_unique<GrainVisQueue>();
+  auto snapshots = std::make_unique<GrainSnapshotBuffer>();
+  AudioEngine engine({}, queue.get());
+  engine.setGrainSnapshots(snapshots.get());
+  engine.getStochasticModel()->setGlobalDensity(500.0f);
+  engine.setEnvelopeShape(GrainEnvelope::Shape::Hann);
+  engine.prepareToPlay(48000.0, 480);
+  juce::AudioBuffer<float> buffer(2, 480);
+  juce::MidiBuffer midi;
+  juce::AudioPlayHead::PositionInfo pos;
+
+  engine.processBlock(buffer, midi, pos);
+  REQUIRE(snapshots->acquire() == nullptr);  // Not enabled yet.
+  REQUIRE(queue->getNumReady() > 0);
+
+  snapshots->setEnabled(true);
+  queue->resetDropped();
+  std::vector<GrainInfoForVis> stale;
+  queue->drain(stale);
+  for (int block = 0; block < 20; ++block)
+    engine.processBlock(buffer, midi, pos);
+  REQUIRE(queue->getNumReady() == 0);
+
+  const auto* snapshot = snapshots->acquire();
+  REQUIRE(snapshot != nullptr);
+  REQUIRE(snapshot->numGrains == engine.getNumActiveGrains());
+  REQUIRE(snapshot->numGrains > 0);
+  for (int i = 0; i < snapshot->numGrains; ++i) {
+    const auto& grain = snapshot->grains[static_cast<size_t>(i)];
+    REQUIRE(grain.progress >= 0.0f);
+    REQUIRE(grain.progress < 1.0f);
+    // A Hann envelope is at most 1 and only 0 at the very start.
+    REQUIRE(grain.gain >= 0.0f);
+    REQUIRE(grain.gain <= 1.0f);
+  }
+}
+
+TEST_CASE("SnapshotSizeIsBounded", "[GrainSnapshotTest]") {
+  auto snapshots = std::make_unique<GrainSnapshotBuffer>();
+  snapshots->setEnabled(true);
+  AudioEngine engine;
+  engine.setGrainSnapshots(snapshots.get());
+  engine.getStochasticModel()->setGlobalDensity(20000.0f);
+  engine.getStochasticModel()->setDurationAndVariation(1000.0f, 0.0f);
+  engine.prepareToPlay(48000.0, 480);
+  juce::AudioBuffer<float> buffer(2, 480);
+  juce::MidiBuffer midi;
+  juce::AudioPlayHead::PositionInfo pos;
+  for (int block = 0; block < 100; ++block)
+    engine.processBlock(buffer, midi, pos);
+
+  const auto* snapshot = snapshots->acquire();
+  REQUIRE(snapshot != nullptr);
+  REQUIRE(snapshot->numLive == engine.getNumActiveGrains());
+  REQUIRE(snapshot->numLive > GrainSnapshot::kMaxGrains);
+  REQUIRE(snapshot->numGrains == GrainSnapshot::kMaxGrains);
+}
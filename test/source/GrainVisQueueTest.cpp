@@ -0,0 +1,82 @@
+#include "Pointilsynth/GrainVisQueue.h"
+#include "Pointilsynth/PointilismInterfaces.h"
+#include <catch2/catch_test_macros.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace {
+std::vector<GrainInfoForVis> makeRecords(int count, float firstPitch) {
+  std::vector<GrainInfoForVis> records(static_cast<size_t>(count));
+  for (size_t i = 0; i < records.size(); ++i)
+    records[i].pitch = firstPitch + static_cast<float>(i);
+  return records;
+}
+}  // namespace
+
+TEST_CASE("BatchesSurviveWrapAroundInOrder", "[GrainVisQueueTest]") {
+  auto queue = std::make_unique<GrainVisQueue>();
+  std::vector<GrainInfoForVis> out;
+  // Move the ring's read and write positions close to the end.
+  const auto filler = makeRecords(GrainVisQueue::kCapacity - 100, 0.0f);
+  REQUIRE(queue->push(filler.data(), static_cast<int>(filler.size())) ==
+          GrainVisQueue::kCapacity - 100);
+  REQUIRE(queue->drain(out) == GrainVisQueue::kCapacity - 100);
+
+  const auto batch = makeRecords(300, 1000.0f);
+  REQUIRE(queue->push(batch.data(), 300) == 300);
+  out.clear();
+  REQUIRE(queue->drain(out) == 300);
+  for (size_t i = 0; i < out.size(); ++i)
+    REQUIRE(out[i].pitch == batch[i].pitch);
+  REQUIRE(queue->getNumDropped() == 0);
+}
+
+TEST_CASE("OverflowIsCountedNotSilent", "[GrainVisQueueTest]") {
+  auto queue = std::make_unique<GrainVisQueue>();
+  const auto batch = makeRecords(GrainVisQueue::kCapacity, 0.0f);
+  // An AbstractFifo holds one record less than its size.
+  const int fits = GrainVisQueue::kCapacity - 1;
+  REQUIRE(queue->push(batch.data(), GrainVisQueue::kCapacity) == fits);
+  REQUIRE(queue->push(batch.data(), 10) == 0);
+  REQUIRE(queue->getNumDropped() == 11);
+
+  std::vector<GrainInfoForVis> out;
+  REQUIRE(queue->drain(out) == fits);
+  REQUIRE(out.back().pitch == static_cast<float>(fits - 1));
+  queue->resetDropped();
+  REQUIRE(queue->getNumDropped() == 0);
+}
+
+TEST_CASE("EngineQueuesEverySpawnedGrain", "[GrainVisQueueTest]") {
+  auto queue = std::make_unique<GrainVisQueue>();
+  RenderTelemetry telemetry;
+  AudioEngine engine({}, queue.get());
+  engine.setTelemetry(&telemetry);
+  engine.getStochasticModel()->setGlobalDensity(1000.0f);
+  engine.prepareToPlay(48000.0, 480);
+  juce::AudioBuffer<float> buffer(2, 480);
+  juce::MidiBuffer midi;
+  juce::AudioPlayHead::PositionInfo pos;
+
+  std::vector<GrainInfoForVis> out;
+  int drained = 0;
+  for (int block = 0; block < 100; ++block) {
+    engine.processBlock(buffer, midi, pos);
+    if (block % 10 == 9)  // The GUI drains far less often than blocks run.
+      drained += queue->drain(out);
+  }
+  REQUIRE(drained > 500);
+  REQUIRE(queue->getNumDropped() == 0);
+  for (const auto& info : out)
+    REQUIRE(info.durationSeconds > 0.0f);
+
+  if constexpr (RenderTelemetry::kEnabled) {
+    std::vector<RenderTelemetry::BlockStats> history;
+    telemetry.drain(history, 1000);
+    int spawned = 0;
+    for (const auto& stats : history)
+      spawned += stats.grainsSpawned;
+    REQUIRE(drained == spawned);
+  }
+}
@@ -1,6 +1,10 @@
 #include "Pointilsynth/InertialHistoryManager.h"
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/catch_approx.hpp>
+#include "RealtimeSafety.h"
+
+#include <atomic>
+#include <thread>
 
 TEST_CASE("DecaysAndRemovesNotes", "[InertialHistoryManagerTest]") {
   InertialHistoryManager manager;
@@ -37,3 +41,120 @@ TEST_CASE("ModulationValueOscillatesAndDecays",
   float final = manager.getModulationValue();
   REQUIRE(final == Catch::Approx(0.0f).margin(1e-5f));
 }
+
+TEST_CASE("HistoryIsBoundedAndDropsOldestNote",
+          "[InertialHistoryManagerTest]") {
+  InertialHistoryManager manager;
+  for (size_t i = 0; i < InertialHistoryManager::kMaxNotes + 1; ++i)
+    manager.addNote(static_cast<int>(i % 128), 1.0f, static_cast<double>(i));
+
+  REQUIRE(manager.getNumNotes() == InertialHistoryManager::kMaxNotes);
+  REQUIRE(manager.getNote(0).startPpq == Catch::Approx(1.0));
+}
+
+TEST_CASE("FullHistoryForgetsTheWeakestNote",
+          "[InertialHistoryManagerTest]") {
+  InertialHistoryManager manager;
+  for (size_t i = 0; i < InertialHistoryManager::kMaxNotes; ++i)
+    manager.addNote(60, i == 5 ? 0.2f : 1.0f, 0.0);
+  manager.update(2.0, 4.0);
+  manager.addNote(72, 0.3f, 2.0);
+
+  REQUIRE(manager.getNumNotes() == InertialHistoryManager::kMaxNotes);
+  for (size_t i = 0; i + 1 < manager.getNumNotes(); ++i)
+    REQUIRE(manager.getNote(i).initialInfluence == 1.0f);
+  REQUIRE(manager.getNote(manager.getNumNotes() - 1).noteNumber == 72);
+}
+
+TEST_CASE("IncrementalUpdatesMatchTheClosedForm",
+          "[InertialHistoryManagerTest]") {
+  InertialHistoryManager incremental;
+  incremental.addNote(60, 1.0f, 0.0);
+  incremental.addNote(67, 0.6f, 0.7);
+  double ppq = 0.0;
+  for (int block = 0; block < 2000; ++block) {
+    ppq += 0.005;  // A 64-sample sub-block at 120 BPM and 48 kHz is 0.0027.
+    if (block == 300)
+      incremental.addNote(64, 0.8f, ppq);
+    incremental.update(ppq, 4.0);
+  }
+
+  InertialHistoryManager exact;
+  exact.addNote(60, 1.0f, 0.0);
+  exact.addNote(67, 0.6f, 0.7);
+  exact.addNote(64, 0.8f, 0.005 * 301);
+  exact.update(ppq, 4.0);
+
+  REQUIRE(incremental.getNumNotes() == exact.getNumNotes());
+  for (size_t i = 0; i < exact.getNumNotes(); ++i) {
+    REQUIRE(incremental.getNote(i).currentInfluence ==
+            Catch::Approx(exact.getNote(i).currentInfluence).margin(1e-4f));
+    REQUIRE(incremental.getNote(i).ageInBars ==
+            Catch::Approx(exact.getNote(i).ageInBars).margin(1e-9));
+  }
+  REQUIRE(incremental.getModulationValue() ==
+          Catch::Approx(exact.getModulationValue()).margin(1e-3f));
+
+  // A jump back in time re-evaluates every note from its start.
+  incremental.update(1.0, 4.0);
+  REQUIRE(incremental.getNote(0).currentInfluence ==
+          Catch::Approx(0.8409f).margin(1e-4f));
+}
+
+TEST_CASE("SnapshotsCarryTheNotesAsPublished",
+          "[InertialHistoryManagerTest]") {
+  InertialHistoryManager manager;
+  REQUIRE(manager.acquireSnapshot() == nullptr);
+
+  manager.addNote(60, 1.0f, 0.0);
+  manager.addNote(64, 0.5f, 2.0);
+  manager.update(4.0, 4.0);
+  REQUIRE_REALTIME_SAFE(manager.publishSnapshot());
+
+  const auto* snapshot = manager.acquireSnapshot();
+  REQUIRE(snapshot != nullptr);
+  REQUIRE(snapshot->numNotes == 2u);
+  REQUIRE(snapshot->notes[0].noteNumber == 60);
+  REQUIRE(snapshot->notes[1].currentInfluence ==
+          Catch::Approx(0.5f * 0.7071f).margin(1e-4f));
+  REQUIRE(manager.acquireSnapshot() == nullptr);
+
+  // Later changes reach the reader only through the next snapshot.
+  manager.update(16.0, 4.0);
+  REQUIRE(snapshot->numNotes == 2u);
+  manager.publishSnapshot();
+  REQUIRE(manager.acquireSnapshot()->numNotes == 0u);
+}
+
+TEST_CASE("SnapshotsStayConsistentUnderConcurrentNotes",
+          "[InertialHistoryManagerTest]") {
+  InertialHistoryManager manager;
+  std::atomic<bool> done{false};
+  std::thread audio([&] {
+    // Far more notes than fit, at a rate no player could reach.
+    for (int block = 0; block < 20000; ++block) {
+      const double ppq = 0.01 * static_cast<double>(block);
+      for (int n = 0; n < 4; ++n)
+        manager.addNote((block * 4 + n) % 128, 1.0f, ppq);
+      manager.update(ppq, 4.0);
+      manager.publishSnapshot();
+    }
+    done = true;
+  });
+
+  int numSnapshots = 0;
+  bool ordered = true;
+  while (!done.load()) {
+    const auto* snapshot = manager.acquireSnapshot();
+    if (snapshot == nullptr)
+      continue;
+    ++numSnapshots;
+    REQUIRE(snapshot->numNotes <= InertialHistoryManager::kMaxNotes);
+    for (size_t i = 1; i < snapshot->numNotes; ++i)
+      ordered = ordered && snapshot->notes[i - 1].startPpq <=
+                               snapshot->notes[i].startPpq;
+  }
+  audio.join();
+  REQUIRE(numSnapshots > 0);
+  REQUIRE(ordered);
+}
@@ -0,0 +1,175 @@
+#include "Pointilsynth/ModulationMatrix.h"
+#include "Pointilsynth/PointilismInterfaces.h"
+#include "RealtimeSafety.h"
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include <initializer_list>
+#include <memory>
+
+using Catch::Approx;
+
+namespace {
+float offset(const ModulationMatrix& matrix,
+             ModulationMatrix::Destination destination) {
+  return matrix.getOffsets()[static_cast<size_t>(destination)];
+}
+}  // namespace
+
+TEST_CASE("RoutesSumSourcesIntoDestinations", "[ModulationMatrixTest]") {
+  using Source = ModulationMatrix::Source;
+  using Destination = ModulationMatrix::Destination;
+  ModulationMatrix matrix;
+  matrix.setLfo(0, {1.0f, ModulationMatrix::LfoShape::Sine});
+  matrix.setLfo(1, {2.0f, ModulationMatrix::LfoShape::Saw});
+  REQUIRE(matrix.addRoute(Source::Lfo1, Destination::Pitch, 12.0f));
+  REQUIRE(matrix.addRoute(Source::Inertia, Destination::Pitch, 2.0f));
+  REQUIRE(matrix.addRoute(Source::Lfo2, Destination::Pan, 0.5f));
+  matrix.prepare(1000.0);
+
+  // Sources are evaluated at the start of each sub-block.
+  REQUIRE_REALTIME_SAFE(matrix.process(250, 0.5f));
+  REQUIRE(offset(matrix, Destination::Pitch) == Approx(1.0f).margin(1e-5f));
+  REQUIRE(offset(matrix, Destination::Pan) == Approx(-0.5f));
+  REQUIRE(offset(matrix, Destination::Density) == 0.0f);
+
+  matrix.process(250, 3.0f);  // Inertia is clamped to 1.
+  REQUIRE(matrix.getSourceValue(Source::Lfo1) == Approx(1.0f));
+  REQUIRE(offset(matrix, Destination::Pitch) == Approx(14.0f));
+  REQUIRE(offset(matrix, Destination::Pan) == Approx(0.0f).margin(1e-5f));
+  REQUIRE(matrix.isRouted(Source::Inertia));
+  REQUIRE_FALSE(matrix.isRouted(Source::Envelope));
+
+  matrix.clearRoutes();
+  matrix.process(250, 0.0f);
+  REQUIRE(offset(matrix, Destination::Pitch) == 0.0f);
+
+  for (int i = 0; i < ModulationMatrix::kMaxRoutes; ++i)
+    REQUIRE(matrix.addRoute(Source::Lfo1, Destination::Duration, 0.1f));
+  REQUIRE_FALSE(matrix.addRoute(Source::Lfo1, Destination::Duration, 0.1f));
+}
+
+TEST_CASE("EnvelopeFollowsHeldNotes", "[ModulationMatrixTest]") {
+  ModulationMatrix matrix;
+  matrix.setEnvelope({10.0f, 20.0f, 0.5f, 40.0f});  // 10, 20, 40 samples
+  matrix.prepare(1000.0);
+  auto envelope = [&matrix](int numSamples) {
+    matrix.process(numSamples, 0.0f);
+    return matrix.getSourceValue(ModulationMatrix::Source::Envelope);
+  };
+
+  REQUIRE(envelope(5) == 0.0f);
+  matrix.noteOn(0.8f);
+  REQUIRE(envelope(5) == 0.0f);
+  REQUIRE(envelope(5) == Approx(0.4f));  // Half way up
+  REQUIRE(envelope(10) == Approx(0.8f));  // Peak
+  REQUIRE(envelope(20) == Approx(0.6f));  // Half way down to sustain
+  REQUIRE(envelope(100) == Approx(0.4f));  // Sustain
+
+  // A retrigger restarts the attack from the current level; one release
+  // ends it.
+  matrix.noteOn(0.8f);
+  REQUIRE(envelope(100) == Approx(0.4f));
+  matrix.noteOff();
+  REQUIRE(envelope(20) == Approx(0.4f));
+  REQUIRE(envelope(20) == Approx(0.2f));
+  matrix.noteOff();  // A second release does not restart the ramp.
+  REQUIRE(envelope(20) == Approx(0.0f).margin(1e-6f));
+  matrix.noteOff();
+  REQUIRE(envelope(20) == 0.0f);
+}
+
+TEST_CASE("EnvelopeFollowsTheHeldVoices", "[ModulationMatrixTest]") {
+  AudioEngine engine;
+  engine.getStochasticModel()->setGlobalNumVoices(4);
+  engine.getModulationMatrix().setEnvelope({1.0f, 1.0f, 0.5f, 10.0f});
+  engine.prepareToPlay(48000.0, 480);
+
+  juce::AudioBuffer<float> buffer(2, 480);
+  juce::MidiBuffer midi;
+  juce::AudioPlayHead::PositionInfo pos;
+  auto envelopeAfter = [&](std::initializer_list<int> notes, bool isNoteOn) {
+    for (int note : notes)
+      midi.addEvent(isNoteOn ? juce::MidiMessage::noteOn(1, note, 1.0f)
+                             : juce::MidiMessage::noteOff(1, note),
+                    0);
+    for (int block = 0; block < 40; ++block) {
+      engine.processBlock(buffer, midi, pos);
+      midi.clear();
+    }
+    return engine.getModulationMatrix().getSourceValue(
+        ModulationMatrix::Source::Envelope);
+  };
+
+  REQUIRE(envelopeAfter({60, 64}, true) == Approx(0.5f));
+  // A note off for a note that is not held releases nothing.
+  REQUIRE(envelopeAfter({70}, false) == Approx(0.5f));
+  REQUIRE(envelopeAfter({60}, false) == Approx(0.5f));
+  // Nor does a repeated note on for a held note need a second note off.
+  REQUIRE(envelopeAfter({64}, true) == Approx(0.5f));
+  REQUIRE(envelopeAfter({64}, false) == 0.0f);
+}
+
+TEST_CASE("ModulationShiftsNewGrains", "[ModulationMatrixTest]") {
+  StochasticModel model;
+  model.setSampleRate(48000.0);
+  model.setRandomSeed(1);
+  model.setPitchAndDispersion(60.0f, 0.001f);
+  model.setPanAndSpread(0.0f, 0.001f);
+  model.setDurationAndVariation(100.0f, 0.0f);
+  model.setGlobalDensity(20.0f);
+
+  ModulationMatrix::Offsets offsets{};
+  offsets[static_cast<size_t>(ModulationMatrix::Destination::Pitch)] = 12.0f;
+  offsets[static_cast<size_t>(ModulationMatrix::Destination::Pan)] = -0.5f;
+  offsets[static_cast<size_t>(ModulationMatrix::Destination::Density)] = 1.0f;
+  offsets[static_cast<size_t>(ModulationMatrix::Destination::Duration)] = -1.0f;
+  model.setModulation(offsets);
+
+  Grain grain;
+  model.generateNewGrain(grain);
+  REQUIRE(grain.pitch == Approx(72.0f).margin(0.01f));
+  REQUIRE(grain.pan == Approx(-0.5f).margin(0.01f));
+  REQUIRE(grain.durationInSamples == 2400);
+  REQUIRE(model.getSmoothedDensity() == Approx(40.0f));
+
+  model.setModulation({});
+  model.generateNewGrain(grain);
+  REQUIRE(grain.pitch == Approx(60.0f).margin(0.01f));
+  REQUIRE(model.getSmoothedDensity() == Approx(20.0f));
+}
+
+TEST_CASE("EngineRoutesTheEnvelopeToGrainPitch", "[ModulationMatrixTest]") {
+  AudioEngine engine;
+  auto* model = engine.getStochasticModel();
+  model->setPitchAndDispersion(48.0f, 0.001f);
+  model->setGlobalDensity(2000.0f);
+  auto& matrix = engine.getModulationMatrix();
+  matrix.setEnvelope({1.0f, 1.0f, 1.0f, 1.0f});
+  matrix.addRoute(ModulationMatrix::Source::Envelope,
+                  ModulationMatrix::Destination::Pitch, 24.0f);
+  engine.prepareToPlay(48000.0, 512);
+
+  auto snapshots = std::make_unique<GrainSnapshotBuffer>();
+  snapshots->setEnabled(true);
+  engine.setGrainSnapshots(snapshots.get());
+  juce::AudioBuffer<float> buffer(2, 512);
+  juce::MidiBuffer midi;
+  juce::AudioPlayHead::PositionInfo pos;
+  auto highestPitch = [&] {
+    buffer.clear();
+    engine.processBlock(buffer, midi, pos);
+    const auto* snapshot = snapshots->acquire();
+    float highest = 0.0f;
+    for (int i = 0; i < snapshot->numGrains; ++i)
+      highest =
+          std::max(highest, snapshot->grains[static_cast<size_t>(i)].pitch);
+    return highest;
+  };
+
+  REQUIRE(highestPitch() < 49.0f);
+  midi.addEvent(juce::MidiMessage::noteOn(1, 60, 1.0f), 0);
+  highestPitch();
+  midi.clear();
+  REQUIRE(highestPitch() > 71.0f);
+}
@@ -0,0 +1,131 @@
+#include "Pointilsynth/PerfCounters.h"
+#include "Pointilsynth/PointilismInterfaces.h"
+#include "Pointilsynth/RenderTelemetry.h"
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+namespace {
+PerfCounters::Counts makeCounts(uint64_t cycles, uint64_t instructions) {
+  PerfCounters::Counts counts;
+  counts.values[PerfCounters::kCycles] = cycles;
+  counts.values[PerfCounters::kInstructions] = instructions;
+  return counts;
+}
+}  // namespace
+
+TEST_CASE("CountsSubtractAndAccumulate", "[PerfCountersTest]") {
+  auto total = makeCounts(100, 250) - makeCounts(40, 50);
+  REQUIRE(total[PerfCounters::kCycles] == 60);
+  REQUIRE(total[PerfCounters::kInstructions] == 200);
+  total += makeCounts(1, 2);
+  REQUIRE(total[PerfCounters::kCycles] == 61);
+  REQUIRE(total[PerfCounters::kInstructions] == 202);
+  // A counter that went missing between reads never wraps around.
+  REQUIRE((makeCounts(0, 0) - makeCounts(5, 5))[PerfCounters::kCycles] == 0);
+}
+
+TEST_CASE("MultiplexedCountsAreIncomplete", "[PerfCountersTest]") {
+  auto reading = [](uint64_t enabled, uint64_t running) {
+    auto counts = makeCounts(enabled, enabled);
+    counts.timeEnabled = enabled;
+    counts.timeRunning = running;
+    return counts;
+  };
+  REQUIRE_FALSE(PerfCounters::Counts{}.isComplete());
+  REQUIRE((reading(300, 300) - reading(100, 100)).isComplete());
+
+  // Multiplexed out for part of the interval, or never scheduled at all.
+  const auto partial = reading(300, 250) - reading(100, 100);
+  REQUIRE(partial.timeEnabled == 200);
+  REQUIRE(partial.timeRunning == 150);
+  REQUIRE_FALSE(partial.isComplete());
+  REQUIRE_FALSE((reading(300, 0) - reading(100, 0)).isComplete());
+
+  // A sum is complete only if every part was.
+  auto total = reading(200, 200) - reading(100, 100);
+  total += partial;
+  REQUIRE_FALSE(total.isComplete());
+}
+
+TEST_CASE("SummaryAveragesCountedBlocksPerStage", "[PerfCountersTest]") {
+  std::vector<RenderTelemetry::BlockStats> blocks(3);
+  for (auto& block : blocks)
+    block.budgetMicroseconds = 1000.0f;
+  blocks[1].hasPerfCounts = true;
+  blocks[1].stageCounts[RenderTelemetry::kRenderStage] = makeCounts(300, 600);
+  blocks[1].stageCounts[RenderTelemetry::kControlStage] = makeCounts(100, 100);
+  blocks[2].hasPerfCounts = true;
+  blocks[2].stageCounts[RenderTelemetry::kRenderStage] = makeCounts(500, 800);
+
+  const auto summary = RenderTelemetry::summarise(blocks);
+  REQUIRE(summary.numPerfBlocks == 2);
+  REQUIRE(summary.perfPerBlock[RenderTelemetry::kRenderStage]
+                              [PerfCounters::kCycles] == Catch::Approx(400.0));
+  REQUIRE(summary.perfPerBlock[RenderTelemetry::kControlStage]
+                              [PerfCounters::kCycles] == Catch::Approx(50.0));
+  REQUIRE(summary.getPerfTotal(PerfCounters::kCycles) == Catch::Approx(450.0));
+  REQUIRE(summary.getPerfTotal(PerfCounters::kInstructions) ==
+          Catch::Approx(750.0));
+}
+
+TEST_CASE("CountersMeasureTheCallingThread", "[PerfCountersTest]") {
+  PerfCounters counters;
+  if (!counters.open())
+    SKIP("Hardware counters are not available here");
+
+  REQUIRE(counters.isOpen());
+  REQUIRE(counters.isCounting(PerfCounters::kCycles));
+  const auto before = counters.read();
+  volatile float sum = 0.0f;
+  for (int i = 0; i < 100000; ++i)
+    sum = sum + static_cast<float>(i);
+  const auto elapsed = counters.read() - before;
+  REQUIRE(elapsed[PerfCounters::kCycles] > 0);
+  REQUIRE(elapsed.timeEnabled > 0);
+  REQUIRE(elapsed.timeRunning <= elapsed.timeEnabled);
+  if (counters.isCounting(PerfCounters::kInstructions))
+    REQUIRE(elapsed[PerfCounters::kInstructions] > 100000);
+
+  counters.close();
+  REQUIRE_FALSE(counters.isOpen());
+  REQUIRE(counters.read()[PerfCounters::kCycles] == 0);
+}
+
+TEST_CASE("EngineCountsEachStageOnRequest", "[PerfCountersTest]") {
+  if constexpr (!RenderTelemetry::kEnabled)
+    SKIP("Render telemetry is compiled out");
+
+  RenderTelemetry telemetry;
+  AudioEngine engine;
+  engine.setTelemetry(&telemetry);
+  engine.getStochasticModel()->setGlobalDensity(200.0f);
+  engine.prepareToPlay(48000.0, 480);
+  juce::AudioBuffer<float> buffer(2, 480);
+  juce::MidiBuffer midi;
+  juce::AudioPlayHead::PositionInfo pos;
+
+  telemetry.setPerfCountersRequested(true);
+  for (int block = 0; block < 10; ++block)
+    engine.processBlock(buffer, midi, pos);
+  std::vector<RenderTelemetry::BlockStats> history;
+  telemetry.drain(history, 100);
+  if (telemetry.getPerfState() == RenderTelemetry::PerfState::Unavailable) {
+    for (const auto& block : history)
+      REQUIRE_FALSE(block.hasPerfCounts);
+    SKIP("Hardware counters are not available here");
+  }
+
+  REQUIRE(telemetry.getPerfState() == RenderTelemetry::PerfState::Counting);
+  const auto summary = RenderTelemetry::summarise(history);
+  REQUIRE(summary.numPerfBlocks == 10);
+  for (int stage = 0; stage < RenderTelemetry::kNumStages; ++stage)
+    REQUIRE(summary.perfPerBlock[static_cast<size_t>(stage)]
+                                [PerfCounters::kCycles] > 0.0);
+
+  telemetry.setPerfCountersRequested(false);
+  engine.processBlock(buffer, midi, pos);
+  history.clear();
+  telemetry.drain(history, 100);
+  REQUIRE(telemetry.getPerfState() == RenderTelemetry::PerfState::Off);
+  REQUIRE_FALSE(history.back().hasPerfCounts);
+}
@@ -14,8 +14,8 @@ struct JuceGuiTestFixture {
 class PluginEditorTest : public JuceGuiTestFixture {
 protected:
   AudioPluginAudioProcessor processor;  // Create a processor instance
-  juce::AbstractFifo fifo{8};
-  std::array<GrainInfoForVis, 8> buffer{};
+  GrainVisQueue visQueue;
+  GrainDensityGrid densityGrid;
 
 public:
   PluginEditorTest() = default;  // processor is default constructed
@@ -23,6 +23,6 @@ public:
 
 TEST_CASE_METHOD(PluginEditorTest, "CanConstruct", "[PluginEditorTest]") {
   REQUIRE_NOTHROW(std::make_unique<PointillisticSynthAudioProcessorEditor>(
-      processor, fifo, buffer.data()));
+      processor, visQueue, densityGrid));
 }
 }  // namespace audio_plugin
@@ -1,4 +1,5 @@
 #include "Pointilsynth/PluginProcessor.h"  // Defines audio_plugin::AudioPluginAudioProcessor
+#include "RealtimeSafety.h"
 #include <catch2/catch_test_macros.hpp>
 #include <juce_gui_basics/juce_gui_basics.h>  // For ScopedJuceInitialiser_GUI, as PluginProcessor creates an Editor
 
@@ -19,4 +20,23 @@ TEST_CASE_METHOD(ProcessorTestFixture,
   REQUIRE_NOTHROW(std::make_unique<AudioPluginAudioProcessor>());
 }
 
+TEST_CASE_METHOD(ProcessorTestFixture,
+                 "ProcessBlockIsRealtimeSafe",
+                 "[ProcessorTestFixture]") {
+  AudioPluginAudioProcessor processor;
+  processor.prepareToPlay(48000.0, 256);
+  juce::AudioBuffer<float> buffer(2, 256);
+  juce::MidiBuffer midi;
+  for (int block = 0; block < 10; ++block)
+    processor.processBlock(buffer, midi);
+
+  midi.addEvent(juce::MidiMessage::noteOn(1, 64, 0.5f), 0);
+  midi.addEvent(juce::MidiMessage::noteOff(1, 64), 128);
+  REQUIRE_REALTIME_SAFE({
+    for (int block = 0; block < 10; ++block)
+      processor.processBlock(buffer, midi);
+  });
+  processor.releaseResources();
+}
+
 }  // namespace audio_plugin
@@ -14,3 +14,16 @@ TEST_CASE("CanConstructStochasticModel", "[PointilismInterfacesTest]") {
 TEST_CASE("CanConstructAudioEngine", "[PointilismInterfacesTest]") {
   REQUIRE_NOTHROW(std::make_unique<AudioEngine>());
 }
+
+TEST_CASE("DensityRampsAcrossSmoothingWindow", "[PointilismInterfacesTest]") {
+  StochasticModel model;
+  model.setSampleRate(1000.0);  // 50 ms ramp == 50 samples
+  model.setGlobalDensity(20.0f);
+  model.pollParameters();
+
+  REQUIRE(juce::approximatelyEqual(model.getSmoothedDensity(), 10.0f));
+  model.advanceSmoothing(25);
+  REQUIRE(juce::approximatelyEqual(model.getSmoothedDensity(), 15.0f));
+  model.advanceSmoothing(25);
+  REQUIRE(juce::approximatelyEqual(model.getSmoothedDensity(), 20.0f));
+}
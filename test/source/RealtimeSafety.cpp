@@ -0,0 +1,388 @@
+#include "RealtimeSafety.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#define REALTIME_SAFETY_SANITIZED 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer) || \
+    __has_feature(memory_sanitizer)
+#define REALTIME_SAFETY_SANITIZED 1
+#endif
+#endif
+
+// Sanitizers intercept malloc and pthread themselves, so only the operator
+// new/delete hooks are installed in those builds.
+#if defined(__linux__) && defined(__GLIBC__) && \
+    !defined(REALTIME_SAFETY_SANITIZED)
+#define REALTIME_SAFETY_INTERPOSE_LIBC 1
+#include <dlfcn.h>
+#include <pthread.h>
+#include <cerrno>
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+}
+#else
+#define REALTIME_SAFETY_INTERPOSE_LIBC 0
+#endif
+
+#if __has_include(<execinfo.h>) && __has_include(<cxxabi.h>)
+#define REALTIME_SAFETY_HAS_BACKTRACE 1
+#include <cxxabi.h>
+#include <execinfo.h>
+#else
+#define REALTIME_SAFETY_HAS_BACKTRACE 0
+#endif
+
+namespace RealtimeSafety {
+namespace {
+// Plain thread-locals with constant initialisation: reading them never
+// allocates, so they are safe to touch from inside malloc.
+thread_local int audioScopeDepth = 0;
+thread_local int allowDepth = 0;
+
+std::array<Violation, kMaxViolations> recorded;
+std::atomic<int> numRecorded{0};
+
+void record(Violation::Kind kind, size_t size) {
+  if (audioScopeDepth == 0 || allowDepth > 0)
+    return;
+
+  // Capturing the stack may itself allocate or lock; don't record that.
+  ++allowDepth;
+  const int slot = numRecorded.fetch_add(1);
+  if (slot < kMaxViolations) {
+    auto& violation = recorded[static_cast<size_t>(slot)];
+    violation.kind = kind;
+    violation.size = size;
+#if REALTIME_SAFETY_HAS_BACKTRACE
+    violation.numFrames =
+        backtrace(violation.frames.data(), Violation::kMaxFrames);
+#else
+    violation.numFrames = 0;
+#endif
+  }
+  --allowDepth;
+}
+
+void* rawMalloc(size_t size) {
+#if REALTIME_SAFETY_INTERPOSE_LIBC
+  return __libc_malloc(size);
+#else
+  return std::malloc(size);
+#endif
+}
+
+void rawFree(void* ptr) {
+#if REALTIME_SAFETY_INTERPOSE_LIBC
+  __libc_free(ptr);
+#else
+  std::free(ptr);
+#endif
+}
+
+void* rawAlignedMalloc(size_t size, size_t alignment) {
+#if REALTIME_SAFETY_INTERPOSE_LIBC
+  return __libc_memalign(alignment, size);
+#elif defined(_MSC_VER)
+  return _aligned_malloc(size, alignment);
+#else
+  // aligned_alloc wants the size to be a multiple of the alignment.
+  return std::aligned_alloc(alignment,
+                            (size + alignment - 1) / alignment * alignment);
+#endif
+}
+
+void rawAlignedFree(void* ptr) {
+#if defined(_MSC_VER)
+  _aligned_free(ptr);
+#else
+  rawFree(ptr);
+#endif
+}
+
+void* allocate(size_t size) {
+  record(Violation::Kind::Allocation, size);
+  if (auto* ptr = rawMalloc(size == 0 ? 1 : size))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void* allocateAligned(size_t size, std::align_val_t alignment) {
+  record(Violation::Kind::Allocation, size);
+  if (auto* ptr = rawAlignedMalloc(size == 0 ? 1 : size,
+                                   static_cast<size_t>(alignment)))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void deallocate(void* ptr) {
+  if (ptr != nullptr)
+    record(Violation::Kind::Deallocation, 0);
+  rawFree(ptr);
+}
+
+void deallocateAligned(void* ptr) {
+  if (ptr != nullptr)
+    record(Violation::Kind::Deallocation, 0);
+  rawAlignedFree(ptr);
+}
+
+const char* describeKind(Violation::Kind kind) {
+  switch (kind) {
+    case Violation::Kind::Allocation:
+      return "heap allocation";
+    case Violation::Kind::Deallocation:
+      return "heap deallocation";
+    case Violation::Kind::MutexLock:
+      return "mutex lock";
+  }
+  return "unknown";
+}
+
+#if REALTIME_SAFETY_HAS_BACKTRACE
+// backtrace_symbols gives "binary(mangled+0x1f) [0x...]"; demangle the
+// symbol part when there is one.
+std::string demangleFrame(const std::string& frame) {
+  const auto open = frame.find('(');
+  const auto plus = frame.find('+', open);
+  if (open == std::string::npos || plus == std::string::npos ||
+      plus == open + 1)
+    return frame;
+  const auto mangled = frame.substr(open + 1, plus - open - 1);
+  int status = 0;
+  char* demangled =
+      abi::__cxa_demangle(mangled.c_str(), nullptr, nullptr, &status);
+  if (status != 0 || demangled == nullptr)
+    return frame;
+  std::string result =
+      frame.substr(0, open + 1) + demangled + frame.substr(plus);
+  std::free(demangled);
+  return result;
+}
+#endif
+}  // namespace
+
+ScopedAudioThread::ScopedAudioThread() {
+  ++audioScopeDepth;
+}
+
+ScopedAudioThread::~ScopedAudioThread() {
+  --audioScopeDepth;
+}
+
+ScopedAllow::ScopedAllow() {
+  ++allowDepth;
+}
+
+ScopedAllow::~ScopedAllow() {
+  --allowDepth;
+}
+
+Report run(const std::function<void()>& fn) {
+#if REALTIME_SAFETY_HAS_BACKTRACE
+  // The first backtrace() call loads the unwinder, which allocates. Do it
+  // here rather than on the first violation.
+  static const bool unwinderLoaded = [] {
+    std::array<void*, 1> frame{};
+    return backtrace(frame.data(), 1) >= 0;
+  }();
+  (void)unwinderLoaded;
+#endif
+
+  numRecorded.store(0);
+  {
+    ScopedAudioThread scope;
+    fn();
+  }
+
+  Report report;
+  report.numViolations = numRecorded.load();
+  const int numKept = std::min(report.numViolations, kMaxViolations);
+  report.violations.assign(recorded.begin(), recorded.begin() + numKept);
+  return report;
+}
+
+std::string Report::describe() const {
+  if (isClean())
+    return "No real-time safety violations";
+
+  std::ostringstream text;
+  text << numViolations << " real-time safety violation(s) on the audio "
+       << "thread";
+  if (numViolations > static_cast<int>(violations.size()))
+    text << " (showing the first " << violations.size() << ")";
+  text << ":\n";
+
+  int index = 1;
+  for (const auto& violation : violations) {
+    text << "#" << index++ << " " << describeKind(violation.kind);
+    if (violation.kind == Violation::Kind::Allocation)
+      text << " of " << violation.size << " bytes";
+    text << "\n";
+#if REALTIME_SAFETY_HAS_BACKTRACE
+    if (char** symbols =
+            backtrace_symbols(violation.frames.data(), violation.numFrames)) {
+      // Frame 0 is record() itself.
+      for (int frame = 1; frame < violation.numFrames; ++frame)
+        text << "    " << demangleFrame(symbols[frame]) << "\n";
+      std::free(symbols);
+    }
+#endif
+  }
+  return text.str();
+}
+
+bool canDetectLibcCalls() {
+  return REALTIME_SAFETY_INTERPOSE_LIBC != 0;
+}
+}  // namespace RealtimeSafety
+
+// Replaceable global allocation functions. The unsized, sized and nothrow
+// forms all funnel into the same hooks.
+void* operator new(std::size_t size) {
+  return RealtimeSafety::allocate(size);
+}
+
+void* operator new[](std::size_t size) {
+  return RealtimeSafety::allocate(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return RealtimeSafety::allocate(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return RealtimeSafety::allocate(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  return RealtimeSafety::allocateAligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+  return RealtimeSafety::allocateAligned(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept {
+  RealtimeSafety::deallocate(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  RealtimeSafety::deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  RealtimeSafety::deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+  RealtimeSafety::deallocate(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+  RealtimeSafety::deallocate(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+  RealtimeSafety::deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+  RealtimeSafety::deallocateAligned(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+  RealtimeSafety::deallocateAligned(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+  RealtimeSafety::deallocateAligned(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept {
+  RealtimeSafety::deallocateAligned(ptr);
+}
+
+#if REALTIME_SAFETY_INTERPOSE_LIBC
+// Definitions in the executable take precedence over libc's for every caller,
+// including shared libraries, so JUCE and the standard library are covered
+// too. glibc exports its implementations under __libc_* names to forward to.
+extern "C" {
+void* malloc(size_t size) noexcept {
+  RealtimeSafety::record(RealtimeSafety::Violation::Kind::Allocation, size);
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+  RealtimeSafety::record(RealtimeSafety::Violation::Kind::Allocation,
+                         count * size);
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) noexcept {
+  RealtimeSafety::record(RealtimeSafety::Violation::Kind::Allocation, size);
+  return __libc_realloc(ptr, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) noexcept {
+  RealtimeSafety::record(RealtimeSafety::Violation::Kind::Allocation, size);
+  return __libc_memalign(alignment, size);
+}
+
+void* memalign(size_t alignment, size_t size) noexcept {
+  RealtimeSafety::record(RealtimeSafety::Violation::Kind::Allocation, size);
+  return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** result, size_t alignment, size_t size) noexcept {
+  if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0)
+    return EINVAL;
+  RealtimeSafety::record(RealtimeSafety::Violation::Kind::Allocation, size);
+  void* ptr = __libc_memalign(alignment, size);
+  if (ptr == nullptr)
+    return ENOMEM;
+  *result = ptr;
+  return 0;
+}
+
+void free(void* ptr) noexcept {
+  if (ptr != nullptr)
+    RealtimeSafety::record(RealtimeSafety::Violation::Kind::Deallocation, 0);
+  __libc_free(ptr);
+}
+
+// pthread_mutex_lock has no public __libc_ alias, so the real one is looked
+// up with dlsym on first use. dlsym takes its own internal locks, which do not
+// go through this function.
+int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept {
+  using LockFunction = int (*)(pthread_mutex_t*);
+  static std::atomic<LockFunction> realLock{nullptr};
+  auto lock = realLock.load(std::memory_order_acquire);
+  if (lock == nullptr) {
+    lock = reinterpret_cast<LockFunction>(
+        dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+    realLock.store(lock, std::memory_order_release);
+  }
+  RealtimeSafety::record(RealtimeSafety::Violation::Kind::MutexLock, 0);
+  return lock(mutex);
+}
+}
+#endif
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * Test-only detector for work that is not allowed on the audio thread.
+ *
+ * RealtimeSafety.cpp replaces the global operator new/delete for the test
+ * executable and, on glibc, interposes malloc, free and pthread_mutex_lock.
+ * Each hook checks a thread-local flag: while a ScopedAudioThread is alive on
+ * the calling thread, every heap allocation, deallocation and mutex lock is
+ * recorded together with the call stack that made it. Outside a scope the
+ * hooks cost one thread-local load and forward to the real implementation.
+ *
+ * Use REQUIRE_REALTIME_SAFE(code) in tests; it runs code inside a scope and
+ * fails with the offending call stacks if anything was recorded.
+ */
+namespace RealtimeSafety {
+
+struct Violation {
+  enum class Kind { Allocation, Deallocation, MutexLock };
+  static constexpr int kMaxFrames = 32;
+
+  Kind kind = Kind::Allocation;
+  size_t size = 0;  // Bytes requested, for allocations.
+  int numFrames = 0;
+  std::array<void*, kMaxFrames> frames{};
+};
+
+struct Report {
+  std::vector<Violation> violations;  // The first kMaxViolations recorded.
+  int numViolations = 0;              // Including any that did not fit.
+
+  bool isClean() const { return numViolations == 0; }
+  /** One line per violation followed by its symbolised call stack. */
+  std::string describe() const;
+};
+
+/** Maximum number of violations kept per run; the rest are only counted. */
+constexpr int kMaxViolations = 16;
+
+/** Marks the calling thread as an audio thread for the scope's lifetime.
+ * Scopes nest. */
+class ScopedAudioThread {
+public:
+  ScopedAudioThread();
+  ~ScopedAudioThread();
+  ScopedAudioThread(const ScopedAudioThread&) = delete;
+  ScopedAudioThread& operator=(const ScopedAudioThread&) = delete;
+};
+
+/** Suspends detection on the calling thread, e.g. for test scaffolding that
+ * has to run inside an audio thread scope. */
+class ScopedAllow {
+public:
+  ScopedAllow();
+  ~ScopedAllow();
+  ScopedAllow(const ScopedAllow&) = delete;
+  ScopedAllow& operator=(const ScopedAllow&) = delete;
+};
+
+/** Runs fn inside a ScopedAudioThread and returns what it did wrong. */
+Report run(const std::function<void()>& fn);
+
+/** False where malloc and pthread_mutex_lock cannot be interposed (non-glibc
+ * platforms and sanitizer builds); only operator new/delete are checked. */
+bool canDetectLibcCalls();
+
+}  // namespace RealtimeSafety
+
+#define REALTIME_SAFE_IMPL_(macro, ...)                                     \
+  do {                                                                      \
+    const auto realtimeSafetyReport_ =                                      \
+        RealtimeSafety::run([&] { __VA_ARGS__; });                          \
+    INFO(realtimeSafetyReport_.describe());                                 \
+    macro(realtimeSafetyReport_.isClean());                                 \
+  } while (false)
+
+/** Fails the test if the code allocates, frees or locks a mutex. */
+#define REQUIRE_REALTIME_SAFE(...) REALTIME_SAFE_IMPL_(REQUIRE, __VA_ARGS__)
+#define CHECK_REALTIME_SAFE(...) REALTIME_SAFE_IMPL_(CHECK, __VA_ARGS__)
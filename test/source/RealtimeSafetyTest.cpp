@@ -0,0 +1,59 @@
+#include "RealtimeSafety.h"
+#include <catch2/catch_test_macros.hpp>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+
+namespace {
+// Keeps the optimiser from eliding allocations made by the tests.
+void* volatile escapedPointer = nullptr;
+}  // namespace
+
+TEST_CASE("DetectsOperatorNewAndDelete", "[RealtimeSafetyTest]") {
+  const auto report = RealtimeSafety::run([] {
+    auto value = std::make_unique<int>(42);
+    escapedPointer = value.get();
+  });
+  REQUIRE_FALSE(report.isClean());
+  REQUIRE(report.violations.front().kind ==
+          RealtimeSafety::Violation::Kind::Allocation);
+  REQUIRE(report.violations.front().size == sizeof(int));
+  REQUIRE(report.violations.back().kind ==
+          RealtimeSafety::Violation::Kind::Deallocation);
+  REQUIRE(report.describe().find("heap allocation of 4 bytes") !=
+          std::string::npos);
+}
+
+TEST_CASE("DetectsMallocAndMutexLock", "[RealtimeSafetyTest]") {
+  if (!RealtimeSafety::canDetectLibcCalls())
+    SKIP("malloc and pthread are not interposed on this platform");
+
+  const auto allocation = RealtimeSafety::run([] {
+    escapedPointer = std::malloc(16);
+    std::free(escapedPointer);
+  });
+  REQUIRE(allocation.numViolations == 2);
+
+  std::mutex mutex;
+  const auto lock = RealtimeSafety::run([&] {
+    const std::lock_guard<std::mutex> guard(mutex);
+  });
+  REQUIRE(lock.numViolations == 1);
+  REQUIRE(lock.violations.front().kind ==
+          RealtimeSafety::Violation::Kind::MutexLock);
+}
+
+TEST_CASE("CleanCodeAndAllowedScopesPass", "[RealtimeSafetyTest]") {
+  float sum = 0.0f;
+  REQUIRE_REALTIME_SAFE({
+    for (int i = 0; i < 64; ++i)
+      sum += static_cast<float>(i);
+  });
+  REQUIRE(sum > 0.0f);
+
+  REQUIRE_REALTIME_SAFE({
+    const RealtimeSafety::ScopedAllow allow;
+    auto value = std::make_unique<int>(1);
+    escapedPointer = value.get();
+  });
+}
@@ -0,0 +1,438 @@
+#include "ReferenceRender.h"
+
+#include "Pointilsynth/FastMath.h"
+#include "Pointilsynth/PresetManager.h"
+#include "Pointilsynth/Resampler.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace ReferenceRender {
+namespace {
+enum class Source { Sine, Saw, Square, Noise, AudioSample };
+
+Source getSource(const Scenario& scenario) {
+  if (scenario.sample.getNumSamples() > 0)
+    return Source::AudioSample;
+  switch (scenario.waveform) {
+    case 1:
+      return Source::Saw;
+    case 2:
+      return Source::Square;
+    case 3:
+      return Source::Noise;
+    default:
+      return Source::Sine;
+  }
+}
+
+void applyPreset(const Scenario& scenario, StochasticModel& model) {
+  if (!scenario.preset.is_null())
+    Pointilism::PresetManager(model).applyPreset(scenario.preset);
+}
+
+juce::MidiMessage toMessage(const MidiEvent& event) {
+  return event.velocity > 0.0f
+             ? juce::MidiMessage::noteOn(1, event.noteNumber, event.velocity)
+             : juce::MidiMessage::noteOff(1, event.noteNumber);
+}
+
+/** Collects the script's events in [start, start + length) into midi. */
+void collectMidi(const Scenario& scenario,
+                 int start,
+                 int length,
+                 juce::MidiBuffer& midi) {
+  for (const auto& event : scenario.midi) {
+    if (event.samplePosition < start || event.samplePosition >= start + length)
+      continue;
+    midi.addEvent(toMessage(event), event.samplePosition - start);
+  }
+}
+
+//==============================================================================
+// Scalar reference. Each function evaluates one sample of the formula the
+// matching render kernel evaluates for a whole sub-block, including where the
+// kernel restarts its ramps and phases at the start of every sub-block.
+
+float envelopeSample(GrainEnvelope::Shape shape,
+                     int blockStartAge,
+                     int age,
+                     int duration) {
+  if (duration <= 0)
+    return 0.0f;
+  if (shape == GrainEnvelope::Shape::Hann) {
+    const float invDuration = 1.0f / static_cast<float>(duration);
+    const float phase = static_cast<float>(blockStartAge) * invDuration +
+                        invDuration * static_cast<float>(age - blockStartAge);
+    return 0.5f * (1.0f - Pointilsynth::fastCos2Pi(phase));
+  }
+
+  const int rampSamples = GrainEnvelope::trapezoidRampSamples(duration);
+  const int releaseOrigin = duration - rampSamples;
+  if (rampSamples <= 1)
+    return age < releaseOrigin || rampSamples != 1 ? 1.0f : 0.0f;
+
+  const float rampScale = 1.0f / static_cast<float>(rampSamples - 1);
+  if (age < rampSamples)
+    return static_cast<float>(blockStartAge) * rampScale +
+           rampScale * static_cast<float>(age - blockStartAge);
+  if (age < releaseOrigin)
+    return 1.0f;
+  const int releaseStart = std::max(blockStartAge, releaseOrigin);
+  const float start =
+      1.0f - static_cast<float>(releaseStart - releaseOrigin) * rampScale;
+  return start + -rampScale * static_cast<float>(age - releaseStart);
+}
+
+float oscillatorSample(Source source, float phase) {
+  switch (source) {
+    case Source::Saw:
+      return Pointilsynth::Oscillator::saw(phase);
+    case Source::Square:
+      return Pointilsynth::Oscillator::square(phase);
+    default:
+      return Pointilsynth::fastSin2Pi(phase);
+  }
+}
+
+class ReferenceRenderer {
+public:
+  explicit ReferenceRenderer(const Scenario& scenario)
+      : scenario_(scenario), source_(getSource(scenario)) {
+    applyPreset(scenario, model_);
+    model_.setRandomSeed(scenario.seed);
+    model_.setSampleRate(scenario.sampleRate);
+    voices_.reset(model_.getSamplesUntilNextEvent(),
+                  model_.getSmoothedDensity());
+  }
+
+  juce::AudioBuffer<float> render() {
+    juce::AudioBuffer<float> output(scenario_.numChannels,
+                                    scenario_.numSamples);
+    output.clear();
+    const int subBlockSize =
+        juce::jlimit(1, AudioEngine::kMaxSubBlockSize, scenario_.subBlockSize);
+    for (int start = 0; start < scenario_.numSamples;
+         start += scenario_.blockSize) {
+      const int length = std::min(scenario_.blockSize,
+                                  scenario_.numSamples - start);
+      for (int offset = 0; offset < length; offset += subBlockSize)
+        renderSubBlock(output, start + offset,
+                       std::min(subBlockSize, length - offset));
+      for (const auto& grain : grains_) {
+        if (!grain.isAlive)
+          voices_.grainFinished(grain.voice);
+      }
+      voices_.cullSilentVoices();
+      grains_.erase(std::remove_if(grains_.begin(), grains_.end(),
+                                   [](const Grain& g) { return !g.isAlive; }),
+                    grains_.end());
+    }
+    return output;
+  }
+
+private:
+  void renderSubBlock(juce::AudioBuffer<float>& output,
+                      int startSample,
+                      int numSamples) {
+    model_.pollParameters();
+
+    // The spawn schedule, step for step as AudioEngine::renderSubBlock().
+    const float blockDensity = model_.getSmoothedDensity();
+    for (int v = 0; v < VoiceAllocator::kMaxVoices; ++v) {
+      auto& voice = voices_.getVoice(v);
+      if (!voice.isSpawning)
+        continue;
+      int& countdown = voice.samplesUntilNextGrain;
+      if (voice.scheduledDensity > 0.0f && blockDensity > 0.0f &&
+          !juce::exactlyEqual(blockDensity, voice.scheduledDensity) &&
+          countdown > 0 && countdown != INT_MAX) {
+        const double rescaled = static_cast<double>(countdown) *
+                                static_cast<double>(voice.scheduledDensity) /
+                                static_cast<double>(blockDensity);
+        countdown =
+            static_cast<int>(std::min(rescaled, static_cast<double>(INT_MAX)));
+      } else if (countdown == INT_MAX && blockDensity > 0.0f) {
+        countdown = model_.getSamplesUntilNextEvent();
+      }
+      voice.scheduledDensity = blockDensity;
+    }
+
+    // Script events are applied at their sample, before a grain at the same
+    // sample.
+    int rampPosition = 0;
+    for (;;) {
+      const int v = voices_.nextOnset(numSamples);
+      const int onset =
+          v >= 0 ? std::max(0, voices_.getVoice(v).samplesUntilNextGrain)
+                 : INT_MAX;
+      if (nextEvent_ < scenario_.midi.size()) {
+        const auto& event = scenario_.midi[nextEvent_];
+        const int eventOffset = event.samplePosition - startSample;
+        if (eventOffset < numSamples && eventOffset <= onset) {
+          model_.advanceSmoothing(eventOffset - rampPosition);
+          rampPosition = eventOffset;
+          applyEvent(toMessage(event), eventOffset);
+          ++nextEvent_;
+          continue;
+        }
+      }
+      if (v < 0)
+        break;
+
+      auto& voice = voices_.getVoice(v);
+      model_.advanceSmoothing(onset - rampPosition);
+      rampPosition = onset;
+      spawnGrain(onset, v);
+      const int interval = std::max(1, model_.getSamplesUntilNextEvent());
+      voice.samplesUntilNextGrain =
+          interval > INT_MAX - voice.samplesUntilNextGrain
+              ? INT_MAX
+              : voice.samplesUntilNextGrain + interval;
+      voice.scheduledDensity = model_.getSmoothedDensity();
+    }
+    model_.advanceSmoothing(numSamples - rampPosition);
+    for (int v = 0; v < VoiceAllocator::kMaxVoices; ++v) {
+      auto& voice = voices_.getVoice(v);
+      if (voice.isSpawning && voice.samplesUntilNextGrain != INT_MAX)
+        voice.samplesUntilNextGrain -= numSamples;
+    }
+
+    std::vector<float> left(static_cast<size_t>(numSamples), 0.0f);
+    std::vector<float> right(static_cast<size_t>(numSamples), 0.0f);
+    for (auto& grain : grains_) {
+      if (grain.isAlive)
+        renderGrain(grain, left.data(), right.data(), numSamples);
+      grain.startOffset = 0;
+    }
+
+    for (int channel = 0; channel < output.getNumChannels(); ++channel) {
+      for (int i = 0; i < numSamples; ++i) {
+        const auto index = static_cast<size_t>(i);
+        output.setSample(channel, startSample + i,
+                         channel == 0   ? left[index]
+                         : channel == 1 ? right[index]
+                                        : left[index] * 0.5f +
+                                              right[index] * 0.5f);
+      }
+    }
+  }
+
+  void applyEvent(const juce::MidiMessage& message, int offset) {
+    if (message.isNoteOff()) {
+      voices_.noteOff(message.getNoteNumber());
+      return;
+    }
+    const int v =
+        voices_.noteOn(message.getNoteNumber(),
+                       static_cast<float>(message.getVelocity()) / 127.0f,
+                       model_.getGlobalNumVoices());
+    auto& voice = voices_.getVoice(v);
+    if (voice.samplesUntilNextGrain == INT_MAX) {
+      const int interval = model_.getSamplesUntilNextEvent();
+      voice.samplesUntilNextGrain =
+          interval > INT_MAX - offset ? INT_MAX : offset + interval;
+      voice.scheduledDensity = model_.getSmoothedDensity();
+    }
+    const int burst =
+        juce::jlimit(0, AudioEngine::kMaxNoteOnBurst, scenario_.noteOnBurst);
+    for (int i = 0; i < burst; ++i)
+      spawnGrain(offset, v);
+  }
+
+  void spawnGrain(int onset, int voice) {
+    if (grains_.size() >= static_cast<size_t>(AudioEngine::kMaxGrains))
+      return;
+    Grain grain;
+    const auto& spawningVoice = voices_.getVoice(voice);
+    model_.generateNewGrain(grain,
+                            {static_cast<float>(spawningVoice.noteNumber),
+                             spawningVoice.influence});
+    grain.id = nextGrainId_++;
+    grain.voice = voice;
+    grain.isAlive = true;
+    grain.ageInSamples = 0;
+    grain.startOffset = onset;
+
+    const float panAngle =
+        (grain.pan * 0.5f + 0.5f) * (juce::MathConstants<float>::pi * 0.5f);
+    grain.gainLeft = grain.amplitude * std::cos(panAngle);
+    grain.gainRight = grain.amplitude * std::sin(panAngle);
+    const double frequency = juce::MidiMessage::getMidiNoteInHertz(
+        static_cast<int>(std::round(grain.pitch)));
+    grain.phase = 0.0f;
+    grain.phaseIncrement =
+        static_cast<float>(frequency / scenario_.sampleRate);
+    grain.playbackRate =
+        static_cast<double>(std::pow(2.0f, (grain.pitch - 60.0f) / 12.0f));
+    grain.noiseState = (static_cast<uint32_t>(grain.id) * 2654435761u) | 1u;
+    grains_.push_back(grain);
+    voices_.grainStarted(voice);
+  }
+
+  void renderGrain(Grain& grain, float* left, float* right, int numSamples) {
+    const int start = grain.startOffset;
+    const int count = std::min(numSamples - start,
+                               grain.durationInSamples - grain.ageInSamples);
+    if (count > 0) {
+      const int blockStartAge = grain.ageInSamples;
+      const float startPhase = grain.phase;
+      const bool stereo = scenario_.numChannels > 1;
+      for (int i = 0; i < count; ++i) {
+        const float envelope =
+            envelopeSample(scenario_.shape, blockStartAge, blockStartAge + i,
+                           grain.durationInSamples);
+        float source = 0.0f;
+        if (source_ == Source::Noise) {
+          source = Pointilsynth::Oscillator::noise(grain.noiseState);
+        } else if (source_ == Source::AudioSample) {
+          source = Resampler::getSampleInterpolated(
+              scenario_.sample.getReadPointer(0),
+              scenario_.sample.getNumSamples(), grain.sourceSamplePosition,
+              SimdKernels::scalar());
+          grain.sourceSamplePosition += grain.playbackRate;
+        } else {
+          float phase =
+              startPhase + grain.phaseIncrement * static_cast<float>(i);
+          phase -= static_cast<float>(static_cast<int>(phase));
+          source = oscillatorSample(source_, phase);
+        }
+
+        const auto index = static_cast<size_t>(start + i);
+        if (stereo) {
+          const float sample = source * envelope;
+          left[index] += sample * grain.gainLeft;
+          right[index] += sample * grain.gainRight;
+        } else {
+          left[index] += source * envelope * grain.gainLeft;
+        }
+      }
+
+      float endPhase =
+          startPhase + grain.phaseIncrement * static_cast<float>(count);
+      endPhase -= static_cast<float>(static_cast<int>(endPhase));
+      grain.phase = endPhase;
+      grain.ageInSamples += count;
+    }
+    if (grain.ageInSamples >= grain.durationInSamples)
+      grain.isAlive = false;
+  }
+
+  const Scenario& scenario_;
+  const Source source_;
+  StochasticModel model_;
+  std::vector<Grain> grains_;
+  int nextGrainId_ = 0;
+  VoiceAllocator voices_;
+  size_t nextEvent_ = 0;  // First script event not yet applied
+};
+}  // namespace
+
+juce::AudioBuffer<float> renderEngine(const Scenario& scenario) {
+  AudioEngine engine;
+  applyPreset(scenario, *engine.getStochasticModel());
+  engine.setRandomSeed(scenario.seed);
+  if (getSource(scenario) == Source::AudioSample) {
+    engine.setSourceAudio(scenario.sample);
+    engine.setSourceType(AudioEngine::GrainSourceType::AudioSample);
+  } else {
+    engine.setGrainSource(scenario.waveform);
+  }
+  engine.setEnvelopeShape(scenario.shape);
+  engine.setSubBlockSize(scenario.subBlockSize);
+  engine.setNoteOnBurst(scenario.noteOnBurst);
+  engine.prepareToPlay(scenario.sampleRate, scenario.blockSize);
+
+  juce::AudioBuffer<float> output(scenario.numChannels, scenario.numSamples);
+  juce::AudioBuffer<float> block(scenario.numChannels, scenario.blockSize);
+  const juce::AudioPlayHead::PositionInfo position;
+  for (int start = 0; start < scenario.numSamples;
+       start += scenario.blockSize) {
+    const int length =
+        std::min(scenario.blockSize, scenario.numSamples - start);
+    if (length != block.getNumSamples())
+      block.setSize(scenario.numChannels, length, false, false, true);
+    juce::MidiBuffer midi;
+    collectMidi(scenario, start, length, midi);
+    engine.processBlock(block, midi, position);
+    for (int channel = 0; channel < scenario.numChannels; ++channel)
+      output.copyFrom(channel, start, block, channel, 0, length);
+  }
+  return output;
+}
+
+juce::AudioBuffer<float> renderReference(const Scenario& scenario) {
+  return ReferenceRenderer(scenario).render();
+}
+
+int64_t ulpDistance(float a, float b) {
+  if (std::isnan(a) || std::isnan(b))
+    return std::numeric_limits<int64_t>::max();
+  // Map the sign-magnitude float bits onto a line of consecutive integers.
+  auto ordered = [](float value) {
+    int32_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits < 0 ? int64_t{std::numeric_limits<int32_t>::min()} - bits
+                    : int64_t{bits};
+  };
+  const int64_t distance = ordered(a) - ordered(b);
+  return distance < 0 ? -distance : distance;
+}
+
+double Comparison::getMaxErrorDb() const {
+  return maxError > 0.0 ? 20.0 * std::log10(maxError)
+                        : -std::numeric_limits<double>::infinity();
+}
+
+std::string Comparison::describe() const {
+  if (!sameShape)
+    return "buffers differ in channel or sample count";
+  return "max error " + std::to_string(getMaxErrorDb()) + " dBFS at channel " +
+         std::to_string(worstChannel) + ", sample " +
+         std::to_string(worstSample) + "; max " + std::to_string(maxUlps) +
+         " ULP; " + std::to_string(numFailing) +
+         " samples outside tolerance; reference peak " +
+         std::to_string(referencePeak);
+}
+
+Comparison compare(const juce::AudioBuffer<float>& reference,
+                   const juce::AudioBuffer<float>& actual,
+                   const Tolerance& tolerance) {
+  Comparison result;
+  if (reference.getNumChannels() != actual.getNumChannels() ||
+      reference.getNumSamples() != actual.getNumSamples()) {
+    result.sameShape = false;
+    result.numFailing = std::max(reference.getNumSamples(),
+                                 actual.getNumSamples());
+    return result;
+  }
+
+  const double maxAbsoluteError = std::pow(10.0, tolerance.maxErrorDb / 20.0);
+  for (int channel = 0; channel < reference.getNumChannels(); ++channel) {
+    for (int i = 0; i < reference.getNumSamples(); ++i) {
+      const float expected = reference.getSample(channel, i);
+      const float got = actual.getSample(channel, i);
+      const int64_t ulps = ulpDistance(expected, got);
+      double error = std::abs(static_cast<double>(expected) -
+                              static_cast<double>(got));
+      if (std::isnan(error))
+        error = std::numeric_limits<double>::infinity();
+      result.referencePeak = std::max(result.referencePeak,
+                                      std::abs(static_cast<double>(expected)));
+      result.maxUlps = std::max(result.maxUlps, ulps);
+      if (error > result.maxError) {
+        result.maxError = error;
+        result.worstChannel = channel;
+        result.worstSample = i;
+      }
+      if (ulps > tolerance.maxUlps && error > maxAbsoluteError)
+        ++result.numFailing;
+    }
+  }
+  return result;
+}
+
+}  // namespace ReferenceRender
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Pointilsynth/PointilismInterfaces.h"
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <nlohmann/json.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Deterministic renders of the AudioEngine and a scalar reference for them.
+ *
+ * A Scenario fixes everything that affects the output: the preset, the grain
+ * source and envelope, the random seed, the host block and sub-block sizes
+ * and a MIDI script. renderEngine() runs the real engine on the active SIMD
+ * kernels. renderReference() recomputes the same signal from the grain math
+ * alone: one grain at a time, one sample at a time, with the scalar kernels
+ * and no grouping by render kernel. It reuses the StochasticModel for grain
+ * properties and the VoiceAllocator for note assignment but re-implements
+ * the spawn schedule and every render step.
+ *
+ * The two sum grains in a different order and the SIMD variants may fuse
+ * multiply-adds, so they agree to within a tolerance rather than bit for bit.
+ * compare() measures that difference; renderEngine() itself is bit-exact
+ * between runs of the same Scenario.
+ */
+namespace ReferenceRender {
+
+struct MidiEvent {
+  int samplePosition = 0;
+  int noteNumber = 60;
+  float velocity = 1.0f;  // 0 for a note-off.
+};
+
+struct Scenario {
+  nlohmann::json preset;  // Keys as written by PresetManager::savePreset().
+  int waveform = 0;       // AudioEngine::setGrainSource() id, if no sample.
+  juce::AudioBuffer<float> sample;  // Read by every grain when not empty.
+  GrainEnvelope::Shape shape = GrainEnvelope::Shape::Trapezoid;
+
+  uint32_t seed = 1;
+  double sampleRate = 48000.0;
+  int numChannels = 2;
+  int numSamples = 48000;
+  int blockSize = 512;  // Host block size; the last block may be shorter.
+  int subBlockSize = AudioEngine::kDefaultSubBlockSize;
+  std::vector<MidiEvent> midi;  // In sample order.
+  int noteOnBurst = 0;  // AudioEngine::setNoteOnBurst()
+};
+
+/** Renders scenario with the AudioEngine and the active SIMD kernels. */
+juce::AudioBuffer<float> renderEngine(const Scenario& scenario);
+
+/** Renders scenario with the scalar reference implementation. */
+juce::AudioBuffer<float> renderReference(const Scenario& scenario);
+
+/** A sample passes if it is within maxUlps of the reference or its absolute
+ * error is at most maxErrorDb relative to full scale. */
+struct Tolerance {
+  int64_t maxUlps = 0;
+  double maxErrorDb = -200.0;
+};
+
+struct Comparison {
+  bool sameShape = true;     // Channel and sample counts match.
+  int64_t maxUlps = 0;       // Largest distance in units in the last place.
+  double maxError = 0.0;     // Largest absolute difference.
+  double referencePeak = 0.0;
+  int worstChannel = -1;     // Where the largest absolute difference is.
+  int worstSample = -1;
+  int numFailing = 0;        // Samples outside the tolerance.
+
+  bool isIdentical() const { return sameShape && maxUlps == 0; }
+  bool passes() const { return sameShape && numFailing == 0; }
+  /** maxError in dB relative to full scale; -inf when identical. */
+  double getMaxErrorDb() const;
+  std::string describe() const;
+};
+
+/** Distance between a and b in representable floats; 0 for +0 and -0. */
+int64_t ulpDistance(float a, float b);
+
+Comparison compare(const juce::AudioBuffer<float>& reference,
+                   const juce::AudioBuffer<float>& actual,
+                   const Tolerance& tolerance);
+
+}  // namespace ReferenceRender
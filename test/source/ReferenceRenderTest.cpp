@@ -0,0 +1,160 @@
+#include "ReferenceRender.h"
+#include "Pointilsynth/SimdKernels.h"
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+#include <limits>
+
+namespace {
+// The engine sums grains group by group and the SIMD kernels may fuse
+// multiply-adds. With a dozen overlapping grains that moves samples by up to
+// about -120 dBFS; a wrong ramp, phase or gain shows up at -60 dBFS or above.
+const ReferenceRender::Tolerance kEngineTolerance{64, -110.0};
+
+ReferenceRender::Scenario makeScenario() {
+  ReferenceRender::Scenario scenario;
+  scenario.preset = {{"pitch", 62.0f},
+                     {"dispersion", 10.0f},
+                     {"averageDurationMs", 40.0f},
+                     {"durationVariation", 0.5f},
+                     {"centralPan", 0.1f},
+                     {"panSpread", 0.6f},
+                     {"globalDensity", 300.0f},
+                     {"globalTemporalDistribution", 1}};
+  scenario.numSamples = 24000;
+  scenario.blockSize = 480;
+  scenario.midi = {{2000, 67, 0.8f}, {9000, 67, 0.0f}, {15000, 48, 0.5f}};
+  return scenario;
+}
+
+juce::AudioBuffer<float> makeSample() {
+  juce::AudioBuffer<float> sample(1, 4800);
+  juce::Random random(99);
+  for (int i = 0; i < sample.getNumSamples(); ++i)
+    sample.setSample(0, i, random.nextFloat() * 2.0f - 1.0f);
+  return sample;
+}
+
+void requireMatchesReference(const ReferenceRender::Scenario& scenario) {
+  const auto reference = ReferenceRender::renderReference(scenario);
+  const auto engine = ReferenceRender::renderEngine(scenario);
+  const auto result =
+      ReferenceRender::compare(reference, engine, kEngineTolerance);
+  INFO(result.describe());
+  REQUIRE(result.referencePeak > 0.01);
+  REQUIRE(result.passes());
+}
+}  // namespace
+
+TEST_CASE("UlpDistanceCountsRepresentableFloats", "[ReferenceRenderTest]") {
+  REQUIRE(ReferenceRender::ulpDistance(1.0f, 1.0f) == 0);
+  REQUIRE(ReferenceRender::ulpDistance(0.0f, -0.0f) == 0);
+  REQUIRE(ReferenceRender::ulpDistance(1.0f, std::nextafter(1.0f, 2.0f)) ==
+          1);
+  const float tiny = std::numeric_limits<float>::denorm_min();
+  REQUIRE(ReferenceRender::ulpDistance(-tiny, tiny) == 2);
+}
+
+TEST_CASE("ComparisonFindsTheWorstSample", "[ReferenceRenderTest]") {
+  juce::AudioBuffer<float> reference(2, 100);
+  reference.clear();
+  reference.setSample(1, 10, 0.5f);
+  auto actual = reference;
+  actual.setSample(0, 40, 0.001f);  // -60 dBFS
+  actual.setSample(1, 10, std::nextafter(0.5f, 1.0f));
+
+  auto result = ReferenceRender::compare(reference, actual, {1, -100.0});
+  REQUIRE_FALSE(result.isIdentical());
+  REQUIRE(result.worstChannel == 0);
+  REQUIRE(result.worstSample == 40);
+  REQUIRE(result.getMaxErrorDb() > -60.1);
+  REQUIRE(result.getMaxErrorDb() < -59.9);
+  REQUIRE(result.numFailing == 1);  // The 1 ULP sample is within tolerance.
+  REQUIRE(ReferenceRender::compare(reference, actual, {1, -50.0}).passes());
+
+  juce::AudioBuffer<float> shorter(2, 99);
+  REQUIRE_FALSE(ReferenceRender::compare(reference, shorter, {}).passes());
+}
+
+TEST_CASE("SeededEngineRenderIsBitExact", "[ReferenceRenderTest]") {
+  auto scenario = makeScenario();
+  const auto first = ReferenceRender::renderEngine(scenario);
+  const auto second = ReferenceRender::renderEngine(scenario);
+  REQUIRE(ReferenceRender::compare(first, second, {}).isIdentical());
+
+  scenario.seed = 2;
+  const auto reseeded = ReferenceRender::renderEngine(scenario);
+  REQUIRE_FALSE(ReferenceRender::compare(first, reseeded, {}).isIdentical());
+}
+
+TEST_CASE("EngineMatchesScalarReference", "[ReferenceRenderTest]") {
+  const auto sample = makeSample();
+  for (int source = 0; source < 5; ++source) {
+    for (auto shape :
+         {GrainEnvelope::Shape::Trapezoid, GrainEnvelope::Shape::Hann}) {
+      auto scenario = makeScenario();
+      scenario.waveform = source;
+      if (source == 4)
+        scenario.sample = sample;
+      scenario.shape = shape;
+      INFO("source " << source << ", shape " << static_cast<int>(shape));
+      requireMatchesReference(scenario);
+    }
+  }
+}
+
+TEST_CASE("EngineMatchesReferenceAcrossBlockLayouts", "[ReferenceRenderTest]") {
+  auto scenario = makeScenario();
+  scenario.numChannels = 1;
+  scenario.blockSize = 333;
+  scenario.subBlockSize = 17;
+  requireMatchesReference(scenario);
+
+  scenario.numChannels = 3;
+  scenario.blockSize = 1024;
+  scenario.subBlockSize = AudioEngine::kMaxSubBlockSize;
+  requireMatchesReference(scenario);
+}
+
+TEST_CASE("EngineMatchesReferenceWithChords", "[ReferenceRenderTest]") {
+  // Overlapping notes past the voice limit: voices start, are released,
+  // stolen and culled.
+  auto scenario = makeScenario();
+  scenario.preset["globalNumVoices"] = 3;
+  scenario.midi = {{1000, 60, 0.9f},  {1500, 64, 0.7f},  {2200, 67, 0.6f},
+                   {4000, 71, 1.0f},  {6000, 64, 0.0f},  {9000, 48, 0.5f},
+                   {12000, 60, 0.0f}, {12000, 67, 0.0f}, {16000, 71, 0.0f},
+                   {18000, 48, 0.0f}};
+  requireMatchesReference(scenario);
+
+  scenario.noteOnBurst = 6;
+  requireMatchesReference(scenario);
+}
+
+TEST_CASE("NoteTimingIsIndependentOfHostBlockSize", "[ReferenceRenderTest]") {
+  // Notes take effect at their sample, so as long as the sub-blocks line up
+  // the host block size changes nothing.
+  auto scenario = makeScenario();
+  scenario.noteOnBurst = 3;
+  scenario.blockSize = AudioEngine::kDefaultSubBlockSize;
+  const auto small = ReferenceRender::renderEngine(scenario);
+  scenario.blockSize = 16 * AudioEngine::kDefaultSubBlockSize;
+  const auto large = ReferenceRender::renderEngine(scenario);
+  REQUIRE(ReferenceRender::compare(small, large, {}).isIdentical());
+}
+
+TEST_CASE("EverySimdVariantMatchesReference", "[ReferenceRenderTest]") {
+  auto scenario = makeScenario();
+  scenario.sample = makeSample();
+  const auto reference = ReferenceRender::renderReference(scenario);
+  for (int isa = 0; isa < SimdKernels::kNumIsas; ++isa) {
+    const auto kernelIsa = static_cast<SimdKernels::Isa>(isa);
+    if (!SimdKernels::setActiveIsa(kernelIsa))
+      continue;
+    const auto result = ReferenceRender::compare(
+        reference, ReferenceRender::renderEngine(scenario), kEngineTolerance);
+    INFO(SimdKernels::active().name << ": " << result.describe());
+    CHECK(result.passes());
+  }
+  SimdKernels::setActiveIsa(SimdKernels::detectIsa());
+}
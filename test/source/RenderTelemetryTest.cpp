@@ -0,0 +1,121 @@
+#include "Pointilsynth/DebugUIPanel.h"
+#include "Pointilsynth/PluginProcessor.h"
+#include "Pointilsynth/RenderTelemetry.h"
+#include "RealtimeSafety.h"
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <juce_gui_basics/juce_gui_basics.h>
+
+namespace {
+RenderTelemetry::BlockStats makeBlock(float renderMicroseconds) {
+  RenderTelemetry::BlockStats stats;
+  stats.renderMicroseconds = renderMicroseconds;
+  stats.budgetMicroseconds = 1000.0f;
+  stats.grainsSpawned = 2;
+  stats.grainsKilled = 1;
+  return stats;
+}
+}  // namespace
+
+TEST_CASE("SummaryReportsLoadPercentiles", "[RenderTelemetryTest]") {
+  RenderTelemetry telemetry;
+  // Loads of 1%, 2%, ... 100% of a 1 ms budget.
+  for (int i = 1; i <= 100; ++i)
+    REQUIRE(telemetry.push(makeBlock(static_cast<float>(i) * 10.0f)));
+
+  std::vector<RenderTelemetry::BlockStats> history;
+  REQUIRE(telemetry.drain(history, 1000) == 100);
+  const auto summary = RenderTelemetry::summarise(history);
+  REQUIRE(summary.numBlocks == 100);
+  REQUIRE(summary.p50Load == Catch::Approx(0.50f));
+  REQUIRE(summary.p95Load == Catch::Approx(0.95f));
+  REQUIRE(summary.p99Load == Catch::Approx(0.99f));
+  REQUIRE(summary.maxLoad == Catch::Approx(1.0f));
+  REQUIRE(summary.meanLoad == Catch::Approx(0.505f));
+  REQUIRE(summary.numOverruns == 0);
+  // 100 blocks of 1 ms each: 200 spawned and 100 killed in 0.1 s.
+  REQUIRE(summary.spawnedPerSecond == Catch::Approx(2000.0f));
+  REQUIRE(summary.killedPerSecond == Catch::Approx(1000.0f));
+  REQUIRE(summary.latest.getLoad() == Catch::Approx(1.0f));
+}
+
+TEST_CASE("DrainKeepsNewestHistory", "[RenderTelemetryTest]") {
+  RenderTelemetry telemetry;
+  std::vector<RenderTelemetry::BlockStats> history;
+  for (int i = 0; i < 10; ++i)
+    telemetry.push(makeBlock(static_cast<float>(i)));
+  REQUIRE(telemetry.drain(history, 4) == 10);
+  REQUIRE(history.size() == 4);
+  REQUIRE(history.front().renderMicroseconds == Catch::Approx(6.0f));
+  REQUIRE(history.back().renderMicroseconds == Catch::Approx(9.0f));
+}
+
+TEST_CASE("OverrunsAreCountedWhenTheRingIsFull", "[RenderTelemetryTest]") {
+  RenderTelemetry telemetry;
+  int accepted = 0;
+  for (int i = 0; i < RenderTelemetry::kCapacity + 10; ++i)
+    accepted += telemetry.push(makeBlock(2000.0f)) ? 1 : 0;
+  REQUIRE(accepted < RenderTelemetry::kCapacity + 10);
+  REQUIRE(telemetry.getNumDropped() ==
+          static_cast<uint32_t>(RenderTelemetry::kCapacity + 10 - accepted));
+  REQUIRE(telemetry.getNumOverruns() ==
+          static_cast<uint32_t>(RenderTelemetry::kCapacity + 10));
+  telemetry.resetOverruns();
+  REQUIRE(telemetry.getNumOverruns() == 0);
+}
+
+TEST_CASE("EngineReportsGrainsPerBlock", "[RenderTelemetryTest]") {
+  if constexpr (!RenderTelemetry::kEnabled)
+    SKIP("Render telemetry is compiled out");
+
+  RenderTelemetry telemetry;
+  AudioEngine engine;
+  engine.setTelemetry(&telemetry);
+  engine.getStochasticModel()->setGlobalDensity(200.0f);
+  engine.getStochasticModel()->setDurationAndVariation(20.0f, 0.1f);
+  engine.prepareToPlay(48000.0, 480);
+  juce::AudioBuffer<float> buffer(2, 480);
+  juce::MidiBuffer midi;
+  juce::AudioPlayHead::PositionInfo pos;
+  for (int block = 0; block < 10; ++block)
+    engine.processBlock(buffer, midi, pos);
+  REQUIRE_REALTIME_SAFE(engine.processBlock(buffer, midi, pos));
+
+  std::vector<RenderTelemetry::BlockStats> history;
+  REQUIRE(telemetry.drain(history, 100) == 11);
+  int spawned = 0;
+  int killed = 0;
+  for (const auto& block : history) {
+    REQUIRE(block.budgetMicroseconds == Catch::Approx(10000.0f));
+    REQUIRE(block.renderMicroseconds > 0.0f);
+    REQUIRE(block.sampleGrains + block.oscillatorGrains == block.liveGrains);
+    spawned += block.grainsSpawned;
+    killed += block.grainsKilled;
+  }
+  REQUIRE(spawned > 0);
+  REQUIRE(killed > 0);
+  REQUIRE(spawned - killed == engine.getNumActiveGrains());
+  REQUIRE(history.back().liveGrains == engine.getNumActiveGrains());
+  REQUIRE(history.back().sampleGrains == 0);
+}
+
+TEST_CASE("DebugUIPanelShowsTelemetry", "[RenderTelemetryTest]") {
+  if constexpr (!RenderTelemetry::kEnabled)
+    SKIP("Render telemetry is compiled out");
+
+  juce::ScopedJuceInitialiser_GUI libraryInitialiser;
+  audio_plugin::AudioPluginAudioProcessor processor;
+  auto& telemetry = processor.getRenderTelemetry();
+  DebugUIPanel panel(processor.getConfigManager(), &telemetry);
+  panel.setSize(400, 400);
+
+  telemetry.push(makeBlock(100.0f));
+  telemetry.push(makeBlock(3000.0f));
+  panel.updateTelemetry();
+  const auto& summary = panel.getTelemetrySummary();
+  REQUIRE(summary.numBlocks == 2);
+  REQUIRE(summary.numOverruns == 1);
+  REQUIRE(summary.maxLoad == Catch::Approx(3.0f));
+  REQUIRE(telemetry.getNumOverruns() == 1);
+  REQUIRE_NOTHROW(panel.createComponentSnapshot(panel.getLocalBounds()));
+}
@@ -1,5 +1,6 @@
 #include "Pointilsynth/Resampler.h"  // Defines Resampler namespace
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
 #include <juce_audio_basics/juce_audio_basics.h>  // For juce::AudioBuffer
 
 TEST_CASE("CanIncludeAndCallSinc", "[ResamplerTest]") {
@@ -15,3 +16,18 @@ TEST_CASE("GetSampleRuns", "[ResamplerTest]") {
   // Test with some basic parameters
   REQUIRE_NOTHROW(Resampler::getSample(buffer, 0, 10.5));
 }
+
+TEST_CASE("InterpolatedReadMatchesDirectEvaluation", "[ResamplerTest]") {
+  juce::AudioBuffer<float> buffer(1, 200);
+  for (int i = 0; i < buffer.getNumSamples(); ++i)
+    buffer.setSample(0, i, std::sin(0.05f * static_cast<float>(i)));
+
+  // Covers both buffer edges, where the window is clipped, and reads that
+  // fall entirely outside the buffer.
+  for (double position = -20.0; position < 220.0; position += 0.37) {
+    const float expected = Resampler::getSample(buffer, 0, position);
+    const float actual = Resampler::getSampleInterpolated(
+        buffer.getReadPointer(0), buffer.getNumSamples(), position);
+    REQUIRE(actual == Catch::Approx(expected).margin(1e-5f));
+  }
+}
@@ -0,0 +1,40 @@
+#include "Pointilsynth/RtLogger.h"
+#include <catch2/catch_test_macros.hpp>
+#include <juce_core/juce_core.h>
+
+TEST_CASE("DrainFormatsQueuedRecords", "[RtLoggerTest]") {
+  RtLogger logger;
+  logger.setEnabled(true);
+  REQUIRE(logger.log(RtLogEvent::MidiNoteOn, 60, 0.5f));
+  REQUIRE(logger.log(RtLogEvent::MidiNoteOff, 60));
+
+  juce::StringArray lines;
+  REQUIRE(logger.drain([&](const juce::String& line) { lines.add(line); }) ==
+          2);
+  REQUIRE(lines.size() == 2);
+  REQUIRE(lines[0].contains("MIDI Note On: Note 60, Velocity 0.5"));
+  REQUIRE(lines[1].contains("MIDI Note Off: Note 60"));
+  REQUIRE(logger.drain([](const juce::String&) {}) == 0);
+}
+
+TEST_CASE("DisabledLoggerIgnoresRecords", "[RtLoggerTest]") {
+  RtLogger logger;
+  REQUIRE_FALSE(logger.log(RtLogEvent::MidiNoteOff, 64));
+  REQUIRE(logger.drain([](const juce::String&) {}) == 0);
+}
+
+TEST_CASE("FullRingDropsAndReportsRecords", "[RtLoggerTest]") {
+  RtLogger logger;
+  logger.setEnabled(true);
+  int accepted = 0;
+  for (int i = 0; i < RtLogger::kCapacity + 10; ++i)
+    accepted += logger.log(RtLogEvent::MidiNoteOff, i) ? 1 : 0;
+  REQUIRE(logger.getNumDropped() ==
+          static_cast<uint32_t>(RtLogger::kCapacity + 10 - accepted));
+  REQUIRE(logger.getNumDropped() > 0);
+
+  juce::String last;
+  REQUIRE(logger.drain([&](const juce::String& line) { last = line; }) ==
+          accepted);
+  REQUIRE(last.contains("dropped"));
+}
@@ -0,0 +1,158 @@
+#include "Pointilsynth/PluginProcessor.h"
+#include "Pointilsynth/SessionTrace.h"
+#include "RealtimeSafety.h"
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <juce_gui_basics/juce_gui_basics.h>
+
+using audio_plugin::AudioPluginAudioProcessor;
+
+namespace {
+class FixedPlayHead : public juce::AudioPlayHead {
+public:
+  juce::Optional<PositionInfo> getPosition() const override { return info; }
+  PositionInfo info;
+};
+
+struct SessionTraceFixture {
+  SessionTraceFixture() {
+    position.info.setBpm(120.0);
+    position.info.setPpqPosition(8.0);
+    position.info.setTimeSignature(juce::AudioPlayHead::TimeSignature{3, 4});
+    position.info.setIsPlaying(true);
+  }
+  ~SessionTraceFixture() { traceFile.deleteFile(); }
+
+  juce::ScopedJuceInitialiser_GUI libraryInitialiser;
+  juce::File traceFile = juce::File::createTempFile(".pstrace");
+  FixedPlayHead position;
+};
+
+juce::RangedAudioParameter* getDensity(AudioPluginAudioProcessor& processor) {
+  return processor.getConfigManager()->getAPVTS().getParameter(
+      ConfigManager::ParamID::density);
+}
+}  // namespace
+
+TEST_CASE_METHOD(SessionTraceFixture,
+                 "CapturedSessionReadsBack",
+                 "[SessionTraceTest]") {
+  {
+    AudioPluginAudioProcessor processor;
+    processor.setPlayHead(&position);
+    processor.prepareToPlay(48000.0, 256);
+    REQUIRE(processor.startSessionCapture(traceFile));
+
+    juce::AudioBuffer<float> buffer(2, 256);
+    juce::MidiBuffer midi;
+    processor.processBlock(buffer, midi);
+
+    getDensity(processor)->setValueNotifyingHost(0.25f);
+    midi.addEvent(juce::MidiMessage::noteOn(1, 64, 0.5f), 17);
+    midi.addEvent(juce::MidiMessage::noteOff(1, 64), 200);
+    buffer.setSize(2, 128);
+    REQUIRE_REALTIME_SAFE(processor.processBlock(buffer, midi));
+
+    processor.stopSessionCapture();
+  }
+
+  SessionTrace::Reader reader(traceFile);
+  REQUIRE(reader.isValid());
+  REQUIRE(reader.getSampleRate() == Catch::Approx(48000.0));
+  const int densityIndex =
+      reader.getParameterIds().indexOf(ConfigManager::ParamID::density);
+  REQUIRE(densityIndex >= 0);
+
+  SessionTrace::Block block;
+  REQUIRE(reader.readNextBlock(block));
+  REQUIRE(block.numSamples == 256);
+  REQUIRE(block.parameterChanges.empty());
+  REQUIRE(block.midi.isEmpty());
+  REQUIRE(*block.position.getBpm() == Catch::Approx(120.0));
+  REQUIRE(*block.position.getPpqPosition() == Catch::Approx(8.0));
+  REQUIRE(block.position.getTimeSignature()->numerator == 3);
+  REQUIRE(block.position.getIsPlaying());
+  REQUIRE_FALSE(block.position.getTimeInSamples().hasValue());
+
+  REQUIRE(reader.readNextBlock(block));
+  REQUIRE(block.numSamples == 128);
+  REQUIRE(block.parameterChanges.size() == 1);
+  REQUIRE(static_cast<int>(block.parameterChanges[0].index) == densityIndex);
+  REQUIRE(block.parameterChanges[0].value == Catch::Approx(0.25f));
+  REQUIRE(block.midi.getNumEvents() == 2);
+  REQUIRE(block.midi.getFirstEventTime() == 17);
+  REQUIRE(block.midi.getLastEventTime() == 200);
+
+  REQUIRE_FALSE(reader.readNextBlock(block));
+}
+
+TEST_CASE_METHOD(SessionTraceFixture,
+                 "ReplayFeedsTraceIntoFreshProcessor",
+                 "[SessionTraceTest]") {
+  {
+    AudioPluginAudioProcessor processor;
+    processor.setPlayHead(&position);
+    processor.prepareToPlay(44100.0, 64);
+    REQUIRE(processor.startSessionCapture(traceFile));
+    juce::AudioBuffer<float> buffer(2, 64);
+    juce::MidiBuffer midi;
+    for (int block = 0; block < 10; ++block) {
+      if (block == 5)
+        getDensity(processor)->setValueNotifyingHost(0.75f);
+      processor.processBlock(buffer, midi);
+    }
+    processor.stopSessionCapture();
+  }
+
+  SessionTrace::Reader reader(traceFile);
+  REQUIRE(reader.isValid());
+  AudioPluginAudioProcessor fresh;
+  const auto result = SessionTrace::replay(reader, fresh);
+  REQUIRE(result.numBlocks == 10);
+  REQUIRE(result.numSamples == 640);
+  REQUIRE(result.blockSeconds.size() == 10);
+  REQUIRE(getDensity(fresh)->getValue() == Catch::Approx(0.75f));
+  REQUIRE(fresh.getSampleRate() == Catch::Approx(44100.0));
+}
+
+TEST_CASE_METHOD(SessionTraceFixture,
+                 "ParameterChangesSurviveDroppedBlocks",
+                 "[SessionTraceTest]") {
+  {
+    AudioPluginAudioProcessor processor;
+    processor.setPlayHead(&position);
+    processor.prepareToPlay(44100.0, 64);
+    REQUIRE(processor.startSessionCapture(traceFile));
+    juce::AudioBuffer<float> buffer(2, 64);
+    juce::MidiBuffer midi;
+    processor.processBlock(buffer, midi);
+
+    // Too much MIDI for one block: the block, and the density change made
+    // in it, are dropped.
+    getDensity(processor)->setValueNotifyingHost(0.75f);
+    for (int i = 0; i < SessionTrace::Writer::kMaxBlockBytes / 8; ++i)
+      midi.addEvent(juce::MidiMessage::noteOff(1, 64), i % 64);
+    processor.processBlock(buffer, midi);
+    midi.clear();
+    for (int block = 0; block < 3; ++block)
+      processor.processBlock(buffer, midi);
+    processor.stopSessionCapture();
+  }
+
+  SessionTrace::Reader reader(traceFile);
+  REQUIRE(reader.isValid());
+  AudioPluginAudioProcessor fresh;
+  const auto result = SessionTrace::replay(reader, fresh);
+  REQUIRE(result.numBlocks == 4);
+  REQUIRE(getDensity(fresh)->getValue() == Catch::Approx(0.75f));
+}
+
+TEST_CASE("RejectsFilesThatAreNotTraces", "[SessionTraceTest]") {
+  auto file = juce::File::createTempFile(".pstrace");
+  file.replaceWithText("not a trace");
+  SessionTrace::Reader reader(file);
+  REQUIRE_FALSE(reader.isValid());
+  SessionTrace::Block block;
+  REQUIRE_FALSE(reader.readNextBlock(block));
+  file.deleteFile();
+}
@@ -0,0 +1,90 @@
+#include "Pointilsynth/SimdKernels.h"
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <cmath>
+#include <vector>
+
+namespace {
+constexpr SimdKernels::Isa kAllIsas[] = {
+    SimdKernels::Isa::Scalar, SimdKernels::Isa::SSE2, SimdKernels::Isa::AVX2,
+    SimdKernels::Isa::AVX512};
+
+// Lengths around every vector width so both bodies and tails are exercised.
+constexpr int kLengths[] = {0, 1, 3, 4, 7, 8, 15, 16, 17, 33, 64, 255};
+
+std::vector<float> makeSignal(int numSamples, float seed) {
+  std::vector<float> signal(static_cast<size_t>(numSamples));
+  for (size_t i = 0; i < signal.size(); ++i)
+    signal[i] = std::sin(seed * static_cast<float>(i + 1));
+  return signal;
+}
+}  // namespace
+
+TEST_CASE("ScalarKernelsAreAlwaysAvailable", "[SimdKernelsTest]") {
+  REQUIRE(SimdKernels::getKernelSet(SimdKernels::Isa::Scalar) ==
+          &SimdKernels::scalar());
+  REQUIRE(SimdKernels::getKernelSet(SimdKernels::detectIsa()) != nullptr);
+  REQUIRE(SimdKernels::active().isa == SimdKernels::detectIsa());
+}
+
+TEST_CASE("EveryAvailableIsaMatchesScalarReference", "[SimdKernelsTest]") {
+  const auto& reference = SimdKernels::scalar();
+  for (auto isa : kAllIsas) {
+    const auto* kernels = SimdKernels::getKernelSet(isa);
+    if (kernels == nullptr)
+      continue;
+    INFO("ISA " << kernels->name);
+
+    for (int n : kLengths) {
+      INFO("numSamples " << n);
+      const auto a = makeSignal(n, 0.37f);
+      const auto b = makeSignal(n, 1.91f);
+      REQUIRE(kernels->dot(a.data(), b.data(), n) ==
+              Catch::Approx(reference.dot(a.data(), b.data(), n))
+                  .margin(1e-5f));
+
+      std::vector<float> expected(static_cast<size_t>(n));
+      std::vector<float> actual(static_cast<size_t>(n));
+      auto requireMatch = [&](float margin) {
+        for (size_t i = 0; i < actual.size(); ++i)
+          REQUIRE(actual[i] == Catch::Approx(expected[i]).margin(margin));
+      };
+
+      reference.sine(expected.data(), 0.3f, 0.0731f, n);
+      kernels->sine(actual.data(), 0.3f, 0.0731f, n);
+      requireMatch(2e-5f);
+
+      const float hannIncrement = 1.0f / static_cast<float>(n + 1);
+      reference.hann(expected.data(), 0.0f, hannIncrement, n);
+      kernels->hann(actual.data(), 0.0f, hannIncrement, n);
+      requireMatch(1e-6f);
+
+      reference.ramp(expected.data(), 1.0f, -0.01f, n);
+      kernels->ramp(actual.data(), 1.0f, -0.01f, n);
+      requireMatch(1e-6f);
+
+      auto expectedRight = makeSignal(n, 0.11f);
+      auto actualRight = expectedRight;
+      expected = makeSignal(n, 0.53f);
+      actual = expected;
+      reference.mixStereo(expected.data(), expectedRight.data(), a.data(),
+                          b.data(), 0.7f, 0.3f, n);
+      kernels->mixStereo(actual.data(), actualRight.data(), a.data(), b.data(),
+                         0.7f, 0.3f, n);
+      reference.mixMono(expected.data(), a.data(), b.data(), 0.5f, n);
+      kernels->mixMono(actual.data(), a.data(), b.data(), 0.5f, n);
+      requireMatch(1e-6f);
+      for (size_t i = 0; i < actualRight.size(); ++i)
+        REQUIRE(actualRight[i] ==
+                Catch::Approx(expectedRight[i]).margin(1e-6f));
+    }
+  }
+}
+
+TEST_CASE("SetActiveIsaSwitchesKernels", "[SimdKernelsTest]") {
+  const auto detected = SimdKernels::detectIsa();
+  REQUIRE(SimdKernels::setActiveIsa(SimdKernels::Isa::Scalar));
+  REQUIRE(&SimdKernels::active() == &SimdKernels::scalar());
+  REQUIRE(SimdKernels::setActiveIsa(detected));
+  REQUIRE(SimdKernels::active().isa == detected);
+}
@@ -0,0 +1,140 @@
+#include "Pointilsynth/SpanTracer.h"
+#include "RealtimeSafety.h"
+#include <catch2/catch_test_macros.hpp>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <optional>
+#include <thread>
+
+namespace {
+/** Spans called name in the current trace. */
+std::vector<nlohmann::json> findSpans(const std::string& name) {
+  const auto trace = nlohmann::json::parse(SpanTracer::toChromeTraceJson());
+  std::vector<nlohmann::json> spans;
+  for (const auto& event : trace["traceEvents"])
+    if (event["ph"] == "X" && event["name"] == name)
+      spans.push_back(event);
+  return spans;
+}
+
+std::string getThreadName(int tid) {
+  const auto trace = nlohmann::json::parse(SpanTracer::toChromeTraceJson());
+  for (const auto& event : trace["traceEvents"])
+    if (event["ph"] == "M" && event["tid"] == tid)
+      return event["args"]["name"];
+  return {};
+}
+}  // namespace
+
+TEST_CASE("RecordsSpansPerThread", "[SpanTracerTest]") {
+  SpanTracer::setEnabled(true);
+  { POINTILSYNTH_TRACE_SCOPE("SpanTracerTest main"); }
+  std::thread worker([] {
+    SpanTracer::nameCurrentThread("SpanTracerTest worker");
+    POINTILSYNTH_TRACE_SCOPE("SpanTracerTest worker span", 7);
+  });
+  worker.join();
+  SpanTracer::setEnabled(false);
+
+  const auto mainSpans = findSpans("SpanTracerTest main");
+  const auto workerSpans = findSpans("SpanTracerTest worker span");
+  REQUIRE(mainSpans.size() == 1);
+  REQUIRE(workerSpans.size() == 1);
+  REQUIRE(mainSpans[0]["tid"] != workerSpans[0]["tid"]);
+  REQUIRE(mainSpans[0]["dur"].get<double>() >= 0.0);
+  REQUIRE_FALSE(mainSpans[0].contains("args"));
+  REQUIRE(workerSpans[0]["args"]["value"] == 7);
+  REQUIRE(getThreadName(workerSpans[0]["tid"]) == "SpanTracerTest worker");
+}
+
+TEST_CASE("DisabledTracerRecordsNothing", "[SpanTracerTest]") {
+  SpanTracer::setEnabled(false);
+  { POINTILSYNTH_TRACE_SCOPE("SpanTracerTest disabled"); }
+  REQUIRE(findSpans("SpanTracerTest disabled").empty());
+}
+
+TEST_CASE("RingKeepsNewestSpans", "[SpanTracerTest]") {
+  SpanTracer::setEnabled(true);
+  constexpr int kNumSpans = SpanTracer::kEventsPerThread + 100;
+  std::thread worker([] {
+    for (int i = 0; i < kNumSpans; ++i)
+      SpanTracer::record("SpanTracerTest wrap", 0, 1, i);
+  });
+  worker.join();
+  SpanTracer::setEnabled(false);
+
+  const auto spans = findSpans("SpanTracerTest wrap");
+  REQUIRE(spans.size() == static_cast<size_t>(SpanTracer::kEventsPerThread));
+  REQUIRE(spans.front()["args"]["value"] == 100);
+  REQUIRE(spans.back()["args"]["value"] == kNumSpans - 1);
+}
+
+TEST_CASE("SnapshotsOfAFullRingAreIntact", "[SpanTracerTest]") {
+  SpanTracer::setEnabled(true);
+  std::atomic<bool> isFull{false};
+  std::atomic<bool> shouldStop{false};
+  std::thread writer([&] {
+    // Overwriting an older span leaves end < start if the copy tears.
+    for (juce::int64 i = 0; !shouldStop.load(); ++i) {
+      SpanTracer::record("SpanTracerTest spinning", i, i + 1);
+      if (i == SpanTracer::kEventsPerThread)
+        isFull.store(true);
+    }
+  });
+  while (!isFull.load())
+    std::this_thread::yield();
+
+  // Check after joining, so a failure does not leave the writer running.
+  bool foundWriter = true;
+  bool isIntact = true;
+  for (int attempt = 0; attempt < 5; ++attempt) {
+    const auto trace = nlohmann::json::parse(SpanTracer::toChromeTraceJson());
+    std::optional<int> writerTid;
+    for (const auto& event : trace["traceEvents"])
+      if (event["ph"] == "X" && event["name"] == "SpanTracerTest spinning")
+        writerTid = event["tid"].get<int>();
+    foundWriter = foundWriter && writerTid.has_value();
+    for (const auto& event : trace["traceEvents"]) {
+      if (!writerTid || event["ph"] != "X" || event["tid"] != *writerTid)
+        continue;
+      isIntact = isIntact && event["name"] == "SpanTracerTest spinning" &&
+                 event["dur"].get<double>() >= 0.0;
+    }
+  }
+  shouldStop.store(true);
+  writer.join();
+  SpanTracer::setEnabled(false);
+  REQUIRE(foundWriter);
+  REQUIRE(isIntact);
+}
+
+TEST_CASE("RecordingIsRealtimeSafe", "[SpanTracerTest]") {
+  SpanTracer::setEnabled(true);
+  REQUIRE_REALTIME_SAFE([] {
+    for (int i = 0; i < 100; ++i)
+      POINTILSYNTH_TRACE_SCOPE("SpanTracerTest realtime", i);
+  }());
+  SpanTracer::setEnabled(false);
+  REQUIRE(findSpans("SpanTracerTest realtime").size() == 100);
+}
+
+TEST_CASE("ExitedThreadsFreeTheirRings", "[SpanTracerTest]") {
+  SpanTracer::setEnabled(true);
+  const auto numDropped = SpanTracer::getNumDropped();
+  for (int i = 0; i < SpanTracer::kMaxThreads * 2; ++i) {
+    std::thread worker(
+        [i] { SpanTracer::record("SpanTracerTest short-lived", 0, 1, i); });
+    worker.join();
+  }
+  SpanTracer::setEnabled(false);
+
+  // Every thread found a ring, and the latest ones are still in the trace.
+  REQUIRE(SpanTracer::getNumDropped() == numDropped);
+  const auto spans = findSpans("SpanTracerTest short-lived");
+  REQUIRE_FALSE(spans.empty());
+  REQUIRE(std::any_of(spans.begin(), spans.end(), [](const auto& span) {
+    return span["args"]["value"] == SpanTracer::kMaxThreads * 2 - 1;
+  }));
+}
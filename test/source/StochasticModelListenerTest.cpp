@@ -8,12 +8,32 @@ TEST_CASE("UpdatesOnParameterChange", "[StochasticModelListenerTest]") {
   juce::ScopedJuceInitialiser_GUI libraryInitialiser;
   audio_plugin::AudioPluginAudioProcessor processor;
   auto cfg = ConfigManager::getInstance(&processor);
-  StochasticModel model(cfg);
+  StochasticModel model(cfg->getParameterHandles());
 
   auto& apvts = cfg->getAPVTS();
   if (auto* param = apvts.getParameter(ConfigManager::ParamID::pitch)) {
     param->setValueNotifyingHost(param->convertTo0to1(80.0f));
   }
+  model.pollParameters();
 
   REQUIRE(juce::approximatelyEqual(model.getPitch(), 80.0f));
 }
+
+TEST_CASE("PollKeepsDirectlySetValuesUntilParameterChanges",
+          "[StochasticModelListenerTest]") {
+  juce::ScopedJuceInitialiser_GUI libraryInitialiser;
+  audio_plugin::AudioPluginAudioProcessor processor;
+  auto cfg = ConfigManager::getInstance(&processor);
+  StochasticModel model(cfg->getParameterHandles());
+
+  model.setGlobalDensity(25.0f);
+  model.pollParameters();
+  REQUIRE(juce::approximatelyEqual(model.getGlobalDensity(), 25.0f));
+
+  auto& apvts = cfg->getAPVTS();
+  if (auto* param = apvts.getParameter(ConfigManager::ParamID::density)) {
+    param->setValueNotifyingHost(param->convertTo0to1(40.0f));
+  }
+  model.pollParameters();
+  REQUIRE(juce::approximatelyEqual(model.getGlobalDensity(), 40.0f));
+}
@@ -0,0 +1,62 @@
+#include "UI/GrainRasterizer.h"
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+namespace audio_plugin {
+
+namespace {
+int level(const juce::Image& image, int x, int y) {
+  return image.getPixelAt(x, y).getRed();
+}
+}  // namespace
+
+TEST_CASE("DotsAreStampedWhereAsked", "[GrainRasterizerTest]") {
+  GrainRasterizer rasterizer(false);
+  juce::Image image(juce::Image::RGB, 64, 32, false);
+  rasterizer.rasterize({{10.0f, 10.0f, 3.0f, 1.0f}, {50.0f, 20.0f, 2.0f, 0.5f}},
+                       image);
+
+  REQUIRE(level(image, 10, 10) == 255);
+  REQUIRE(level(image, 11, 11) == 255);
+  REQUIRE(level(image, 10, 15) == 0);
+  REQUIRE(level(image, 50, 20) == Catch::Approx(128).margin(1));
+  REQUIRE(level(image, 30, 5) == 0);
+  REQUIRE(image.getPixelAt(10, 10).getGreen() == 255);
+  REQUIRE(image.getPixelAt(10, 10).getBlue() == 255);
+
+  // Dots blend towards white, and the next frame starts from black.
+  rasterizer.rasterize({{50.0f, 20.0f, 2.0f, 0.5f}, {50.0f, 20.0f, 2.0f, 0.5f}},
+                       image);
+  REQUIRE(level(image, 50, 20) == Catch::Approx(191).margin(1));
+  REQUIRE(level(image, 10, 10) == 0);
+}
+
+TEST_CASE("DotsAreClippedToTheImage", "[GrainRasterizerTest]") {
+  GrainRasterizer rasterizer(false);
+  juce::Image image(juce::Image::RGB, 16, 16, false);
+  rasterizer.rasterize({{-1.0f, -1.0f, 4.0f, 1.0f},
+                        {17.0f, 17.0f, GrainRasterizer::kMaxRadius * 2, 1.0f},
+                        {8.0f, 8.0f, 0.0f, 1.0f}},
+                       image);
+  REQUIRE(level(image, 0, 0) == 255);
+  REQUIRE(level(image, 15, 15) == 255);
+  REQUIRE(level(image, 8, 8) > 0);  // Radius clamped to kMinRadius
+}
+
+TEST_CASE("WorkerThreadDeliversFrames", "[GrainRasterizerTest]") {
+  GrainRasterizer rasterizer;
+  std::vector<GrainRasterizer::Dot> dots{{20.0f, 10.0f, 2.0f, 1.0f}};
+  rasterizer.submit(dots, 40, 20);
+  REQUIRE(dots.empty());
+
+  for (int i = 0; i < 200 && !rasterizer.hasNewFrame(); ++i)
+    juce::Thread::sleep(5);
+  const auto* frame = rasterizer.acquireFrame();
+  REQUIRE(frame != nullptr);
+  REQUIRE(frame->getWidth() == 40);
+  REQUIRE(frame->getHeight() == 20);
+  REQUIRE(level(*frame, 20, 10) == 255);
+  REQUIRE(rasterizer.acquireFrame() == nullptr);
+}
+
+}  // namespace audio_plugin
@@ -2,11 +2,69 @@
 #include <catch2/catch_test_macros.hpp>
 #include <juce_gui_basics/juce_gui_basics.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
 using audio_plugin::InertialHistoryVisualizer;
 
+namespace {
+/** Largest difference of any colour channel between two equal-sized images,
+ * from column firstX on. */
+int getMaxDifference(const juce::Image& a,
+                     const juce::Image& b,
+                     int firstX = 0) {
+  int worst = 0;
+  for (int y = 0; y < a.getHeight(); ++y) {
+    for (int x = firstX; x < a.getWidth(); ++x) {
+      const auto pa = a.getPixelAt(x, y);
+      const auto pb = b.getPixelAt(x, y);
+      worst = std::max({worst, std::abs(pa.getRed() - pb.getRed()),
+                        std::abs(pa.getGreen() - pb.getGreen()),
+                        std::abs(pa.getBlue() - pb.getBlue())});
+    }
+  }
+  return worst;
+}
+
+/** Hues of the lit pixels in the newest column of the plot. */
+std::vector<float> getNewestHues(const juce::Image& plot) {
+  std::vector<float> hues;
+  const int right = plot.getWidth() - 1;
+  for (int x = right - InertialHistoryVisualizer::kPixelsPerPoint + 1;
+       x < right; ++x)
+    for (int y = 0; y < plot.getHeight(); ++y)
+      if (const auto pixel = plot.getPixelAt(x, y);
+          pixel.getBrightness() > 0.3f)
+        hues.push_back(pixel.getHue());
+  return hues;
+}
+
+/** The hue a layer for noteNumber is drawn in. */
+float getPitchClassHue(int noteNumber) {
+  return static_cast<float>(noteNumber % 12) / 12.0f;
+}
+
+bool isHue(float hue, float expected) {
+  const float distance = std::abs(hue - expected);
+  return std::min(distance, 1.0f - distance) < 0.03f;
+}
+}  // namespace
+
 struct InertialHistoryVisualizerFixture {
   juce::ScopedJuceInitialiser_GUI libraryInitialiser;
   InertialHistoryManager manager;
+  double ppq = 0.0;
+
+  /** Advances the transport by step quarter notes, publishes the notes and
+   * runs one timer tick. */
+  void tick(InertialHistoryVisualizer& comp, double step = 0.1) {
+    ppq += step;
+    manager.update(ppq, 4.0);
+    manager.publishSnapshot();
+    comp.timerCallback();
+  }
 };
 
 TEST_CASE_METHOD(InertialHistoryVisualizerFixture,
@@ -24,3 +82,108 @@ TEST_CASE_METHOD(InertialHistoryVisualizerFixture,
   juce::Graphics g(img);
   REQUIRE_NOTHROW([&] { comp.paint(g); }());
 }
+
+TEST_CASE_METHOD(InertialHistoryVisualizerFixture,
+                 "ScrolledPlotMatchesAFullRedraw",
+                 "[InertialHistoryVisualizer]") {
+  InertialHistoryVisualizer comp(manager);
+  comp.setSize(200, 80);
+
+  // Enough ticks to wrap the column ring, with notes coming and going.
+  for (int i = 0; i < InertialHistoryVisualizer::kMaxPoints + 30; ++i) {
+    if (i % 25 == 0)
+      manager.addNote(60 + i % 12, 1.0f, ppq);
+    tick(comp);
+  }
+  const auto scrolled = comp.getPlot().createCopy();
+  comp.resized();  // Redraws the plot from the stored columns.
+
+  // The scrolled plot's first segment can still hold an antialiased corner of
+  // the segment that scrolled out before it, which the redraw no longer has.
+  REQUIRE(comp.getPlot().getBounds() == scrolled.getBounds());
+  REQUIRE(getMaxDifference(scrolled, comp.getPlot(),
+                           InertialHistoryVisualizer::kPixelsPerPoint) <= 8);
+}
+
+TEST_CASE_METHOD(InertialHistoryVisualizerFixture,
+                 "ScrollingStopsWhileQuietAndResumesOnANote",
+                 "[InertialHistoryVisualizer]") {
+  InertialHistoryVisualizer comp(manager);
+  comp.setSize(200, 80);
+  manager.addNote(60, 1.0f, ppq);
+  tick(comp);
+  REQUIRE(comp.isScrolling());
+
+  // Four bars on, the note is forgotten. The plot keeps scrolling until its
+  // last column with notes has left it.
+  tick(comp, 16.0);
+  for (int i = 1; i < InertialHistoryVisualizer::kMaxPoints; ++i)
+    tick(comp);
+  REQUIRE(comp.isScrolling());
+  tick(comp);
+  REQUIRE_FALSE(comp.isScrolling());
+
+  const auto idle = comp.getPlot().createCopy();
+  tick(comp);
+  REQUIRE(getMaxDifference(idle, comp.getPlot()) == 0);
+
+  manager.addNote(64, 1.0f, ppq);
+  tick(comp);
+  REQUIRE(comp.isScrolling());
+  REQUIRE(getMaxDifference(idle, comp.getPlot()) > 0);
+}
+
+TEST_CASE_METHOD(InertialHistoryVisualizerFixture,
+                 "ResizeRebuildsThePlot",
+                 "[InertialHistoryVisualizer]") {
+  InertialHistoryVisualizer comp(manager);
+  comp.setSize(200, 60);
+  manager.addNote(60, 1.0f, ppq);
+  for (int i = 0; i < 10; ++i)
+    tick(comp);
+  REQUIRE(comp.getPlot().getHeight() == 60);
+
+  comp.setSize(200, 120);
+  const auto& plot = comp.getPlot();
+  REQUIRE(plot.getHeight() == 120);
+  constexpr int kPlotWidth = (InertialHistoryVisualizer::kMaxPoints - 1) *
+                                InertialHistoryVisualizer::kPixelsPerPoint +
+                            1;
+  REQUIRE(plot.getWidth() == kPlotWidth);
+  // The history survives the resize.
+  REQUIRE_FALSE(getNewestHues(plot).empty());
+
+  comp.setSize(200, 0);
+  REQUIRE_FALSE(comp.getPlot().isValid());
+}
+
+TEST_CASE_METHOD(InertialHistoryVisualizerFixture,
+                 "LayerColoursFollowTheirPitchClass",
+                 "[InertialHistoryVisualizer]") {
+  InertialHistoryVisualizer comp(manager);
+  comp.setSize(200, 80);
+  manager.addNote(60, 1.0f, ppq);  // C, the bottom layer
+  tick(comp, 2.0);
+  manager.addNote(67, 1.0f, ppq);  // G, on top of it
+  tick(comp, 0.5);
+  tick(comp, 0.5);
+
+  auto hues = getNewestHues(comp.getPlot());
+  REQUIRE(std::any_of(hues.begin(), hues.end(), [](float hue) {
+    return isHue(hue, getPitchClassHue(60));
+  }));
+  REQUIRE(std::any_of(hues.begin(), hues.end(), [](float hue) {
+    return isHue(hue, getPitchClassHue(67));
+  }));
+
+  // Three bars after it started C is forgotten and G becomes the bottom
+  // layer, still drawn in G's colour.
+  while (ppq < 13.0)
+    tick(comp);
+  REQUIRE(manager.getNumNotes() == 1u);
+  hues = getNewestHues(comp.getPlot());
+  REQUIRE_FALSE(hues.empty());
+  REQUIRE(std::all_of(hues.begin(), hues.end(), [](float hue) {
+    return isHue(hue, getPitchClassHue(67));
+  }));
+}
@@ -17,7 +17,7 @@ TEST_CASE_METHOD(PresetBrowserTestFixture,
                  "[PresetBrowserTestFixture]") {
   AudioPluginAudioProcessor processor;
   auto cfg = ConfigManager::getInstance(&processor);
-  StochasticModel model(cfg);
+  StochasticModel model(cfg->getParameterHandles());
   Pointilism::PresetManager manager(model);
   REQUIRE_NOTHROW([&] { PresetBrowserComponent browser(manager); }());
 }
@@ -6,14 +6,46 @@ namespace audio_plugin {
 
 struct VisualizationComponentTestFixture {
   juce::ScopedJuceInitialiser_GUI libraryInitialiser;
-  juce::AbstractFifo fifo{8};
-  std::array<GrainInfoForVis, 8> buffer{};
+  GrainVisQueue visQueue;
+  GrainDensityGrid densityGrid;
 };
 
 TEST_CASE_METHOD(VisualizationComponentTestFixture,
                  "CanConstruct",
                  "[VisualizationComponentTestFixture]") {
-  REQUIRE_NOTHROW([&] { VisualizationComponent comp(fifo, buffer.data()); }());
+  REQUIRE_NOTHROW([&] { VisualizationComponent comp(visQueue, densityGrid); }());
+}
+
+TEST_CASE_METHOD(VisualizationComponentTestFixture,
+                 "HeatmapModeIsKeptInTheGrid",
+                 "[VisualizationComponentTestFixture]") {
+  {
+    VisualizationComponent comp(visQueue, densityGrid);
+    REQUIRE_FALSE(comp.isHeatmapMode());
+    comp.setHeatmapMode(true);
+    REQUIRE(densityGrid.isEnabled());
+  }
+  VisualizationComponent reopened(visQueue, densityGrid);
+  REQUIRE(reopened.isHeatmapMode());
+}
+
+TEST_CASE_METHOD(VisualizationComponentTestFixture,
+                 "FrameRateDropsWhileNothingIsShown",
+                 "[VisualizationComponentTestFixture]") {
+  GrainSnapshotBuffer snapshots;
+  VisualizationComponent comp(visQueue, densityGrid, &snapshots);
+  comp.setSize(200, 100);
+  REQUIRE(comp.getFrameRateHz() == VisualizationComponent::kActiveHz);
+
+  comp.timerCallback();
+  REQUIRE(comp.getFrameRateHz() == VisualizationComponent::kIdleHz);
+
+  auto& snapshot = snapshots.getWriteBuffer();
+  snapshot.numGrains = snapshot.numLive = 1;
+  snapshot.grains[0] = {1, 60.0f, 0.0f, 0.5f, 1.0f};
+  snapshots.publish();
+  comp.timerCallback();
+  REQUIRE(comp.getFrameRateHz() == VisualizationComponent::kActiveHz);
 }
 
 }  // namespace audio_plugin
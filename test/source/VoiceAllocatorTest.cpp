@@ -0,0 +1,129 @@
+#include "Pointilsynth/VoiceAllocator.h"
+#include "Pointilsynth/PointilismInterfaces.h"
+#include "RealtimeSafety.h"
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <array>
+#include <memory>
+
+TEST_CASE("FirstNoteTakesOverTheFreeStream", "[VoiceAllocatorTest]") {
+  VoiceAllocator voices;
+  voices.reset(100, 10.0f);
+  REQUIRE(voices.getNumActiveVoices() == 1);
+  REQUIRE(voices.nextOnset(128) == 0);
+
+  // The free stream keeps its schedule when a note takes it over, and again
+  // when the last note is released.
+  REQUIRE(voices.noteOn(67, 0.8f, 4) == 0);
+  REQUIRE(voices.getVoice(0).samplesUntilNextGrain == 100);
+  REQUIRE(voices.getVoice(0).influence == 0.8f);
+  REQUIRE(voices.noteOff(67) == 0);
+  REQUIRE(voices.getVoice(0).isSpawning);
+  REQUIRE(voices.getVoice(0).noteNumber == -1);
+  REQUIRE(voices.getVoice(0).influence == 0.0f);
+  REQUIRE(voices.getVoice(0).samplesUntilNextGrain == 100);
+  REQUIRE(voices.noteOff(67) == -1);
+}
+
+TEST_CASE("ChordNotesGetVoicesOfTheirOwn", "[VoiceAllocatorTest]") {
+  VoiceAllocator voices;
+  voices.reset(100, 10.0f);
+  const int root = voices.noteOn(60, 1.0f, 3);
+  const int third = voices.noteOn(64, 1.0f, 3);
+  const int fifth = voices.noteOn(67, 1.0f, 3);
+  REQUIRE(root == 0);
+  REQUIRE(third != root);
+  REQUIRE(fifth != third);
+  REQUIRE(voices.getNumActiveVoices() == 3);
+  // New voices wait for the next sub-block to schedule them.
+  REQUIRE(voices.getVoice(third).samplesUntilNextGrain == INT_MAX);
+  REQUIRE(voices.nextOnset(INT_MAX) == root);
+
+  // A released voice with grains sounding stops spawning but stays active
+  // until they finish.
+  voices.getVoice(third).samplesUntilNextGrain = 0;
+  voices.grainStarted(third);
+  REQUIRE(voices.noteOff(64) == third);
+  REQUIRE_FALSE(voices.getVoice(third).isSpawning);
+  REQUIRE(voices.nextOnset(128) == root);
+  voices.cullSilentVoices();
+  REQUIRE(voices.getNumActiveVoices() == 3);
+  voices.grainFinished(third);
+  voices.cullSilentVoices();
+  REQUIRE(voices.getNumActiveVoices() == 2);
+}
+
+TEST_CASE("VoicesBeyondTheLimitAreStolen", "[VoiceAllocatorTest]") {
+  VoiceAllocator voices;
+  voices.reset(100, 10.0f);
+  const int first = voices.noteOn(60, 1.0f, 2);
+  const int second = voices.noteOn(62, 1.0f, 2);
+
+  // Held voices are stolen oldest first and keep their schedule.
+  voices.getVoice(first).samplesUntilNextGrain = 42;
+  REQUIRE(voices.noteOn(64, 0.5f, 2) == first);
+  REQUIRE(voices.getVoice(first).noteNumber == 64);
+  REQUIRE(voices.getVoice(first).samplesUntilNextGrain == 42);
+  REQUIRE(voices.noteOff(60) == -1);
+
+  // A released voice still sounding is stolen before any held one.
+  voices.grainStarted(second);
+  REQUIRE(voices.noteOff(62) == second);
+  REQUIRE(voices.noteOn(65, 1.0f, 2) == second);
+  REQUIRE(voices.getVoice(second).isHeld);
+  REQUIRE(voices.getNumActiveVoices() == 2);
+
+  // With a limit of one, every note retargets the same stream.
+  voices.reset(100, 10.0f);
+  REQUIRE(voices.noteOn(60, 1.0f, 1) == 0);
+  REQUIRE(voices.noteOn(72, 1.0f, 1) == 0);
+  REQUIRE(voices.getNumActiveVoices() == 1);
+}
+
+TEST_CASE("ChordsLayerOneCloudPerNote", "[VoiceAllocatorTest]") {
+  auto snapshots = std::make_unique<GrainSnapshotBuffer>();
+  snapshots->setEnabled(true);
+  AudioEngine engine;
+  engine.setGrainSnapshots(snapshots.get());
+  engine.setRandomSeed(3);
+  auto* model = engine.getStochasticModel();
+  model->setPitchAndDispersion(60.0f, 0.0f);
+  model->setGlobalDensity(400.0f);
+  model->setGlobalNumVoices(3);
+  engine.prepareToPlay(48000.0, 480);
+
+  juce::AudioBuffer<float> buffer(2, 480);
+  juce::MidiBuffer midi;
+  juce::AudioPlayHead::PositionInfo pos;
+  for (int note : {40, 80, 100})
+    midi.addEvent(juce::MidiMessage::noteOn(1, note, 1.0f), 0);
+  engine.processBlock(buffer, midi, pos);
+  midi.clear();
+  int numBlocks = 0;
+  REQUIRE_REALTIME_SAFE({
+    for (; numBlocks < 10; ++numBlocks)
+      engine.processBlock(buffer, midi, pos);
+  });
+  REQUIRE(engine.getNumActiveVoices() == 3);
+
+  // Every note's voice spawns at the full density, at its own pitch.
+  const auto* snapshot = snapshots->acquire();
+  REQUIRE(snapshot != nullptr);
+  std::array<int, 3> counts{};
+  for (int i = 0; i < snapshot->numGrains; ++i) {
+    const float pitch = snapshot->grains[static_cast<size_t>(i)].pitch;
+    REQUIRE((pitch == 40.0f || pitch == 80.0f || pitch == 100.0f));
+    ++counts[pitch < 60.0f ? 0u : pitch < 90.0f ? 1u : 2u];
+  }
+  REQUIRE(*std::min_element(counts.begin(), counts.end()) > 0);
+
+  // Releasing two notes culls their voices once their grains are gone.
+  midi.addEvent(juce::MidiMessage::noteOff(1, 40), 0);
+  midi.addEvent(juce::MidiMessage::noteOff(1, 80), 0);
+  engine.processBlock(buffer, midi, pos);
+  midi.clear();
+  for (int block = 0; block < 40; ++block)
+    engine.processBlock(buffer, midi, pos);
+  REQUIRE(engine.getNumActiveVoices() == 1);
+}